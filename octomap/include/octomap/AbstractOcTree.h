@@ -108,6 +108,16 @@ namespace octomap {
     /// Write file header and complete tree to stream (serialization)
     bool write(std::ostream& s) const;
 
+    /**
+     * Write file header and complete tree to file like write(), but with the
+     * node payloads in bulk: the tree structure first, then the payloads of all
+     * nodes as contiguous arrays (see writeDataBulk()). Much faster to read and
+     * write for node types with several data members. read() detects these files.
+     */
+    bool writeBulk(const std::string& filename) const;
+    /// Write file header and complete tree to stream with bulk node payloads, see writeBulk()
+    bool writeBulk(std::ostream& s) const;
+
     /**
      * Creates a certain OcTree (factory pattern)
      *
@@ -144,15 +154,27 @@ namespace octomap {
     /// Write complete state of tree to stream (without file header) unmodified.
     /// Pruning the tree first produces smaller files (lossless compression)
     virtual std::ostream& writeData(std::ostream &s) const = 0;
+
+    /// Read all nodes as written by writeDataBulk() (without file header),
+    /// the tree needs to be already created.
+    virtual std::istream& readDataBulk(std::istream &s) = 0;
+
+    /// Write complete state of tree to stream (without file header) with the tree
+    /// structure first, followed by the node payloads as contiguous arrays
+    virtual std::ostream& writeDataBulk(std::ostream &s) const = 0;
   private:
     /// create private store, Construct on first use
     static std::map<std::string, AbstractOcTree*>& classIDMapping();
 
-  protected:
+  public:
+    /// Reads the keywords of a file header (after its first line) up to and including the "data" line
     static bool readHeader(std::istream &s, std::string& id, unsigned& size, double& res);
+
+  protected:
     static void registerTreeType(AbstractOcTree* tree);
 
     static const std::string fileHeader;
+    static const std::string bulkFileHeader;
   };
 
 
@@ -40,6 +40,9 @@
 #include "OcTreeKey.h"
 #include <cassert>
 #include <fstream>
+#if __cplusplus >= 201103L
+#include <future>
+#endif
 
 
 namespace octomap {
@@ -90,24 +93,154 @@ namespace octomap {
 
     /// Writes the actual data, implemented in OccupancyOcTreeBase::writeBinaryData()
     virtual std::ostream& writeBinaryData(std::ostream &s) const = 0;
+
+#if __cplusplus >= 201103L
+    /**
+     * Writes OcTree to a binary file like writeBinary(), but on a background thread.
+     * Before returning, only a snapshot of the maximum likelihood tree is encoded in
+     * memory (see writeBinarySnapshotData()), so the tree can be changed again right
+     * away, e.g., by insertPointCloud(). Unlike writeBinary(), the tree itself is not
+     * converted or pruned.
+     * @return future for the success of the operation
+     */
+    std::future<bool> writeBinaryAsync(const std::string& filename) const;
+#endif
+
+    /**
+     * Encodes the data of writeBinary() into memory without changing the tree,
+     * implemented in OccupancyOcTreeBase::writeBinarySnapshotData().
+     * @return number of nodes in the encoded (pruned) tree
+     */
+    virtual size_t writeBinarySnapshotData(std::string& data) const = 0;
     
     /**
-     * Reads an OcTree from an input stream.
+     * Reads an OcTree from an input stream. Compressed binary data (see
+     * writeBinaryCompressedConst()) is detected from the header.
      * Existing nodes of the tree are deleted before the tree is read.
      * @return success of operation
      */
     bool readBinary(std::istream &s);
     
     /**
-     * Reads OcTree from a binary file.
+     * Reads OcTree from a binary file. The file is memory-mapped and parsed
+     * directly from memory (see MemoryMappedFile). Files which cannot be
+     * mapped (e.g. pipes) are read with readBinary(std::istream&).
      * Existing nodes of the tree are deleted before the tree is read.
      * @return success of operation
      */
     bool readBinary(const std::string& filename);
 
+    /**
+     * Reads an OcTree from the contents of a binary file in memory, e.g.,
+     * a MemoryMappedFile. Existing nodes of the tree are deleted before
+     * the tree is read.
+     * @return success of operation
+     */
+    bool readBinary(const char* data, size_t size);
+
     /// Reads the actual data, implemented in OccupancyOcTreeBase::readBinaryData()
     virtual std::istream& readBinaryData(std::istream &s) = 0;
 
+    /// Reads the actual data from memory, implemented in OccupancyOcTreeBase::readBinaryData()
+    /// @return number of bytes read
+    virtual size_t readBinaryData(const char* data, size_t size) = 0;
+
+    /**
+     * Writes OcTree to a compressed binary file using writeBinaryCompressedConst().
+     * The OcTree is first converted to the maximum likelihood estimate and pruned.
+     * @return success of operation
+     */
+    bool writeBinaryCompressed(const std::string& filename);
+
+    /**
+     * Writes the maximum likelihood OcTree to a binary stream like writeBinaryConst(),
+     * but with the tree structure coded with a static prefix code (about 1.8-2.5x
+     * smaller). The result is read by readBinary() like an uncompressed binary
+     * file and about as fast: the decoder needs one table lookup per inner node,
+     * and with OpenMP the eight subtrees of the root are decoded in parallel.
+     * @return success of operation
+     */
+    bool writeBinaryCompressedConst(std::ostream &s) const;
+
+    /// Writes the actual data, implemented in OccupancyOcTreeBase::writeBinaryCompressedData()
+    virtual std::ostream& writeBinaryCompressedData(std::ostream &s) const = 0;
+
+    /// Reads the actual data, implemented in OccupancyOcTreeBase::readBinaryCompressedData()
+    /// @return number of bytes read
+    virtual size_t readBinaryCompressedData(const char* data, size_t size) = 0;
+
+    /**
+     * Writes the maximum likelihood state of all subtrees which changed since the
+     * last resetChangeDetection() to a delta file, which applyDelta() applies to a copy
+     * of the tree (e.g., read from a previous checkpoint). Change detection needs to be
+     * enabled (see OccupancyOcTreeBase::enableChangeDetection()), it covers the changes
+     * by updateNode() and setNodeValue() but not deleted nodes. Call resetChangeDetection()
+     * after writing to start the next delta.
+     * @param patch_depth depth of the subtrees which are written as a whole
+     * @return success of operation
+     */
+    bool writeBinaryDelta(const std::string& filename, unsigned int patch_depth = 12) const;
+
+    /// Writes a delta to a binary stream, see writeBinaryDelta(const std::string&, unsigned int)
+    bool writeBinaryDelta(std::ostream &s, unsigned int patch_depth = 12) const;
+
+    /**
+     * Applies a delta file written by writeBinaryDelta(): the changed subtrees
+     * replace the ones of this tree.
+     * @return success of operation
+     */
+    bool applyDelta(const std::string& filename);
+
+    /// Applies a delta from a binary stream, see applyDelta(const std::string&)
+    bool applyDelta(std::istream &s);
+
+    /// Writes the actual data, implemented in OccupancyOcTreeBase::writeBinaryDeltaData()
+    virtual std::ostream& writeBinaryDeltaData(std::ostream &s, unsigned int patch_depth) const = 0;
+
+    /// Applies the actual data, implemented in OccupancyOcTreeBase::readBinaryDeltaData()
+    virtual bool readBinaryDeltaData(std::istream &s) = 0;
+
+    /**
+     * Writes OcTree to a chunked binary file (.cbt) using writeBinaryChunkedConst().
+     * The OcTree is first converted to the maximum likelihood estimate and pruned.
+     * @return success of operation
+     */
+    bool writeBinaryChunked(const std::string& filename, unsigned int chunk_depth = 6);
+
+    /**
+     * Writes the maximum likelihood OcTree to a chunked binary file (.cbt).
+     * Like a .bt file, but the subtrees at chunk_depth are stored as separate
+     * chunks listed in an index (offset, size and bounding box), so that they
+     * can be written and read in parallel and regions can be read on their own
+     * with readRegion(). The OcTree is not changed.
+     * @return success of operation
+     */
+    bool writeBinaryChunkedConst(const std::string& filename, unsigned int chunk_depth = 6) const;
+
+    /**
+     * Reads OcTree from a chunked binary file (.cbt), see writeBinaryChunkedConst().
+     * Existing nodes of the tree are deleted before the tree is read.
+     * @return success of operation
+     */
+    bool readBinaryChunked(const std::string& filename);
+
+    /**
+     * Reads only the chunks of a chunked binary file (.cbt) which overlap the
+     * bounding box between min and max. Nodes outside of the box may be
+     * included as far as they belong to the same chunks.
+     * Existing nodes of the tree are deleted before the tree is read.
+     * @return success of operation
+     */
+    bool readRegion(const std::string& filename, const point3d& min, const point3d& max);
+
+    /// Writes the actual data, implemented in OccupancyOcTreeBase::writeBinaryChunkedData()
+    virtual std::ostream& writeBinaryChunkedData(std::ostream &s, unsigned int chunk_depth) const = 0;
+
+    /// Reads the actual data, implemented in OccupancyOcTreeBase::readBinaryChunkedData()
+    /// @return number of bytes read
+    virtual size_t readBinaryChunkedData(const char* data, size_t size, bool use_bbx,
+                                         const point3d& min, const point3d& max) = 0;
+
     // -- occupancy queries
 
     /// queries whether a node is occupied according to the tree's parameter for "occupancy"
@@ -218,12 +351,23 @@ namespace octomap {
     /// @return maximum threshold for occupancy clamping in the sensor model (logodds)
     float getClampingThresMaxLog() const {return clamping_thres_max; }
 
-
+    /// first line of binary files (.bt)
+    static const std::string binaryFileHeader;
+    /// first line of compressed binary files
+    static const std::string compressedFileHeader;
+    /// first line of delta files
+    static const std::string deltaFileHeader;
+    /// first line of chunked binary files (.cbt)
+    static const std::string chunkedFileHeader;
 
 
   protected:
     /// Try to read the old binary format for conversion, will be removed in the future
     bool readBinaryLegacyHeader(std::istream &s, unsigned int& size, double& res);
+
+    /// Reads a chunked binary file, only the chunks overlapping min..max if use_bbx is set
+    bool readBinaryChunkedFile(const std::string& filename, bool use_bbx,
+                               const point3d& min, const point3d& max);
     
     // occupancy parameters of tree, stored in logodds:
     float clamping_thres_min;
@@ -231,8 +375,6 @@ namespace octomap {
     float prob_hit_log;
     float prob_miss_log;
     float occ_prob_thres_log;
-
-    static const std::string binaryFileHeader;
   };
 
 }; // end namespace
@@ -0,0 +1,188 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCTOMAP_AGGREGATE_OCTREE_H
+#define OCTOMAP_AGGREGATE_OCTREE_H
+
+
+#include <octomap/OcTreeNode.h>
+#include <octomap/OccupancyOcTreeBase.h>
+
+namespace octomap {
+
+  // forward declaraton for "friend"
+  class AggregateOcTree;
+
+  /**
+   * Node of an AggregateOcTree. Inner nodes additionally store the number of
+   * occupied and free voxels (at the finest resolution) in their subtree.
+   * The counts of leafs are not used, they follow from the leaf's depth and
+   * occupancy. They are kept in one block with the array of child pointers,
+   * so that leafs have the size of an OcTreeNode.
+   */
+  class AggregateOcTreeNode : public OcTreeNode {
+  public:
+    friend class AggregateOcTree; // needs access to node children (inherited)
+    template<typename NODE, typename I>
+    friend class OcTreeBaseImpl; // allocates the children arrays
+
+    AggregateOcTreeNode() : OcTreeNode() {}
+
+    AggregateOcTreeNode(const AggregateOcTreeNode& rhs) : OcTreeNode(rhs) {}
+
+    /// @return number of occupied voxels in the subtree of this inner node (in memory), 0 for leafs
+    inline uint64_t getNumOccupied() const { return children ? counts()->num_occupied : 0; }
+    /// @return number of free voxels in the subtree of this inner node (in memory), 0 for leafs
+    inline uint64_t getNumFree() const { return children ? counts()->num_free : 0; }
+
+  protected:
+    /// array of child pointers of an inner node, followed by the counts of the node
+    struct ChildrenArray {
+      AbstractOcTreeNode* children[8];
+      uint64_t num_occupied;
+      uint64_t num_free;
+    };
+
+    static AbstractOcTreeNode** newChildrenArray();
+    static void deleteChildrenArray(AbstractOcTreeNode** children);
+    static size_t childrenArraySize() { return sizeof(ChildrenArray); }
+
+    inline ChildrenArray* counts() { return reinterpret_cast<ChildrenArray*>(children); }
+    inline const ChildrenArray* counts() const { return reinterpret_cast<const ChildrenArray*>(children); }
+  };
+
+
+  /**
+   * Occupancy octree which keeps per-node counts of occupied and free voxels,
+   * so that the occupied, free and unknown volume inside a bounding box can be
+   * computed by descending only along the boundary of the box (see countInBBX()).
+   *
+   * The counts are updated on the path of every non-lazy updateNode(),
+   * setNodeValue() and deleteNode(), and for the whole tree by expand() and
+   * by updateAggregateData(), which is called after reading a tree,
+   * updateInnerOccupancy(), deleteAABB() and setAABB().
+   * Nodes which are modified directly (e.g. with integrateHit()) require
+   * a call to updateInnerOccupancy() afterwards.
+   */
+  class AggregateOcTree : public OccupancyOcTreeBase <AggregateOcTreeNode> {
+
+  public:
+    /// Default constructor, sets resolution of leafs
+    AggregateOcTree(double resolution);
+
+    /// Copy constructor, recomputes the counts (which copyData() does not copy)
+    AggregateOcTree(const AggregateOcTree& rhs);
+
+    /// virtual constructor: creates a new object of same type
+    /// (Covariant return type requires an up-to-date compiler)
+    AggregateOcTree* create() const {return new AggregateOcTree(resolution); }
+
+    std::string getTreeType() const {return "AggregateOcTree";}
+
+    using OccupancyOcTreeBase<AggregateOcTreeNode>::updateNode;
+    using OccupancyOcTreeBase<AggregateOcTreeNode>::setNodeValue;
+
+    virtual AggregateOcTreeNode* updateNode(const OcTreeKey& key, float log_odds_update, bool lazy_eval = false);
+    virtual AggregateOcTreeNode* setNodeValue(const OcTreeKey& key, float log_odds_value, bool lazy_eval = false);
+
+    virtual void expand();
+
+    /**
+     * Counts the occupied, free and unknown voxels (at the finest resolution)
+     * between min and max (inclusive). Subtrees completely inside of the box
+     * are answered from their counts, so only the boundary of the box is
+     * traversed. Multiply by resolution^3 for the volume.
+     */
+    void countInBBX(const OcTreeKey& min, const OcTreeKey& max,
+                    uint64_t& num_occupied, uint64_t& num_free, uint64_t& num_unknown) const;
+
+    /**
+     * Counts the occupied, free and unknown voxels in the bounding box
+     * between min and max, see above.
+     * @return false if the box is not inside of the map
+     */
+    bool countInBBX(const point3d& min, const point3d& max,
+                    uint64_t& num_occupied, uint64_t& num_free, uint64_t& num_unknown) const;
+
+  protected:
+    /// recomputes the voxel counts of the whole tree
+    virtual void updateAggregateData();
+
+    /// recomputes the voxel counts on the path to key (after deleteNode())
+    virtual void updateAggregateDataOnPath(const OcTreeKey& key) { updateCountsOnPath(key); }
+
+    /// recomputes the voxel counts of a subtree read back from the page file
+    virtual void restorePagedSubtree(AggregateOcTreeNode* node);
+
+    /// sets the voxel counts of an inner node at depth from its children
+    void updateNodeCounts(AggregateOcTreeNode* node, unsigned int depth);
+
+    /// updates the voxel counts of all inner nodes on the path from the root to key, bottom up
+    void updateCountsOnPath(const OcTreeKey& key);
+
+    void updateCountsRecurs(AggregateOcTreeNode* node, unsigned int depth);
+
+    void countInBBXRecurs(const AggregateOcTreeNode* node, const OcTreeKey& key, unsigned int depth,
+                          const OcTreeKey& min, const OcTreeKey& max,
+                          uint64_t& num_occupied, uint64_t& num_free) const;
+
+    /**
+     * Static member object which ensures that this OcTree's prototype
+     * ends up in the classIDMapping only once. You need this as a
+     * static member in any derived octree class in order to read .ot
+     * files through the AbstractOcTree factory. You should also call
+     * ensureLinking() once from the constructor.
+     */
+    class StaticMemberInitializer{
+       public:
+         StaticMemberInitializer() {
+           AggregateOcTree* tree = new AggregateOcTree(0.1);
+           tree->clearKeyRays();
+           AbstractOcTree::registerTreeType(tree);
+         }
+
+         /**
+         * Dummy function to ensure that MSVC does not drop the
+         * StaticMemberInitializer, causing this tree failing to register.
+         * Needs to be called from the constructor of this octree.
+         */
+         void ensureLinking() {};
+    };
+    /// static member to ensure static initialization (only once)
+    static StaticMemberInitializer aggregateOcTreeMemberInit;
+
+  };
+
+} // end namespace
+
+#endif
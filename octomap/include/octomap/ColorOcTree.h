@@ -98,6 +98,19 @@ namespace octomap {
     // file I/O
     std::istream& readData(std::istream &s);
     std::ostream& writeData(std::ostream &s) const;
+
+    /// bulk file I/O: occupancy array followed by color array
+    template <class NODE>
+    static std::ostream& writeDataBulk(const std::vector<const NODE*>& nodes, std::ostream &s) {
+      OcTreeNode::writeDataBulk(nodes, s);
+      return writeBulkArray(nodes, &ColorOcTreeNode::color, s);
+    }
+
+    template <class NODE>
+    static std::istream& readDataBulk(const std::vector<NODE*>& nodes, std::istream &s) {
+      OcTreeNode::readDataBulk(nodes, s);
+      return readBulkArray(nodes, &ColorOcTreeNode::color, s);
+    }
     
   protected:
     Color color;
@@ -0,0 +1,112 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCTOMAP_FRONTIER_TRACKER_H
+#define OCTOMAP_FRONTIER_TRACKER_H
+
+#include <vector>
+#include <octomap/OcTreeKey.h>
+
+namespace octomap {
+
+  /**
+   * Keeps track of the frontier of an occupancy octree, i.e. all free voxels
+   * (at the finest resolution) that have an unknown neighbor, either in the
+   * 6- or 26-neighborhood.
+   *
+   * After an initial rebuild(), update() only re-evaluates the keys recorded by
+   * the tree's change detection (see OccupancyOcTreeBase::enableChangeDetection())
+   * and the frontier voxels next to them, so its cost depends on the size of the
+   * last updates and not on the size of the map. Changes that are not recorded
+   * by the change detection (e.g. deleteNode() or clear()) require a rebuild().
+   *
+   * \tparam TREE Occupancy octree class, e.g. OcTree or ColorOcTree
+   */
+  template <class TREE>
+  class FrontierTracker {
+  public:
+    /**
+     * @param tree Octree to track. Change detection is enabled on it.
+     * @param use26Neighborhood use the 26-neighborhood instead of the 6 face neighbors
+     */
+    FrontierTracker(TREE* tree, bool use26Neighborhood=false);
+
+    /// Recomputes the complete frontier by traversing all free leafs
+    void rebuild();
+
+    /**
+     * Updates the frontier from the keys changed since the last call. The changed keys
+     * are consumed here unless reset_changes is false, in which case you need to call
+     * tree->resetChangeDetection() yourself.
+     */
+    void update(bool reset_changes=true);
+
+    /// @return true if the voxel at key is a frontier voxel
+    bool isFrontier(const OcTreeKey& key) const { return frontiers.find(key) != frontiers.end(); }
+
+    /// @return keys of all frontier voxels (at the finest resolution)
+    const KeySet& getFrontiers() const { return frontiers; }
+
+    /// @return number of frontier voxels
+    size_t size() const { return frontiers.size(); }
+
+    /**
+     * Groups the frontier voxels into connected clusters (using the same neighborhood).
+     *
+     * @param[out] clusters keys of the frontier voxels of each cluster
+     * @param[in] min_cluster_size smaller clusters are discarded
+     */
+    void getClusters(std::vector<std::vector<OcTreeKey> >& clusters, size_t min_cluster_size=1) const;
+
+  protected:
+    /// @return true if key is a free voxel with an unknown neighbor
+    bool computeIsFrontier(const OcTreeKey& key) const;
+
+    /// @return key of neighbor i (see neighborOffsets), false if out of the tree bounds
+    bool getNeighborKey(const OcTreeKey& key, unsigned int i, OcTreeKey& neighbor) const;
+
+    /// updates membership of key in the frontier set
+    void updateKey(const OcTreeKey& key);
+
+    TREE* tree;
+    bool use26Neighborhood;
+    unsigned int numNeighbors;
+    int neighborOffsets[26][3];
+    KeySet frontiers;
+  };
+
+} // end namespace
+
+#include "octomap/FrontierTracker.hxx"
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+namespace octomap {
+
+  template <class TREE>
+  FrontierTracker<TREE>::FrontierTracker(TREE* tree, bool use26Neighborhood)
+    : tree(tree), use26Neighborhood(use26Neighborhood), numNeighbors(0)
+  {
+    // face neighbors first, they are sufficient for the 6-neighborhood
+    const int faces[6][3] = {{1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}};
+    for (unsigned int i = 0; i < 6; ++i, ++numNeighbors){
+      for (unsigned int j = 0; j < 3; ++j)
+        neighborOffsets[numNeighbors][j] = faces[i][j];
+    }
+    if (use26Neighborhood){
+      for (int dx = -1; dx <= 1; ++dx){
+        for (int dy = -1; dy <= 1; ++dy){
+          for (int dz = -1; dz <= 1; ++dz){
+            if (abs(dx) + abs(dy) + abs(dz) < 2)
+              continue;
+            neighborOffsets[numNeighbors][0] = dx;
+            neighborOffsets[numNeighbors][1] = dy;
+            neighborOffsets[numNeighbors][2] = dz;
+            ++numNeighbors;
+          }
+        }
+      }
+    }
+
+    tree->enableChangeDetection(true);
+  }
+
+  template <class TREE>
+  bool FrontierTracker<TREE>::getNeighborKey(const OcTreeKey& key, unsigned int i, OcTreeKey& neighbor) const {
+    for (unsigned int j = 0; j < 3; ++j){
+      int k = int(key[j]) + neighborOffsets[i][j];
+      if (k < 0 || k > 0xFFFF)
+        return false;
+      neighbor[j] = key_type(k);
+    }
+    return true;
+  }
+
+  template <class TREE>
+  bool FrontierTracker<TREE>::computeIsFrontier(const OcTreeKey& key) const {
+    typename TREE::NodeType* node = tree->search(key);
+    if (node == NULL || tree->isNodeOccupied(node))
+      return false;
+
+    OcTreeKey neighbor;
+    for (unsigned int i = 0; i < numNeighbors; ++i){
+      if (getNeighborKey(key, i, neighbor) && tree->search(neighbor) == NULL)
+        return true;
+    }
+    return false;
+  }
+
+  template <class TREE>
+  void FrontierTracker<TREE>::updateKey(const OcTreeKey& key) {
+    if (computeIsFrontier(key))
+      frontiers.insert(key);
+    else
+      frontiers.erase(key);
+  }
+
+  template <class TREE>
+  void FrontierTracker<TREE>::rebuild() {
+    frontiers.clear();
+    const unsigned int tree_depth = tree->getTreeDepth();
+    OcTreeKey key;
+    for (typename TREE::leaf_iterator it = tree->begin_leafs(), end = tree->end_leafs(); it != end; ++it){
+      if (tree->isNodeOccupied(*it))
+        continue;
+
+      if (it.getDepth() == tree_depth){
+        if (computeIsFrontier(it.getKey()))
+          frontiers.insert(it.getKey());
+        continue;
+      }
+
+      // larger free leaf: only voxels on its border can have unknown neighbors
+      const OcTreeKey& center = it.getKey();
+      const unsigned int half = 1u << (tree_depth - it.getDepth() - 1);
+      const unsigned int lo[3] = {center[0] - half, center[1] - half, center[2] - half};
+      const unsigned int hi[3] = {center[0] + half - 1, center[1] + half - 1, center[2] + half - 1};
+      for (unsigned int x = lo[0]; x <= hi[0]; ++x){
+        key[0] = key_type(x);
+        for (unsigned int y = lo[1]; y <= hi[1]; ++y){
+          key[1] = key_type(y);
+          const bool inside_xy = (x != lo[0] && x != hi[0] && y != lo[1] && y != hi[1]);
+          for (unsigned int z = lo[2]; z <= hi[2]; z = (inside_xy && z == lo[2]) ? hi[2] : z + 1){
+            key[2] = key_type(z);
+            if (computeIsFrontier(key))
+              frontiers.insert(key);
+          }
+        }
+      }
+    }
+  }
+
+  template <class TREE>
+  void FrontierTracker<TREE>::update(bool reset_changes) {
+    OcTreeKey neighbor;
+    for (KeyBoolMap::const_iterator it = tree->changedKeysBegin(), end = tree->changedKeysEnd(); it != end; ++it){
+      const OcTreeKey& key = it->first;
+      updateKey(key);
+
+      // a changed voxel is known now, which can only remove neighbors from the frontier
+      for (unsigned int i = 0; i < numNeighbors; ++i){
+        if (getNeighborKey(key, i, neighbor) && isFrontier(neighbor))
+          updateKey(neighbor);
+      }
+    }
+
+    if (reset_changes)
+      tree->resetChangeDetection();
+  }
+
+  template <class TREE>
+  void FrontierTracker<TREE>::getClusters(std::vector<std::vector<OcTreeKey> >& clusters,
+                                          size_t min_cluster_size) const {
+    clusters.clear();
+    KeySet visited;
+    std::vector<OcTreeKey> open;
+    OcTreeKey neighbor;
+    for (KeySet::const_iterator it = frontiers.begin(), end = frontiers.end(); it != end; ++it){
+      if (!visited.insert(*it).second)
+        continue;
+
+      // flood fill over frontier voxels:
+      std::vector<OcTreeKey> cluster;
+      open.push_back(*it);
+      while (!open.empty()){
+        OcTreeKey key = open.back();
+        open.pop_back();
+        cluster.push_back(key);
+        for (unsigned int i = 0; i < numNeighbors; ++i){
+          if (getNeighborKey(key, i, neighbor) && isFrontier(neighbor) && visited.insert(neighbor).second)
+            open.push_back(neighbor);
+        }
+      }
+
+      if (cluster.size() >= min_cluster_size)
+        clusters.push_back(cluster);
+    }
+  }
+
+} // namespace
@@ -0,0 +1,162 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCTOMAP_FROZEN_OCTREE_H
+#define OCTOMAP_FROZEN_OCTREE_H
+
+#include <string>
+#include <vector>
+#include <octomap/octomap_types.h>
+#include <octomap/OcTreeKey.h>
+#include <octomap/MemoryMappedFile.h>
+
+namespace octomap {
+
+  /**
+   * Read-only octree with the maximum likelihood occupancy of a binary tree
+   * (.bt), stored as a flat array of inner nodes. Each inner node holds the
+   * 2-bit child codes of the binary format and the index of its first inner
+   * child (the inner children of a node are consecutive), so a query is a
+   * single descent without any pointers.
+   *
+   * A FrozenOcTree is either built from a .bt file in one linear pass over the
+   * memory-mapped file (readBinary()), or opened from a file written with
+   * write(). The latter maps the node array and uses it directly, without
+   * any deserialization. Leafs of the binary format are not stored as nodes.
+   */
+  class FrozenOcTree {
+  public:
+    /// inner node, 8 bytes in memory and in files (host byte order, see write())
+    struct Node {
+      /// index of the first inner child, the inner children follow consecutively
+      uint32_t first_child;
+      /// 2 bits per child as in .bt files: 0 unknown, 1 free leaf, 2 occupied leaf, 3 inner node
+      uint16_t child_codes;
+      /// summary of the subtree, see Flags
+      uint16_t flags;
+    };
+
+    /// summary flags of an inner node
+    enum Flags {
+      HAS_OCCUPIED = 1, ///< an occupied leaf is below the node
+      HAS_UNKNOWN = 2   ///< unknown space is below the node
+    };
+
+    /// result of a query
+    enum State {
+      UNKNOWN = 0,
+      FREE = 1,
+      OCCUPIED = 2
+    };
+
+    FrozenOcTree();
+
+    /**
+     * Builds the tree from a binary OcTree file (.bt, see
+     * AbstractOccupancyOcTree::writeBinary()), which is memory-mapped.
+     * @return success of operation
+     */
+    bool readBinary(const std::string& filename);
+
+    /// builds the tree from the contents of a binary OcTree file in memory
+    bool readBinary(const char* data, size_t size);
+
+    /**
+     * Opens a file written by write(). The node array is used directly
+     * from the memory-mapped file.
+     * @return success of operation, false also for files written on a
+     * machine with a different byte order
+     */
+    bool read(const std::string& filename);
+
+    /**
+     * Writes the tree to a file for read(). The nodes are written in the
+     * byte order of this machine, which is recorded by a byteOrderMark
+     * in front of the node array.
+     */
+    bool write(const std::string& filename) const;
+
+    /// empties the tree (and unmaps a file)
+    void clear();
+
+    /**
+     * Searches the node at key and depth (0: finest level) or the leaf above it.
+     * An inner node is OCCUPIED if an occupied leaf is below it (as the maximum
+     * occupancy of OccupancyOcTreeBase), FREE otherwise.
+     */
+    State search(const OcTreeKey& key, unsigned int depth = 0) const;
+    /// searches the node at coordinate and depth, see search(const OcTreeKey&, unsigned int)
+    State search(const point3d& coord, unsigned int depth = 0) const;
+
+    /// converts a coordinate into a key (at the finest level), @return false if out of range
+    bool coordToKeyChecked(const point3d& coord, OcTreeKey& key) const;
+
+    double getResolution() const { return resolution; }
+    unsigned int getTreeDepth() const { return tree_depth; }
+    /// type of the tree the data was created from
+    const std::string& getTreeType() const { return tree_type; }
+    /// number of nodes of the original tree (inner nodes and leafs)
+    size_t size() const { return tree_size; }
+    /// number of stored (inner) nodes
+    size_t getNumInnerNodes() const { return num_nodes; }
+    /// @return true if the node array is used from a mapped file
+    bool isMapped() const { return file.isOpen(); }
+    /// memory of the node array in bytes (mapped or allocated)
+    size_t memoryUsage() const { return num_nodes * sizeof(Node); }
+
+    static const std::string binaryFileHeader;
+    /// first_child of the Node written in front of the node array by write()
+    static const uint32_t byteOrderMark = 0x01020304;
+
+  protected:
+    /// parses the binary stream of the inner node at index, @return false if data ends too early
+    bool buildRecurs(const char*& data, const char* end, size_t index, unsigned int depth);
+
+    /// points to built_nodes or into the mapped file
+    const Node* nodes;
+    size_t num_nodes;
+    std::vector<Node> built_nodes;
+    MemoryMappedFile file;
+
+    double resolution;
+    double resolution_factor;
+    size_t tree_size;
+    std::string tree_type;
+
+    static const unsigned int tree_depth = 16;
+    static const unsigned int tree_max_val = 32768;
+  };
+
+} // namespace
+
+#endif
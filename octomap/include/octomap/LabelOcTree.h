@@ -173,6 +173,19 @@ public:
     // file I/O
     std::istream& readData(std::istream &s);
     std::ostream& writeData(std::ostream &s) const;
+
+    /// bulk file I/O: occupancy array followed by label array
+    template <class NODE>
+    static std::ostream& writeDataBulk(const std::vector<const NODE*>& nodes, std::ostream &s) {
+        OcTreeNode::writeDataBulk(nodes, s);
+        return writeBulkArray(nodes, &LabelOcTreeNode::label, s);
+    }
+
+    template <class NODE>
+    static std::istream& readDataBulk(const std::vector<NODE*>& nodes, std::istream &s) {
+        OcTreeNode::readDataBulk(nodes, s);
+        return readBulkArray(nodes, &LabelOcTreeNode::label, s);
+    }
 protected:
     Label label;
 
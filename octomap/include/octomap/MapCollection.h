@@ -36,11 +36,28 @@
 
 
 #include <vector>
+#include <list>
+#include <map>
 #include <octomap/MapNode.h>
 
 namespace octomap {
 
   
+  /**
+   * A collection of maps (MapNode) with poses, e.g. submaps of a large area.
+   *
+   * Maps of a collection file are read lazily on the first query that needs
+   * them. Point queries only consider the nodes whose bounding box contains
+   * the point, found with a uniform grid over the node bounding boxes. The
+   * boxes come from the #MAPNODEBBX entries of the collection file (written by
+   * write() as comments, which older readers skip), otherwise the maps are read
+   * once to compute them. With a memory budget, the least recently used maps
+   * read from files are unloaded again.
+   *
+   * All queries, including the const ones, may build the index, read or unload
+   * maps and reorder the LRU list without any locking: a MapCollection must not
+   * be used by several threads at the same time.
+   */
   template <class MAPNODE>
   class MapCollection {
   public:
@@ -53,17 +70,34 @@ namespace octomap {
     bool removeNode(const MAPNODE* n);
     MAPNODE* queryNode(const point3d& p);
 
+    /// not thread-safe: may read or unload maps, see class description
     bool isOccupied(const point3d& p) const;
     bool isOccupied(float x, float y, float z) const;
 
     double getOccupancy(const point3d& p);
 
+    /// not thread-safe: may read or unload maps, see class description
     bool castRay(const point3d& origin, const point3d& direction, point3d& end,
                  bool ignoreUnknownCells=false, double maxRange=-1.0) const;
 
     bool writePointcloud(std::string filename);
     bool write(std::string filename);
 
+    /**
+     * Limits the memory of the maps loaded from files by queries. When it is
+     * exceeded, the least recently used maps are unloaded (they are read again
+     * when needed). 0 (default) means no limit.
+     *
+     * Maps handed out by MapNode::getMap() are not unloaded, as they may be
+     * modified (and the budget can be exceeded by them); call
+     * MapNode::unloadMap() to release them. Pointers returned by
+     * MapNode::getMapConst() are invalidated by any later query.
+     */
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const { return memory_budget; }
+    /// @return memory of the maps loaded by queries, as measured when they were loaded
+    size_t getLoadedMemory() const { return loaded_memory; }
+
     // TODO
     void insertScan(const Pointcloud& scan, const octomap::point3d& sensor_origin,
                     double maxrange=-1., bool pruning=true, bool lazy_eval = false);
@@ -90,10 +124,48 @@ namespace octomap {
     static void splitPathAndFilename(std::string &filenamefullpath, std::string* path, std::string *filename);
     static std::string combinePathAndFilename(std::string path, std::string filename);
     static bool readTagValue(std::string tag, std::ifstream &infile, std::string* value);
+    /// reads the next non-comment line as tag and value, @return false at the end of the file
+    static bool readTagLine(std::ifstream &infile, std::string* tag, std::string* value);
+
+    /// cell of the uniform grid of the spatial index
+    struct GridCell {
+      int x, y, z;
+      bool operator<(const GridCell& other) const {
+        if (x != other.x) return x < other.x;
+        if (y != other.y) return y < other.y;
+        return z < other.z;
+      }
+    };
+
+    /// (re)builds the grid over the global bounding boxes of all nodes
+    void buildIndex() const;
+    /// @return the nodes whose bounding box contains p (global frame), in collection order
+    void queryCandidates(const point3d& p, std::vector<MAPNODE*>& candidates) const;
+    /// @return the nodes whose bounding box is hit by the ray, in collection order
+    void rayCandidates(const point3d& origin, const point3d& direction, double maxRange,
+                       std::vector<MAPNODE*>& candidates) const;
+    /// @return map of node (read if needed), marks it as most recently used
+    const typename MAPNODE::TreeType* useMap(MAPNODE* node) const;
+    /// unloads least recently used maps except keep until the memory budget is met
+    void enforceMemoryBudget(const MAPNODE* keep) const;
     
   protected:
 
     std::vector<MAPNODE*> nodes;
+
+    // spatial index, built on first use
+    mutable bool index_valid;
+    mutable double grid_cell_size;
+    mutable std::map<GridCell, std::vector<size_t> > grid; ///< node indices per cell
+    mutable std::vector<size_t> large_nodes; ///< nodes spanning too many cells, always checked
+    mutable std::vector<point3d> node_bbx_min, node_bbx_max; ///< global bounding boxes
+    mutable std::vector<bool> node_bbx_valid;
+
+    // loaded maps, most recently used first, with their memory usage
+    size_t memory_budget;
+    mutable size_t loaded_memory;
+    mutable std::list<MAPNODE*> lru_maps;
+    mutable std::map<const MAPNODE*, std::pair<typename std::list<MAPNODE*>::iterator, size_t> > lru_entries;
   };
 
 } // end namespace
@@ -34,15 +34,20 @@
 #include <stdio.h>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace octomap {
   
   template <class MAPNODE>
-  MapCollection<MAPNODE>::MapCollection() {
+  MapCollection<MAPNODE>::MapCollection()
+    : index_valid(false), grid_cell_size(1.0), memory_budget(0), loaded_memory(0) {
   }
 
   template <class MAPNODE>
-  MapCollection<MAPNODE>::MapCollection(std::string filename) {
+  MapCollection<MAPNODE>::MapCollection(std::string filename)
+    : index_valid(false), grid_cell_size(1.0), memory_budget(0), loaded_memory(0) {
     this->read(filename);
   }
 
@@ -58,6 +63,10 @@ namespace octomap {
     // for(typename std::vector<MAPNODE*>::iterator it= nodes.begin(); it != nodes.end(); ++it)
     //   delete *it;
     nodes.clear();
+    index_valid = false;
+    lru_maps.clear();
+    lru_entries.clear();
+    loaded_memory = 0;
   }
 
   template <class MAPNODE>
@@ -74,56 +83,72 @@ namespace octomap {
       return false;
     }
 
+    // each node is given by MAPNODEID, MAPNODEFILENAME and MAPNODEPOSE lines,
+    // optionally followed by a #MAPNODEBBX comment (bounding box in the node frame)
     bool ok = true;
-    while(ok){
-      std::string nodeID;
-      ok = readTagValue("MAPNODEID", infile, &nodeID);
-      if(!ok){
-        //do not throw error, you could be at the end of the file
-        break;
-      }
-
-      std::string mapNodeFilename;
-      ok = readTagValue("MAPNODEFILENAME", infile, &mapNodeFilename);
-      if(!ok){
-        OCTOMAP_ERROR_STR("Could not read MAPNODEFILENAME.");
-        break;
+    std::string tag, value;
+    std::string nodeID, mapNodeFilename;
+    MAPNODE* node = NULL;
+    while (ok && readTagLine(infile, &tag, &value)){
+      if (tag == "MAPNODEID"){
+        nodeID = value;
+        mapNodeFilename = "";
+        node = NULL;
       }
-
-      std::string poseStr;
-      ok = readTagValue("MAPNODEPOSE", infile, &poseStr);
-      std::istringstream poseStream(poseStr);
-      float x,y,z;
-      poseStream >> x >> y >> z;
-      double roll,pitch,yaw;
-      poseStream >> roll >> pitch >> yaw;
-      ok = ok && !poseStream.fail();
-      if(!ok){
-        OCTOMAP_ERROR_STR("Could not read MAPNODEPOSE.");
-        break;
+      else if (tag == "MAPNODEFILENAME"){
+        mapNodeFilename = value;
       }
-      octomap::pose6d origin(x, y, z, roll, pitch, yaw);
-
-      MAPNODE* node = new MAPNODE(combinePathAndFilename(path,mapNodeFilename), origin);
-      node->setId(nodeID);
-
-      if(!ok){
-        for(unsigned int i=0; i<nodes.size(); i++){
-          delete nodes[i];
+      else if (tag == "MAPNODEPOSE"){
+        if (mapNodeFilename.empty()){
+          OCTOMAP_ERROR_STR("Could not read MAPNODEFILENAME.");
+          ok = false;
+          break;
         }
-        infile.close();
-        return false;
-      } else {
+        std::istringstream poseStream(value);
+        float x,y,z;
+        poseStream >> x >> y >> z;
+        double roll,pitch,yaw;
+        poseStream >> roll >> pitch >> yaw;
+        if (poseStream.fail()){
+          OCTOMAP_ERROR_STR("Could not read MAPNODEPOSE.");
+          ok = false;
+          break;
+        }
+        octomap::pose6d origin(x, y, z, roll, pitch, yaw);
+
+        // the map is read on first use
+        node = new MAPNODE(combinePathAndFilename(path,mapNodeFilename), origin, true);
+        node->setId(nodeID);
         nodes.push_back(node);
+        mapNodeFilename = "";
+      }
+      else if (tag == "#MAPNODEBBX" && node){
+        std::istringstream bbxStream(value);
+        float minX, minY, minZ, maxX, maxY, maxZ;
+        bbxStream >> minX >> minY >> minZ >> maxX >> maxY >> maxZ;
+        if (bbxStream.fail())
+          OCTOMAP_WARNING_STR("Could not read MAPNODEBBX of node " << node->getId() << ", ignoring it.");
+        else
+          node->setBBX(point3d(minX, minY, minZ), point3d(maxX, maxY, maxZ));
+      }
+      else {
+        OCTOMAP_ERROR_STR("Unexpected " << tag << " in " << filenamefullpath);
+        ok = false;
       }
     }
+    if (ok && !mapNodeFilename.empty()){
+      OCTOMAP_ERROR_STR("Could not read MAPNODEPOSE.");
+      ok = false;
+    }
     infile.close();
-    return true;
+    index_valid = false;
+    return ok;
   }
 
   template <class MAPNODE>
   void MapCollection<MAPNODE>::addNode( MAPNODE* node){
     nodes.push_back(node);
+    index_valid = false;
   }
 
   template <class MAPNODE>
@@ -140,22 +165,30 @@ namespace octomap {
 
   template <class MAPNODE>
   MAPNODE* MapCollection<MAPNODE>::queryNode(const point3d& p) {
-    for (const_iterator it = this->begin(); it != this->end(); ++it) {
+    std::vector<MAPNODE*> candidates;
+    queryCandidates(p, candidates);
+    for (const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
       point3d ptrans = (*it)->getOrigin().inv().transform(p);
-      typename MAPNODE::TreeType::NodeType* n = (*it)->getMap()->search(ptrans);
+      const typename MAPNODE::TreeType* map = useMap(*it);
+      if (!map) continue; // unreadable map file, unknown
+      typename MAPNODE::TreeType::NodeType* n = map->search(ptrans);
       if (!n) continue;
-      if ((*it)->getMap()->isNodeOccupied(n)) return (*it);
+      if (map->isNodeOccupied(n)) return (*it);
     }
     return 0;
   }
 
   template <class MAPNODE>
   bool MapCollection<MAPNODE>::isOccupied(const point3d& p) const {
-    for (const_iterator it = this->begin(); it != this->end(); ++it) {
+    std::vector<MAPNODE*> candidates;
+    queryCandidates(p, candidates);
+    for (const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
       point3d ptrans = (*it)->getOrigin().inv().transform(p);
-      typename MAPNODE::TreeType::NodeType* n = (*it)->getMap()->search(ptrans);
+      const typename MAPNODE::TreeType* map = useMap(*it);
+      if (!map) continue; // unreadable map file, unknown
+      typename MAPNODE::TreeType::NodeType* n = map->search(ptrans);
       if (!n) continue;
-      if ((*it)->getMap()->isNodeOccupied(n)) return true;
+      if (map->isNodeOccupied(n)) return true;
     }
     return false;
   }
@@ -171,9 +204,13 @@ namespace octomap {
   double MapCollection<MAPNODE>::getOccupancy(const point3d& p) {
     double max_occ_val = 0;
     bool is_unknown = true;
-    for (const_iterator it = this->begin(); it != this->end(); ++it) {
+    std::vector<MAPNODE*> candidates;
+    queryCandidates(p, candidates);
+    for (const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
       point3d ptrans = (*it)->getOrigin().inv().transform(p);
-      typename MAPNODE::TreeType::NodeType* n = (*it)->getMap()->search(ptrans);
+      const typename MAPNODE::TreeType* map = useMap(*it);
+      if (!map) continue; // unreadable map file, unknown
+      typename MAPNODE::TreeType::NodeType* n = map->search(ptrans);
       if (n) {
         double occ = n->getOccupancy();
         if (occ > max_occ_val) max_occ_val = occ;
@@ -191,16 +228,19 @@ namespace octomap {
     bool hit_obstacle = false;
     double min_dist = 1e6;
     // SPEEDUP: use openMP to do raycasting in parallel
-    // SPEEDUP: use bounding boxes to determine submaps 
-    for (const_iterator it = this->begin(); it != this->end(); ++it) {
+    std::vector<MAPNODE*> candidates;
+    rayCandidates(origin, direction, maxRange, candidates);
+    for (const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
       point3d origin_trans = (*it)->getOrigin().inv().transform(origin);
       point3d direction_trans = (*it)->getOrigin().inv().rot().rotate(direction);
       printf("ray from %.2f,%.2f,%.2f in dir %.2f,%.2f,%.2f in node %s\n",
              origin_trans.x(), origin_trans.y(), origin_trans.z(),
              direction_trans.x(), direction_trans.y(), direction_trans.z(),
              (*it)->getId().c_str());
+      const typename MAPNODE::TreeType* map = useMap(*it);
+      if (!map) continue; // unreadable map file, unknown
       point3d temp_endpoint;
-      if ((*it)->getMap()->castRay(origin_trans, direction_trans, temp_endpoint, ignoreUnknownCells, maxRange)) {
+      if (map->castRay(origin_trans, direction_trans, temp_endpoint, ignoreUnknownCells, maxRange)) {
         printf("hit obstacle in node %s\n", (*it)->getId().c_str());
         double current_dist =  origin_trans.distance(temp_endpoint);
         if (current_dist < min_dist) {
@@ -218,6 +258,8 @@ namespace octomap {
   bool MapCollection<MAPNODE>::writePointcloud(std::string filename) {
     Pointcloud pc;
     for(typename std::vector<MAPNODE* >::iterator it = nodes.begin(); it != nodes.end(); ++it){
+      if (!useMap(*it))
+        continue;
       Pointcloud tmp = (*it)->generatePointcloud();
       pc.push_back(tmp);
     }
@@ -244,7 +286,12 @@ namespace octomap {
       outfile << "MAPNODEFILENAME "<< nodemapFilename << "\n";
       outfile << "MAPNODEPOSE " << origin.x() << " " << origin.y() << " " << origin.z() << " "
               << origin.roll() << " " << origin.pitch() << " " << origin.yaw() << std::endl;
+      useMap(*it);
       ok = ok && (*it)->writeMap(nodemapFilename);
+      point3d bbx_min, bbx_max;
+      if ((*it)->getBBX(bbx_min, bbx_max))
+        outfile << "#MAPNODEBBX " << bbx_min.x() << " " << bbx_min.y() << " " << bbx_min.z() << " "
+                << bbx_max.x() << " " << bbx_max.y() << " " << bbx_max.z() << std::endl;
     }
     outfile.close();
     return ok;
@@ -280,6 +327,191 @@ namespace octomap {
     return 0;
   }
 
+  template <class MAPNODE>
+  void MapCollection<MAPNODE>::setMemoryBudget(size_t bytes) {
+    memory_budget = bytes;
+    enforceMemoryBudget(NULL);
+  }
+
+  template <class MAPNODE>
+  const typename MAPNODE::TreeType* MapCollection<MAPNODE>::useMap(MAPNODE* node) const {
+    const typename MAPNODE::TreeType* map = node->getMapConst();
+    // only maps read from files can be unloaded again
+    if (map == 0 || node->getFilename().empty())
+      return map;
+
+    typename std::map<const MAPNODE*, std::pair<typename std::list<MAPNODE*>::iterator, size_t> >::iterator
+      entry = lru_entries.find(node);
+    if (entry != lru_entries.end()) {
+      lru_maps.splice(lru_maps.begin(), lru_maps, entry->second.first);
+      return map;
+    }
+
+    lru_maps.push_front(node);
+    size_t memory = map->memoryUsage();
+    lru_entries[node] = std::make_pair(lru_maps.begin(), memory);
+    loaded_memory += memory;
+    enforceMemoryBudget(node);
+    return map;
+  }
+
+  template <class MAPNODE>
+  void MapCollection<MAPNODE>::enforceMemoryBudget(const MAPNODE* keep) const {
+    typename std::list<MAPNODE*>::iterator it = lru_maps.end();
+    while (memory_budget > 0 && loaded_memory > memory_budget && it != lru_maps.begin()) {
+      --it;
+      MAPNODE* victim = *it;
+      // maps handed out by getMap() may be modified or still used
+      if (victim == keep || victim->isMapInUse())
+        continue;
+      victim->unloadMap();
+      loaded_memory -= lru_entries[victim].second;
+      lru_entries.erase(victim);
+      it = lru_maps.erase(it);
+    }
+  }
+
+  template <class MAPNODE>
+  void MapCollection<MAPNODE>::buildIndex() const {
+    grid.clear();
+    large_nodes.clear();
+    node_bbx_min.assign(nodes.size(), point3d());
+    node_bbx_max.assign(nodes.size(), point3d());
+    node_bbx_valid.assign(nodes.size(), false);
+
+    // global bounding boxes of the nodes (maps are only read if they have no box yet)
+    double extent_sum = 0.0;
+    size_t num_valid = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (!nodes[i]->hasBBX())
+        useMap(nodes[i]);
+      point3d local_min, local_max;
+      if (!nodes[i]->getBBX(local_min, local_max))
+        continue;
+
+      pose6d origin = nodes[i]->getOrigin();
+      for (unsigned int c = 0; c < 8; ++c) {
+        point3d corner((c & 1) ? local_max.x() : local_min.x(),
+                       (c & 2) ? local_max.y() : local_min.y(),
+                       (c & 4) ? local_max.z() : local_min.z());
+        point3d global = origin.transform(corner);
+        for (unsigned int d = 0; d < 3; ++d) {
+          if (c == 0 || global(d) < node_bbx_min[i](d)) node_bbx_min[i](d) = global(d);
+          if (c == 0 || global(d) > node_bbx_max[i](d)) node_bbx_max[i](d) = global(d);
+        }
+      }
+      // margin against rounding at the borders
+      for (unsigned int d = 0; d < 3; ++d) {
+        node_bbx_min[i](d) -= 1e-3f;
+        node_bbx_max[i](d) += 1e-3f;
+      }
+      node_bbx_valid[i] = true;
+      point3d extent = node_bbx_max[i] - node_bbx_min[i];
+      extent_sum += std::max(extent.x(), std::max(extent.y(), extent.z()));
+      ++num_valid;
+    }
+
+    // cells of about the average node size
+    grid_cell_size = (num_valid > 0) ? std::max(extent_sum / num_valid, 1e-3) : 1.0;
+    const double max_cells = 4096;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (!node_bbx_valid[i])
+        continue;
+      int min_cell[3], max_cell[3];
+      double num_cells = 1.0;
+      for (unsigned int d = 0; d < 3; ++d) {
+        min_cell[d] = (int) std::floor(node_bbx_min[i](d) / grid_cell_size);
+        max_cell[d] = (int) std::floor(node_bbx_max[i](d) / grid_cell_size);
+        num_cells *= double(max_cell[d] - min_cell[d] + 1);
+      }
+      if (num_cells > max_cells) {
+        large_nodes.push_back(i);
+        continue;
+      }
+      GridCell cell;
+      for (cell.x = min_cell[0]; cell.x <= max_cell[0]; ++cell.x)
+        for (cell.y = min_cell[1]; cell.y <= max_cell[1]; ++cell.y)
+          for (cell.z = min_cell[2]; cell.z <= max_cell[2]; ++cell.z)
+            grid[cell].push_back(i);
+    }
+    index_valid = true;
+  }
+
+  template <class MAPNODE>
+  void MapCollection<MAPNODE>::queryCandidates(const point3d& p, std::vector<MAPNODE*>& candidates) const {
+    if (!index_valid)
+      buildIndex();
+
+    GridCell cell;
+    cell.x = (int) std::floor(p.x() / grid_cell_size);
+    cell.y = (int) std::floor(p.y() / grid_cell_size);
+    cell.z = (int) std::floor(p.z() / grid_cell_size);
+
+    std::vector<size_t> indices(large_nodes);
+    typename std::map<GridCell, std::vector<size_t> >::const_iterator it = grid.find(cell);
+    if (it != grid.end())
+      indices.insert(indices.end(), it->second.begin(), it->second.end());
+    std::sort(indices.begin(), indices.end());
+
+    candidates.clear();
+    for (size_t i = 0; i < indices.size(); ++i) {
+      size_t n = indices[i];
+      const point3d& min = node_bbx_min[n];
+      const point3d& max = node_bbx_max[n];
+      if (p.x() >= min.x() && p.x() <= max.x() && p.y() >= min.y() && p.y() <= max.y()
+          && p.z() >= min.z() && p.z() <= max.z())
+        candidates.push_back(nodes[n]);
+    }
+  }
+
+  template <class MAPNODE>
+  void MapCollection<MAPNODE>::rayCandidates(const point3d& origin, const point3d& direction, double maxRange,
+                                             std::vector<MAPNODE*>& candidates) const {
+    if (!index_valid)
+      buildIndex();
+
+    // slab test of the ray (up to maxRange) against each bounding box
+    point3d dir = direction.normalized();
+    candidates.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (!node_bbx_valid[i])
+        continue;
+      double t_min = 0.0;
+      double t_max = (maxRange > 0.0) ? maxRange : std::numeric_limits<double>::max();
+      bool hit = true;
+      for (unsigned int d = 0; d < 3 && hit; ++d) {
+        if (std::fabs(dir(d)) < 1e-9) {
+          hit = origin(d) >= node_bbx_min[i](d) && origin(d) <= node_bbx_max[i](d);
+        } else {
+          double t1 = (node_bbx_min[i](d) - origin(d)) / dir(d);
+          double t2 = (node_bbx_max[i](d) - origin(d)) / dir(d);
+          t_min = std::max(t_min, std::min(t1, t2));
+          t_max = std::min(t_max, std::max(t1, t2));
+          hit = t_min <= t_max;
+        }
+      }
+      if (hit)
+        candidates.push_back(nodes[i]);
+    }
+  }
+
+  template <class MAPNODE>
+  bool MapCollection<MAPNODE>::readTagLine(std::ifstream& infile, std::string* tag, std::string* value) {
+    std::string line;
+    while (getline(infile, line)) {
+      // #MAPNODEBBX is a comment for older readers, but a tag here
+      if (line.length() != 0 && (line[0] != '#' || line.compare(0, 12, "#MAPNODEBBX ") == 0))
+        break;
+    }
+    if (!infile && line.empty())
+      return false;
+
+    std::string::size_type firstSpace = line.find(' ');
+    *tag = line.substr(0, firstSpace);
+    *value = (firstSpace != std::string::npos) ? line.substr(firstSpace + 1) : "";
+    return !tag->empty();
+  }
+
   template <class MAPNODE>
   void MapCollection<MAPNODE>::splitPathAndFilename(std::string &filenamefullpath, 
                                                     std::string* path, std::string *filename) {
@@ -47,12 +47,51 @@ namespace octomap {
     MapNode();
     MapNode(TREETYPE* node_map, pose6d origin);
     MapNode(std::string filename, pose6d origin);
+    /// reads the map from filename on the first getMap() call if lazy is true
+    MapNode(std::string filename, pose6d origin, bool lazy);
     MapNode(const Pointcloud& cloud, pose6d origin);
     ~MapNode();
 
     typedef TREETYPE TreeType;
 
-    TREETYPE* getMap() { return  node_map; }
+    /**
+     * @return the map, read from its file first if the node is lazy or was unloaded
+     * (NULL if the file cannot be read). As the map may be modified through it,
+     * it stays in use until unloadMap() and is not unloaded by a MapCollection.
+     */
+    TREETYPE* getMap() {
+      map_in_use = true;
+      return loadMap();
+    }
+    /**
+     * Read-only access to the map, read from its file first if needed (NULL if
+     * the file cannot be read). The map is not marked in use: a MapCollection
+     * with a memory budget may unload it with any later query, which
+     * invalidates the pointer.
+     */
+    const TREETYPE* getMapConst() { return loadMap(); }
+    bool isMapLoaded() const { return node_map != 0; }
+    /// @return true if the map was handed out by getMap() since it was read
+    bool isMapInUse() const { return node_map != 0 && map_in_use; }
+    /**
+     * Deletes the map of a node that was read from a file, the next getMap()
+     * reads it again. Changes to the map are lost (see writeMap()), and pointers
+     * returned by getMap() become invalid.
+     * @return false if the node has no map file
+     */
+    bool unloadMap();
+    /// @return file the map is read from ("" if the map was given directly)
+    const std::string& getFilename() const { return filename; }
+
+    /**
+     * Bounding box of the known map in its local frame, as set by setBBX()
+     * (e.g. from a MapCollection file) or computed from the map (which is read if needed).
+     * @return false if the map is empty
+     */
+    bool getBBX(point3d& min, point3d& max);
+    void setBBX(const point3d& min, const point3d& max);
+    /// @return true if the bounding box is known without reading the map
+    bool hasBBX() const { return has_bbx; }
     
     void updateMap(const Pointcloud& cloud, point3d sensor_origin);
 
@@ -69,9 +108,18 @@ namespace octomap {
     TREETYPE*    node_map;  // occupancy grid map
     pose6d       origin;    // origin and orientation relative to parent
     std::string  id;
+    std::string  filename;  // map file for (re)reading node_map, may be empty
+    bool         has_bbx;
+    point3d      bbx_min, bbx_max; // bounding box of node_map in its local frame
+    bool         map_in_use; // node_map was handed out by getMap()
 
     void clear();
     bool readMap(std::string filename);
+    TREETYPE* loadMap() {
+      if (node_map == 0 && !filename.empty())
+        readMap(filename);
+      return node_map;
+    }
 
   };
 
@@ -34,23 +34,33 @@
 namespace octomap {
 
   template <class TREETYPE>
-  MapNode<TREETYPE>::MapNode(): node_map(0) {
+  MapNode<TREETYPE>::MapNode(): node_map(0), has_bbx(false), map_in_use(false) {
   }
 
   template <class TREETYPE>
-  MapNode<TREETYPE>::MapNode(TREETYPE* node_map, pose6d origin) {
+  MapNode<TREETYPE>::MapNode(TREETYPE* node_map, pose6d origin): has_bbx(false), map_in_use(false) {
   	this->node_map = node_map;
   	this->origin = origin;
   }
 
   template <class TREETYPE>
-  MapNode<TREETYPE>::MapNode(const Pointcloud& cloud, pose6d origin): node_map(0) {
+  MapNode<TREETYPE>::MapNode(const Pointcloud& cloud, pose6d origin): node_map(0), has_bbx(false), map_in_use(false) {
   }
 
   template <class TREETYPE>
-  MapNode<TREETYPE>::MapNode(std::string filename, pose6d origin): node_map(0){
+  MapNode<TREETYPE>::MapNode(std::string filename, pose6d origin): node_map(0), has_bbx(false), map_in_use(false){
   	readMap(filename);
   	this->origin = origin;
+  	this->filename = filename;
+  	id = filename;
+  }
+
+  template <class TREETYPE>
+  MapNode<TREETYPE>::MapNode(std::string filename, pose6d origin, bool lazy): node_map(0), has_bbx(false), map_in_use(false){
+  	if (!lazy)
+  		readMap(filename);
+  	this->origin = origin;
+  	this->filename = filename;
   	id = filename;
   }
 
@@ -63,11 +73,49 @@ namespace octomap {
   void MapNode<TREETYPE>::updateMap(const Pointcloud& cloud, point3d sensor_origin) {
   }
 
+  template <class TREETYPE>
+  bool MapNode<TREETYPE>::unloadMap() {
+    if (filename.empty())
+      return false;
+    delete node_map;
+    node_map = 0;
+    map_in_use = false;
+    return true;
+  }
+
+  template <class TREETYPE>
+  bool MapNode<TREETYPE>::getBBX(point3d& min, point3d& max) {
+    if (!has_bbx) {
+      TREETYPE* map = loadMap();
+      if (map == 0 || map->size() == 0)
+        return false;
+      double x, y, z;
+      map->getMetricMin(x, y, z);
+      bbx_min = point3d((float) x, (float) y, (float) z);
+      map->getMetricMax(x, y, z);
+      bbx_max = point3d((float) x, (float) y, (float) z);
+      has_bbx = true;
+    }
+    min = bbx_min;
+    max = bbx_max;
+    return true;
+  }
+
+  template <class TREETYPE>
+  void MapNode<TREETYPE>::setBBX(const point3d& min, const point3d& max) {
+    bbx_min = min;
+    bbx_max = max;
+    has_bbx = true;
+  }
+
   template <class TREETYPE>
   Pointcloud MapNode<TREETYPE>::generatePointcloud() {
     Pointcloud pc;
+    TREETYPE* map = loadMap();
+    if (map == 0)
+      return pc;
     point3d_list occs;
-    node_map->getOccupied(occs);
+    map->getOccupied(occs);
     for(point3d_list::iterator it = occs.begin(); it != occs.end(); ++it){
     	pc.push_back(*it);
     }
@@ -90,12 +138,19 @@ namespace octomap {
   		delete node_map;
 
     node_map = new TREETYPE(0.05);
-    return node_map->readBinary(filename);
+    if (!node_map->readBinary(filename)) {
+      OCTOMAP_ERROR_STR("Could not read map of node from " << filename);
+      delete node_map;
+      node_map = 0;
+      return false;
+    }
+    return true;
   }
 
   template <class TREETYPE>
   bool MapNode<TREETYPE>::writeMap(std::string filename){
-  	return node_map->writeBinary(filename);
+  	TREETYPE* map = loadMap();
+  	return map != 0 && map->writeBinary(filename);
   }
 
 } // namespace
@@ -0,0 +1,101 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCTOMAP_MEMORY_MAPPED_FILE_H
+#define OCTOMAP_MEMORY_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <streambuf>
+
+namespace octomap {
+
+  /**
+   * Read-only memory mapping of a complete file (mmap on POSIX systems,
+   * a file mapping on Windows). The pages are loaded by the OS on first
+   * access, so opening even large files is cheap.
+   */
+  class MemoryMappedFile {
+  public:
+    MemoryMappedFile();
+    ~MemoryMappedFile();
+
+    /// maps the file read-only, a previously opened file is closed first
+    /// @return false if the file cannot be opened or is empty (callers report the error)
+    bool open(const std::string& filename);
+    /// unmaps the file
+    void close();
+
+    bool isOpen() const { return file_data != NULL; }
+    /// @return first byte of the mapped file (NULL if not open)
+    const char* data() const { return file_data; }
+    /// @return size of the mapped file in bytes
+    size_t size() const { return file_size; }
+    /**
+     * Tells the OS that a range of the file is no longer needed, so that its
+     * pages are dropped from memory. They are read again on the next access.
+     * Only pages completely inside the range are released (no-op on Windows).
+     */
+    void release(const char* begin, size_t size);
+
+  private:
+    /// mapped files are not copyable
+    MemoryMappedFile(const MemoryMappedFile&);
+    MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+    const char* file_data;
+    size_t file_size;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+  };
+
+  /**
+   * Read-only stream buffer on a memory block (e.g. of a MemoryMappedFile),
+   * so that text parts such as file headers can be parsed with a std::istream
+   * without copying the data. Supports seeking, e.g. with tellg().
+   */
+  class MemoryStreamBuf : public std::streambuf {
+  public:
+    MemoryStreamBuf(const char* data, size_t size);
+
+  protected:
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which = std::ios_base::in);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+  };
+
+} // namespace
+
+#endif
@@ -40,6 +40,11 @@
 #include <iterator>
 #include <stack>
 #include <bitset>
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <string>
 
 #include "octomap_types.h"
 #include "OcTreeKey.h"
@@ -52,6 +57,38 @@ namespace octomap {
   class AbstractOcTreeNode;
 
 
+  /**
+   * Stack with a fixed capacity stored inside of the object, used by the
+   * tree iterators. Pushing and popping never allocates, and copying only
+   * copies the used elements. The capacity must not be exceeded (checked
+   * by assertion only).
+   */
+  template <class T, unsigned int CAPACITY>
+  class FixedStack {
+  public:
+    FixedStack() : num_elements(0) {}
+    FixedStack(const FixedStack& other) : num_elements(other.num_elements) {
+      std::copy(other.elements, other.elements + num_elements, elements);
+    }
+    FixedStack& operator=(const FixedStack& other) {
+      num_elements = other.num_elements;
+      std::copy(other.elements, other.elements + num_elements, elements);
+      return *this;
+    }
+
+    inline void push(const T& t) { assert(num_elements < CAPACITY); elements[num_elements++] = t; }
+    inline void pop() { assert(num_elements > 0); --num_elements; }
+    inline T& top() { assert(num_elements > 0); return elements[num_elements-1]; }
+    inline const T& top() const { assert(num_elements > 0); return elements[num_elements-1]; }
+    inline bool empty() const { return num_elements == 0; }
+    inline size_t size() const { return num_elements; }
+
+  protected:
+    unsigned int num_elements;
+    T elements[CAPACITY];
+  };
+
+
   /**
    * OcTree base class, to be used with with any kind of OcTreeDataNode.
    *
@@ -167,6 +204,12 @@ namespace octomap {
      * @return true if pruning was successful
      */
     virtual bool pruneNode(NODE* node);
+
+    /**
+     * Deletes all children of node with their complete subtrees,
+     * node becomes a leaf. The tree size is updated.
+     */
+    void deleteNodeChildren(NODE* node);
     
     
     // --------
@@ -227,20 +270,22 @@ namespace octomap {
      * Lossless compression of the octree: A node will replace all of its eight
      * children if they have identical values. You usually don't have to call
      * prune() after a regular occupancy update, updateNode() incrementally
-     * prunes all affected nodes.
+     * prunes all affected nodes. The tree is pruned bottom-up in a single pass,
+     * with OpenMP the subtrees at parallel_subtree_depth in parallel.
      */
     virtual void prune();
 
-    /// Expands all pruned nodes (reverse of prune())
+    /// Expands all pruned nodes (reverse of prune()), with OpenMP in parallel
     /// \note This is an expensive operation, especially when the tree is nearly empty!
     virtual void expand();
 
     // -- statistics  ----------------------
 
-    /// \return The number of nodes in the tree
-    virtual inline size_t size() const { return tree_size; }
+    /// \return The number of nodes in the tree (including paged out ones, see enablePaging())
+    virtual inline size_t size() const { return tree_size + paged_num_nodes; }
 
-    /// \return Memory usage of the complete octree in bytes (may vary between architectures)
+    /// \return Memory usage of the complete octree in bytes (may vary between architectures).
+    /// Only the nodes in memory are counted, not paged out subtrees (see enablePaging()).
     virtual size_t memoryUsage() const;
 
     /// \return Memory usage of a single octree node
@@ -272,9 +317,69 @@ namespace octomap {
     size_t getNumLeafNodes() const;
 
 
+    // -- out-of-core paging  ------------------
+
+    /**
+     * Enables paging of subtrees to disk. updatePaging() writes the subtrees
+     * below the nodes at page_depth to filename (created or truncated) and
+     * deletes them from memory, the nodes themselves stay with their own value.
+     * Whenever a paged out node is traversed (search, update, iterators etc.),
+     * its subtree is read back first, so the tree behaves as before apart from
+     * the latency. File output (write(), writeBinaryConst() etc.) and the copy
+     * constructor read paged out subtrees only temporarily, one at a time.
+     * size(), calcNumNodes() and getNumLeafNodes() count the paged out nodes,
+     * memoryUsage() only the nodes in memory.
+     *
+     * The nodes are stored with writePagedNode(), which trees with node data
+     * beyond writeData() (such as OcTreeStamped timestamps) extend.
+     * With OpenMP, reading subtrees back is thread-safe: a thread traversing a
+     * paged out node waits until its subtree was read completely, also when
+     * another thread reads it (e.g. in the parallel batch queries).
+     *
+     * @return false if the file could not be opened or page_depth is invalid
+     */
+    bool enablePaging(const std::string& filename, unsigned int page_depth = 8);
+
+    /// Reads all paged out subtrees back into memory and deletes the page file
+    void disablePaging();
+
+    inline bool isPagingEnabled() const { return paging_enabled; }
+
+    /**
+     * Pages out subtrees which were not accessed (by search() or an update)
+     * during the last max_idle calls of updatePaging(). 0 (default): no limit
+     */
+    void setPagingMaxIdle(unsigned int max_idle) { page_max_idle = max_idle; }
+
+    /**
+     * While memoryUsage() exceeds the budget in bytes, updatePaging() pages out
+     * the least recently accessed subtrees. 0 (default): no limit
+     */
+    void setPagingMemoryBudget(size_t bytes) { page_memory_budget = bytes; }
+
+    /**
+     * Starts a new access period and pages out subtrees according to
+     * setPagingMaxIdle() and setPagingMemoryBudget(). Called by
+     * OccupancyOcTreeBase::insertPointCloud() after each scan.
+     * @return number of subtrees paged out
+     */
+    size_t updatePaging();
+
+    /// Reads all paged out subtrees back into memory
+    void pageInAll() const;
+
+    /// @return number of subtrees currently paged out
+    size_t getNumPagedSubtrees() const { return paged_nodes.size(); }
+
+
     // -- access tree nodes  ------------------
 
-    /// return centers of leafs that do NOT exist (but could) in a given bounding box
+    /**
+     * Return centers of leafs at a given depth that do NOT exist (but could) in a
+     * given bounding box, i.e. all cells whose key at that depth lies between the
+     * keys of pmin and pmax (inclusive). Uses unknown_bbx_iterator, which is more
+     * efficient if you can work with the maximal unknown cubes directly.
+     */
     void getUnknownLeafCenters(point3d_list& node_centers, point3d pmin, point3d pmax, unsigned int depth = 0) const;
 
 
@@ -321,17 +426,31 @@ namespace octomap {
     /// Pruning the tree first produces smaller files (lossless compression)
     std::ostream& writeData(std::ostream &s) const;
 
+    /**
+     * Read all nodes as written by writeDataBulk() (without file header),
+     * for this the tree needs to be already created.
+     */
+    std::istream& readDataBulk(std::istream &s);
+
+    /**
+     * Write complete state of tree to stream (without file header) in bulk layout:
+     * uint64 number of nodes, the child bits of all nodes in depth-first order
+     * (one byte per node, as in writeData()), then the node payloads as contiguous
+     * arrays in the same order, see OcTreeDataNode::writeDataBulk().
+     */
+    std::ostream& writeDataBulk(std::ostream &s) const;
+
     typedef leaf_iterator iterator;
 
     /// @return beginning of the tree as leaf iterator
     iterator begin(unsigned char maxDepth=0) const {return iterator(this, maxDepth);};
     /// @return end of the tree as leaf iterator
-    const iterator end() const {return leaf_iterator_end;}; // TODO: RVE?
+    const iterator end() const {return iterator();}
 
     /// @return beginning of the tree as leaf iterator
     leaf_iterator begin_leafs(unsigned char maxDepth=0) const {return leaf_iterator(this, maxDepth);};
     /// @return end of the tree as leaf iterator
-    const leaf_iterator end_leafs() const {return leaf_iterator_end;}
+    const leaf_iterator end_leafs() const {return leaf_iterator();}
 
     /// @return beginning of the tree as leaf iterator in a bounding box
     leaf_bbx_iterator begin_leafs_bbx(const OcTreeKey& min, const OcTreeKey& max, unsigned char maxDepth=0) const {
@@ -342,12 +461,71 @@ namespace octomap {
       return leaf_bbx_iterator(this, min, max, maxDepth);
     }
     /// @return end of the tree as leaf iterator in a bounding box
-    const leaf_bbx_iterator end_leafs_bbx() const {return leaf_iterator_bbx_end;}
+    const leaf_bbx_iterator end_leafs_bbx() const {return leaf_bbx_iterator();}
+
+    /**
+     * Splits the leafs in a bounding box into ranges of disjoint subtrees, e.g. for parallel
+     * traversal. The tree is divided level by level until there are at least num_ranges
+     * subtrees (or no node can be divided further). Each returned iterator only traverses
+     * the leafs of its subtree and ends at end_leafs_bbx(). Together they visit the same
+     * leafs as begin_leafs_bbx(min, max, maxDepth).
+     *
+     * @param min Minimum OcTreeKey to be included in the axis-aligned boundingbox
+     * @param max Maximum OcTreeKey to be included in the axis-aligned boundingbox
+     * @param[out] ranges Iterators to the first leaf of each subtree
+     * @param num_ranges Minimum number of ranges to create
+     * @param maxDepth Maximum depth to traverse the tree. 0 (default): unlimited
+     */
+    void splitLeafsBBX(const OcTreeKey& min, const OcTreeKey& max, std::vector<leaf_bbx_iterator>& ranges,
+                       size_t num_ranges, unsigned char maxDepth=0) const;
+
+    /**
+     * Calls fn(it) for all leafs in a bounding box, where it is a leaf_bbx_iterator
+     * pointing to the leaf (use it.getKey(), it.getDepth(), it.getSize() and *it).
+     * With OpenMP, the leafs are split into subtree ranges (see splitLeafsBBX()) that are
+     * processed by all threads with dynamic scheduling, so fn needs to be thread-safe and
+     * the order of the leafs is not defined. The tree must not be modified meanwhile.
+     *
+     * @param min Minimum OcTreeKey to be included in the axis-aligned boundingbox
+     * @param max Maximum OcTreeKey to be included in the axis-aligned boundingbox
+     * @param fn Function or functor taking a const leaf_bbx_iterator&
+     * @param maxDepth Maximum depth to traverse the tree. 0 (default): unlimited
+     */
+    template <class FUNCTION>
+    void parallelForLeafs(const OcTreeKey& min, const OcTreeKey& max, FUNCTION fn, unsigned char maxDepth=0) const;
+
+    /// Calls fn(it) for all leafs in a bounding box, see parallelForLeafs() above
+    template <class FUNCTION>
+    void parallelForLeafs(const point3d& min, const point3d& max, FUNCTION fn, unsigned char maxDepth=0) const;
+
+    /// Calls fn(it) for all leafs of the tree, see parallelForLeafs() above
+    template <class FUNCTION>
+    void parallelForLeafs(FUNCTION fn, unsigned char maxDepth=0) const;
+
+    /// @return beginning of the unknown space in a bounding box (see unknown_bbx_iterator)
+    unknown_bbx_iterator begin_unknown_bbx(const OcTreeKey& min, const OcTreeKey& max, unsigned char maxDepth=0) const {
+      return unknown_bbx_iterator(this, min, max, maxDepth);
+    }
+    /// @return beginning of the unknown space in a bounding box (see unknown_bbx_iterator)
+    unknown_bbx_iterator begin_unknown_bbx(const point3d& min, const point3d& max, unsigned char maxDepth=0) const {
+      return unknown_bbx_iterator(this, min, max, maxDepth);
+    }
+    /// @return end of the unknown space in a bounding box
+    const unknown_bbx_iterator end_unknown_bbx() const {return unknown_bbx_iterator();}
+
+    /// @return beginning of the tree as leaf iterator in a view frustum
+    /// (see leaf_frustum_iterator for the parameters)
+    leaf_frustum_iterator begin_leafs_frustum(const pose6d& sensor_pose, double fov_h, double fov_v,
+                                              double min_range, double max_range, unsigned char maxDepth=0) const {
+      return leaf_frustum_iterator(this, sensor_pose, fov_h, fov_v, min_range, max_range, maxDepth);
+    }
+    /// @return end of the tree as leaf iterator in a view frustum
+    const leaf_frustum_iterator end_leafs_frustum() const {return leaf_frustum_iterator();}
 
     /// @return beginning of the tree as iterator to all nodes (incl. inner)
     tree_iterator begin_tree(unsigned char maxDepth=0) const {return tree_iterator(this, maxDepth);}
     /// @return end of the tree as iterator to all nodes (incl. inner)
-    const tree_iterator end_tree() const {return tree_iterator_end;}
+    const tree_iterator end_tree() const {return tree_iterator();}
 
     //
     // Key / coordinate conversion functions
@@ -515,7 +693,21 @@ namespace octomap {
     
     /// recursive call of writeData()
     std::ostream& writeNodesRecurs(const NODE*, std::ostream &s) const;
+
+    /// recursive call of readDataBulk(), creates the children given in child_bits
+    /// starting at pos, @return false if child_bits is inconsistent
+    bool readNodesBulkRecurs(NODE* node, unsigned int depth, const std::vector<char>& child_bits,
+                             size_t& pos, std::vector<NODE*>& nodes);
+
+    /// recursive call of writeDataBulk(), collects nodes and child bits in depth-first order
+    /// (paged out nodes are read into paged_copies, to be deleted with deleteNodeCopy())
+    void writeNodesBulkRecurs(const NODE* node, std::vector<const NODE*>& nodes,
+                              std::vector<char>& child_bits, std::vector<NODE*>& paged_copies) const;
     
+    /// Recursively copies the data and children of src (a node of src_tree) into dst,
+    /// creating all children as NODE. Does NOT update the tree size.
+    void copyNodeRecurs(const OcTreeBaseImpl<NODE,INTERFACE>& src_tree, const NODE* src, NODE* dst);
+
     /// Recursively delete a node and all children. Deallocates memory
     /// but does NOT set the node ptr to NULL nor updates tree size.
     void deleteNodeRecurs(NODE* node);
@@ -523,14 +715,102 @@ namespace octomap {
     /// recursive call of deleteNode()
     bool deleteNodeRecurs(NODE* node, unsigned int depth, unsigned int max_depth, const OcTreeKey& key);
 
-    /// recursive call of prune()
+    /// recursive call of prune(): prunes the nodes down to max_depth bottom-up (except for the root)
     void pruneRecurs(NODE* node, unsigned int depth, unsigned int max_depth, unsigned int& num_pruned);
 
     /// recursive call of expand()
     void expandRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
+
+    /// collects the existing nodes at max_depth below node (at depth), e.g. to process their subtrees in parallel
+    void getNodesAtDepthRecurs(NODE* node, unsigned int depth, unsigned int max_depth, std::vector<NODE*>& nodes) const;
+
+    /// depth of the subtrees which prune(), expand() etc. process independently (in parallel with OpenMP)
+    static const unsigned int parallel_subtree_depth = 2;
     
     size_t getNumLeafNodesRecurs(const NODE* parent) const;
 
+    /// @return true if the subtree below node is paged out (see enablePaging())
+    inline bool isNodePaged(const NODE* node) const { return node->children == paged_children; }
+
+    /// @return true if a child of node is paged out
+    bool nodeHasPagedChild(const NODE* node) const;
+
+    /// reads the paged out subtree of node back into memory, @return false on errors
+    bool pageInNode(const NODE* node) const;
+
+    /**
+     * @return a copy of the paged out node with its subtree read from the page
+     * file, which is not attached to the tree. For const traversals (e.g. file
+     * output) that should not keep paged out subtrees in memory. Free it with
+     * deleteNodeCopy(). NULL if node is not paged out (anymore).
+     */
+    NODE* readPagedNodeCopy(const NODE* node) const;
+
+    /// deletes a node and its subtree which are not part of the tree (see readPagedNodeCopy())
+    static void deleteNodeCopy(NODE* node);
+
+    /// Reads a paged out node temporarily with readPagedNodeCopy() while in scope,
+    /// other nodes are used directly
+    class PagedNodeReader {
+    public:
+      PagedNodeReader(const OcTreeBaseImpl<NODE,INTERFACE>& tree, const NODE* node)
+        : copy(tree.isNodePaged(node) ? tree.readPagedNodeCopy(node) : NULL),
+          node(copy ? copy : node) {}
+      ~PagedNodeReader() { deleteNodeCopy(copy); }
+      /// @return the node, with its subtree in memory
+      const NODE* get() const { return node; }
+    private:
+      PagedNodeReader(const PagedNodeReader&);
+      PagedNodeReader& operator=(const PagedNodeReader&);
+      NODE* copy;
+      const NODE* node;
+    };
+
+    /// like nodeHasChildren(), but without reading a paged out subtree back
+    /// (paged out nodes always have children)
+    inline bool nodeHasChildrenOrIsPaged(const NODE* node) const {
+      return isNodePaged(node) || nodeHasChildren(node);
+    }
+
+    /// writes the subtree below node to the page file and deletes it,
+    /// @return memory freed in bytes (0 on error)
+    size_t pageOutNode(NODE* node);
+
+    /// forgets the paged out subtree of node, e.g. when the node is deleted
+    void discardPage(NODE* node);
+
+    /// records an access to node (at page_depth) for updatePaging()
+    void markPageAccess(const NODE* node) const;
+
+    /// writes the subtree below node to s for the page file, with writePagedNode()
+    void writePagedNodesRecurs(const NODE* node, std::ostream& s) const;
+
+    /// reads a subtree written by writePagedNodesRecurs() below node (without
+    /// updating the tree size), @return number of nodes read
+    size_t readPagedNodesRecurs(NODE* node, std::istream& s) const;
+
+    /// writes the state of a node to the page file, the default is NODE::writeData()
+    virtual void writePagedNode(const NODE* node, std::ostream& s) const { node->writeData(s); }
+
+    /// reads the state of a node written by writePagedNode(), the default is NODE::readData()
+    virtual void readPagedNode(NODE* node, std::istream& s) const { node->readData(s); }
+
+    /// called when the subtree below node (at page_depth) was read back from the
+    /// page file, e.g. to recompute data derived from the children. node is
+    /// a copy with the data of the paged out node, its subtree is attached afterwards.
+    virtual void restorePagedSubtree(NODE* node) {}
+
+    /**
+     * Hook for trees whose inner nodes aggregate data of their children
+     * (e.g. the voxel counts of AggregateOcTree). It is called after the tree
+     * was read or changed as a whole: by all readers of OccupancyOcTreeBase,
+     * updateInnerOccupancy(), deleteAABB() and setAABB(). The default does nothing.
+     */
+    virtual void updateAggregateData() {}
+
+    /// like updateAggregateData(), for the ancestors of key after deleteNode()
+    virtual void updateAggregateDataOnPath(const OcTreeKey& key) {}
+
   private:
     /// Assignment operator is private: don't (re-)assign octrees
     /// (const-parameters can't be changed) -  use the copy constructor instead.
@@ -539,6 +819,9 @@ namespace octomap {
   protected:  
     void allocNodeChildren(NODE* node);
 
+    /// creates child childIdx of node like createNodeChild(), but without updating the tree size
+    NODE* allocNodeChild(NODE* node, unsigned int childIdx);
+
     NODE* root; ///< Pointer to the root NODE, NULL for empty tree
 
     // constants of the tree
@@ -561,11 +844,33 @@ namespace octomap {
     /// data structure for ray casting, array for multithreading
     std::vector<KeyRay> keyrays;
 
-    const leaf_iterator leaf_iterator_end;
-    const leaf_bbx_iterator leaf_iterator_bbx_end;
-    const tree_iterator tree_iterator_end;
-
-
+    // out-of-core paging, see enablePaging()
+    /// children array of paged out nodes (all NULL), marks them for nodeHasChildren() etc.
+    static AbstractOcTreeNode* paged_children[8];
+
+    /// location of a paged out subtree in the page file
+    struct PageRecord {
+      uint64_t offset;
+      uint64_t size;
+      size_t num_leafs; ///< for getNumLeafNodes()
+      size_t num_nodes; ///< nodes below the paged out node, for size()
+    };
+    typedef unordered_ns::unordered_map<const NODE*, PageRecord> PageRecordMap;
+    typedef unordered_ns::unordered_map<const NODE*, unsigned int> PageAccessMap;
+
+    bool paging_enabled;
+    mutable std::fstream page_file;
+    std::string page_filename;
+    unsigned int page_depth;
+    unsigned int page_max_idle;
+    size_t page_memory_budget;
+    mutable PageRecordMap paged_nodes;
+    mutable size_t paged_num_leafs; ///< sum over paged_nodes
+    mutable size_t paged_num_nodes; ///< sum over paged_nodes
+    mutable PageAccessMap page_access; ///< access period of the subtrees in memory
+    unsigned int page_clock; ///< current access period
+    mutable std::multimap<uint64_t, uint64_t> page_free; ///< unused extents of the page file (size -> offset)
+    mutable uint64_t page_file_end;
   };
 
 }
@@ -34,6 +34,8 @@
 #undef max
 #undef min
 #include <limits>
+#include <sstream>
+#include <cstdio>
 
 #ifdef _OPENMP
   #include <omp.h>
@@ -67,6 +69,7 @@ namespace octomap {
   template <class NODE,class I>
   OcTreeBaseImpl<NODE,I>::~OcTreeBaseImpl(){
     clear();
+    disablePaging();
   }
 
 
@@ -77,9 +80,13 @@ namespace octomap {
   {
     init();
 
-    // copy nodes recursively:
-    if (rhs.root)
-      root = new NODE(*(rhs.root));
+    // copy nodes recursively (paging is not copied, paged out subtrees are
+    // read from the page file of rhs one at a time):
+    tree_size = rhs.size();
+    if (rhs.root){
+      root = new NODE();
+      copyNodeRecurs(rhs, rhs.root, root);
+    }
 
   }
 
@@ -93,6 +100,15 @@ namespace octomap {
     }
     size_changed = true;
 
+    paging_enabled = false;
+    page_depth = 0;
+    page_max_idle = 0;
+    page_memory_budget = 0;
+    paged_num_leafs = 0;
+    paged_num_nodes = 0;
+    page_clock = 0;
+    page_file_end = 0;
+
     // create as many KeyRays as there are OMP_THREADS defined,
     // one buffer for each thread
 #ifdef _OPENMP
@@ -112,6 +128,10 @@ namespace octomap {
 
   template <class NODE,class I>
   void OcTreeBaseImpl<NODE,I>::swapContent(OcTreeBaseImpl<NODE,I>& other){
+    // paged out subtrees belong to the page file of their tree
+    this->pageInAll();
+    other.pageInAll();
+
     NODE* this_root = root;
     root = other.root;
     other.root = this_root;
@@ -123,6 +143,8 @@ namespace octomap {
 
   template <class NODE,class I>
   bool OcTreeBaseImpl<NODE,I>::operator== (const OcTreeBaseImpl<NODE,I>& other) const{
+    this->pageInAll();
+    other.pageInAll();
     if (tree_depth != other.tree_depth || tree_max_val != other.tree_max_val
         || resolution != other.resolution || tree_size != other.tree_size){
       return false;
@@ -171,14 +193,11 @@ namespace octomap {
   
   template <class NODE,class I>
   NODE* OcTreeBaseImpl<NODE,I>::createNodeChild(NODE* node, unsigned int childIdx){
-    assert(childIdx < 8);
-    if (node->children == NULL) {
-      allocNodeChildren(node);
-    }
-    assert (node->children[childIdx] == NULL);
-    NODE* newNode = new NODE();
-    node->children[childIdx] = static_cast<AbstractOcTreeNode*>(newNode);
+    NODE* newNode = allocNodeChild(node, childIdx);
     
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
     tree_size++;
     size_changed = true;
     
@@ -189,9 +208,14 @@ namespace octomap {
   void OcTreeBaseImpl<NODE,I>::deleteNodeChild(NODE* node, unsigned int childIdx){
     assert((childIdx < 8) && (node->children != NULL));
     assert(node->children[childIdx] != NULL);
+    if (isNodePaged(static_cast<NODE*>(node->children[childIdx])))
+      discardPage(static_cast<NODE*>(node->children[childIdx]));
     delete static_cast<NODE*>(node->children[childIdx]); // TODO delete check if empty
     node->children[childIdx] = NULL;
     
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
     tree_size--;
     size_changed = true;
   }
@@ -214,7 +238,7 @@ namespace octomap {
   bool OcTreeBaseImpl<NODE,I>::isNodeCollapsible(const NODE* node) const{
     // all children must exist, must not have children of
     // their own and have the same occupancy probability
-    if (!nodeChildExists(node, 0))
+    if (!nodeChildExists(node, 0) || nodeHasPagedChild(node))
       return false;
     
     const NODE* firstChild = getNodeChild(node, 0);
@@ -232,16 +256,17 @@ namespace octomap {
   }
   
   template <class NODE,class I>
-  bool OcTreeBaseImpl<NODE,I>::nodeChildExists(const NODE* node, unsigned int childIdx) const{
+  inline bool OcTreeBaseImpl<NODE,I>::nodeChildExists(const NODE* node, unsigned int childIdx) const{
     assert(childIdx < 8);
     if ((node->children != NULL) && (node->children[childIdx] != NULL))
       return true;
-    else
-      return false;
+
+    // children of a paged out node are read back first
+    return isNodePaged(node) && pageInNode(node) && (node->children[childIdx] != NULL);
   }
   
   template <class NODE,class I>
-  bool OcTreeBaseImpl<NODE,I>::nodeHasChildren(const NODE* node) const {
+  inline bool OcTreeBaseImpl<NODE,I>::nodeHasChildren(const NODE* node) const {
     if (node->children == NULL)
       return false;
     
@@ -249,7 +274,9 @@ namespace octomap {
       if (node->children[i] != NULL)
         return true;
     }
-    return false;
+
+    // children of a paged out node are read back first
+    return isNodePaged(node) && pageInNode(node);
   }
 
     
@@ -276,19 +303,49 @@ namespace octomap {
     for (unsigned int i=0;i<8;i++) {
       deleteNodeChild(node, i);
     }
-    delete[] node->children;
+    NODE::deleteChildrenArray(node->children);
     node->children = NULL;
 
     return true;
   }
   
   template <class NODE,class I>
-  void OcTreeBaseImpl<NODE,I>::allocNodeChildren(NODE* node){
-    // TODO NODE*
-    node->children = new AbstractOcTreeNode*[8];
+  void OcTreeBaseImpl<NODE,I>::deleteNodeChildren(NODE* node){
+    if (node->children == NULL)
+      return;
+    if (isNodePaged(node)){
+      discardPage(node);
+      return;
+    }
+
     for (unsigned int i=0; i<8; i++) {
-      node->children[i] = NULL;
+      if (node->children[i] != NULL){
+        deleteNodeChildren(getNodeChild(node, i));
+        deleteNodeChild(node, i);
+      }
+    }
+    NODE::deleteChildrenArray(node->children);
+    node->children = NULL;
+  }
+
+  template <class NODE,class I>
+  NODE* OcTreeBaseImpl<NODE,I>::allocNodeChild(NODE* node, unsigned int childIdx){
+    assert(childIdx < 8);
+    if (isNodePaged(node)) {
+      pageInNode(node);
+    }
+    if (node->children == NULL) {
+      allocNodeChildren(node);
     }
+    assert (node->children[childIdx] == NULL);
+    NODE* newNode = new NODE();
+    node->children[childIdx] = static_cast<AbstractOcTreeNode*>(newNode);
+    return newNode;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::allocNodeChildren(NODE* node){
+    node->children = NODE::newChildrenArray();
   }
   
   
@@ -449,6 +506,8 @@ namespace octomap {
     NODE* curNode (root);
 
     int diff = tree_depth - depth;
+    // level at which accesses are recorded for paging (none: -1)
+    const int page_i = paging_enabled ? int(tree_depth - page_depth) : -1;
 
     // follow nodes down to requested level (for diff = 0 it's the last level)
     for (int i=(tree_depth-1); i>=diff; --i) {
@@ -456,6 +515,8 @@ namespace octomap {
       if (nodeChildExists(curNode, pos)) {
         // cast needed: (nodes need to ensure it's the right pointer)
         curNode = getNodeChild(curNode, pos);
+        if (i == page_i)
+          markPageAccess(curNode);
       } else {
         // we expected a child but did not get it
         // is the current node a leaf already?
@@ -505,7 +566,9 @@ namespace octomap {
     if (depth == 0)
       depth = tree_depth;
 
-    return deleteNodeRecurs(root, 0, depth, key);
+    bool deleted = deleteNodeRecurs(root, 0, depth, key);
+    updateAggregateDataOnPath(key);
+    return deleted;
   }
 
   template <class NODE,class I>
@@ -517,6 +580,10 @@ namespace octomap {
       // max extent of tree changed:
       this->size_changed = true;
     }
+    // the page file is reused from the start
+    page_access.clear();
+    page_free.clear();
+    page_file_end = 0;
   }
 
   template <class NODE,class I>
@@ -524,18 +591,34 @@ namespace octomap {
     if (root == NULL)
       return;
 
-    for (unsigned int depth=tree_depth-1; depth > 0; --depth) {
-      unsigned int num_pruned = 0;
-      pruneRecurs(this->root, 0, depth, num_pruned);
-      if (num_pruned == 0)
-        break;
+    // single bottom-up pass: first the independent subtrees, then the levels above them
+    std::vector<NODE*> subtrees;
+    getNodesAtDepthRecurs(root, 0, parallel_subtree_depth, subtrees);
+    unsigned int num_pruned = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(+:num_pruned)
+#endif
+    for (int i = 0; i < (int) subtrees.size(); ++i) {
+      pruneRecurs(subtrees[i], parallel_subtree_depth, tree_depth, num_pruned);
     }
+    pruneRecurs(root, 0, parallel_subtree_depth-1, num_pruned);
   }
 
   template <class NODE,class I>
   void OcTreeBaseImpl<NODE,I>::expand() {
-    if (root)
-      expandRecurs(root,0, tree_depth);
+    if (root == NULL)
+      return;
+
+    // expand the levels above the subtrees first, then the independent subtrees
+    expandRecurs(root, 0, parallel_subtree_depth);
+    std::vector<NODE*> subtrees;
+    getNodesAtDepthRecurs(root, 0, parallel_subtree_depth, subtrees);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < (int) subtrees.size(); ++i) {
+      expandRecurs(subtrees[i], parallel_subtree_depth, tree_depth);
+    }
   }
 
   template <class NODE,class I>
@@ -658,18 +741,41 @@ namespace octomap {
     return true;
   }
   
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::copyNodeRecurs(const OcTreeBaseImpl<NODE,I>& src_tree, const NODE* src, NODE* dst){
+    dst->copyData(*src);
+    if (src_tree.isNodePaged(src)){
+      PagedNodeReader paged(src_tree, src);
+      copyNodeRecurs(src_tree, paged.get(), dst);
+      return;
+    }
+    if (src->children == NULL)
+      return;
+
+    allocNodeChildren(dst);
+    for (unsigned int i=0; i<8; i++) {
+      if (src->children[i] != NULL){
+        NODE* child = new NODE();
+        dst->children[i] = static_cast<AbstractOcTreeNode*>(child);
+        copyNodeRecurs(src_tree, static_cast<const NODE*>(src->children[i]), child);
+      }
+    }
+  }
+
   template <class NODE,class I>
   void OcTreeBaseImpl<NODE,I>::deleteNodeRecurs(NODE* node){
     assert(node);
     // TODO: maintain tree size?
     
-    if (node->children != NULL) {
+    if (isNodePaged(node)) {
+      discardPage(node);
+    } else if (node->children != NULL) {
       for (unsigned int i=0; i<8; i++) {
         if (node->children[i] != NULL){
           this->deleteNodeRecurs(static_cast<NODE*>(node->children[i]));
         }
       }
-      delete[] node->children;
+      NODE::deleteChildrenArray(node->children);
       node->children = NULL;
     } // else: node has no children
       
@@ -707,11 +813,10 @@ namespace octomap {
 
       if (!nodeHasChildren(node))
         return true;
-      else{
-        node->updateOccupancyChildren(); // TODO: occupancy?
-      }
     }
-    // node did not lose a child, or still has other children
+    // node still has other children: update it from the (possibly changed) subtree,
+    // so that the change propagates to all ancestors
+    node->updateOccupancyChildren(); // TODO: occupancy?
     return false;
   }
 
@@ -721,6 +826,10 @@ namespace octomap {
 
     assert(node);
 
+    // paged out subtrees were pruned before, they are not read back for this
+    if (isNodePaged(node))
+      return;
+
     if (depth < max_depth) {
       for (unsigned int i=0; i<8; i++) {
         if (nodeChildExists(node, i)) {
@@ -729,10 +838,25 @@ namespace octomap {
       }
     } // end if depth
 
-    else {
-      // max level reached
-      if (pruneNode(node)) {
-        num_pruned++;
+    // children are pruned before their parent, the root is never pruned
+    if (depth > 0 && pruneNode(node)) {
+      num_pruned++;
+    }
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::getNodesAtDepthRecurs(NODE* node, unsigned int depth,
+                                                     unsigned int max_depth, std::vector<NODE*>& nodes) const {
+    assert(node);
+
+    if (depth >= max_depth) {
+      nodes.push_back(node);
+      return;
+    }
+
+    for (unsigned int i=0; i<8; i++) {
+      if (nodeChildExists(node, i)) {
+        getNodesAtDepthRecurs(getNodeChild(node, i), depth+1, max_depth, nodes);
       }
     }
   }
@@ -768,7 +892,9 @@ namespace octomap {
   }
   
   template <class NODE,class I>
-  std::ostream& OcTreeBaseImpl<NODE,I>::writeNodesRecurs(const NODE* node, std::ostream &s) const{
+  std::ostream& OcTreeBaseImpl<NODE,I>::writeNodesRecurs(const NODE* paged_node, std::ostream &s) const{
+    PagedNodeReader paged(*this, paged_node);
+    const NODE* node = paged.get();
     node->writeData(s);
     
     // 1 bit for each children; 0: empty, 1: allocated
@@ -846,6 +972,127 @@ namespace octomap {
 
 
 
+  template <class NODE,class I>
+  std::ostream& OcTreeBaseImpl<NODE,I>::writeDataBulk(std::ostream &s) const{
+    std::vector<const NODE*> nodes;
+    std::vector<char> child_bits;
+    // the node arrays need all nodes at once, paged out subtrees are read temporarily
+    std::vector<NODE*> paged_copies;
+    if (root) {
+      nodes.reserve(size());
+      child_bits.reserve(size());
+      writeNodesBulkRecurs(root, nodes, child_bits, paged_copies);
+    }
+
+    uint64_t num_nodes = nodes.size();
+    s.write((char*)&num_nodes, sizeof(num_nodes));
+    if (num_nodes > 0) {
+      s.write(&child_bits[0], child_bits.size());
+      NODE::writeDataBulk(nodes, s);
+    }
+    for (size_t i = 0; i < paged_copies.size(); ++i)
+      deleteNodeCopy(paged_copies[i]);
+    return s;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::writeNodesBulkRecurs(const NODE* node, std::vector<const NODE*>& nodes,
+                                                    std::vector<char>& child_bits,
+                                                    std::vector<NODE*>& paged_copies) const{
+    NODE* copy = isNodePaged(node) ? readPagedNodeCopy(node) : NULL;
+    if (copy) {
+      paged_copies.push_back(copy);
+      node = copy;
+    }
+    nodes.push_back(node);
+    char children_char = 0;
+    for (unsigned int i=0; i<8; i++) {
+      if (nodeChildExists(node, i))
+        children_char |= (char) (1 << i);
+    }
+    child_bits.push_back(children_char);
+
+    for (unsigned int i=0; i<8; i++) {
+      if (children_char & (1 << i))
+        writeNodesBulkRecurs(getNodeChild(node, i), nodes, child_bits, paged_copies);
+    }
+  }
+
+  template <class NODE,class I>
+  std::istream& OcTreeBaseImpl<NODE,I>::readDataBulk(std::istream &s) {
+
+    if (!s.good()){
+      OCTOMAP_WARNING_STR(__FILE__ << ":" << __LINE__ << "Warning: Input filestream not \"good\"");
+    }
+
+    this->tree_size = 0;
+    size_changed = true;
+
+    // tree needs to be newly created or cleared externally
+    if (root) {
+      OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
+      return s;
+    }
+
+    uint64_t num_nodes = 0;
+    s.read((char*)&num_nodes, sizeof(num_nodes));
+    if (s.fail() || num_nodes == 0)
+      return s;
+
+    std::vector<char> child_bits;
+    // grow with the data instead of trusting the size for the allocation
+    const size_t block_size = 1 << 20;
+    while (child_bits.size() < num_nodes && s.good()) {
+      size_t old_size = child_bits.size();
+      size_t new_size = std::min(size_t(num_nodes), old_size + block_size);
+      child_bits.resize(new_size);
+      s.read(&child_bits[old_size], new_size - old_size);
+    }
+    if (s.fail()) {
+      OCTOMAP_ERROR_STR("Tree structure ended unexpectedly, expected " << num_nodes << " nodes.");
+      return s;
+    }
+
+    std::vector<NODE*> nodes;
+    nodes.reserve(child_bits.size());
+    root = new NODE();
+    size_t pos = 0;
+    if (!readNodesBulkRecurs(root, 0, child_bits, pos, nodes) || pos != child_bits.size()) {
+      OCTOMAP_ERROR_STR("Inconsistent tree structure in bulk data.");
+      clear();
+      s.setstate(std::ios_base::failbit);
+      return s;
+    }
+
+    NODE::readDataBulk(nodes, s);
+    if (s.fail())
+      OCTOMAP_ERROR_STR("Node data ended unexpectedly.");
+
+    tree_size = nodes.size();
+    return s;
+  }
+
+  template <class NODE,class I>
+  bool OcTreeBaseImpl<NODE,I>::readNodesBulkRecurs(NODE* node, unsigned int depth, const std::vector<char>& child_bits,
+                                                   size_t& pos, std::vector<NODE*>& nodes) {
+    if (pos >= child_bits.size())
+      return false;
+    nodes.push_back(node);
+    char children_char = child_bits[pos++];
+    if (children_char != 0 && depth >= tree_depth)
+      return false;
+
+    for (unsigned int i=0; i<8; i++) {
+      if (children_char & (1 << i)){
+        NODE* newNode = createNodeChild(node, i);
+        if (!readNodesBulkRecurs(newNode, depth+1, child_bits, pos, nodes))
+          return false;
+      }
+    }
+    return true;
+  }
+
+
   template <class NODE,class I>
   unsigned long long OcTreeBaseImpl<NODE,I>::memoryFullGrid() const{
     if (root == NULL)
@@ -1025,7 +1272,10 @@ namespace octomap {
   template <class NODE,class I>
   void OcTreeBaseImpl<NODE,I>::calcNumNodesRecurs(NODE* node, size_t& num_nodes) const {
     assert (node);
-    if (nodeHasChildren(node)) {
+    // paged out nodes are counted when paging out, not read back for this
+    if (isNodePaged(node)) {
+      num_nodes += paged_nodes.find(node)->second.num_nodes;
+    } else if (nodeHasChildren(node)) {
       for (unsigned int i=0; i<8; ++i) {
         if (nodeChildExists(node, i)) {
           num_nodes++;
@@ -1037,9 +1287,10 @@ namespace octomap {
 
   template <class NODE,class I>
   size_t OcTreeBaseImpl<NODE,I>::memoryUsage() const{
-    size_t num_leaf_nodes = this->getNumLeafNodes();
+    // only nodes in memory: paged out subtrees are not, their roots are leafs there
+    size_t num_leaf_nodes = this->getNumLeafNodes() - paged_num_leafs + paged_nodes.size();
     size_t num_inner_nodes = tree_size - num_leaf_nodes;
-    return (sizeof(OcTreeBaseImpl<NODE,I>) + memoryUsageNode() * tree_size + num_inner_nodes * sizeof(NODE*[8]));
+    return (sizeof(OcTreeBaseImpl<NODE,I>) + memoryUsageNode() * tree_size + num_inner_nodes * NODE::childrenArraySize());
   }
 
   template <class NODE,class I>
@@ -1048,40 +1299,135 @@ namespace octomap {
     assert(depth <= tree_depth);
     if (depth == 0)
       depth = tree_depth;
-    
-    point3d pmin_clamped = this->keyToCoord(this->coordToKey(pmin, depth), depth);
-    point3d pmax_clamped = this->keyToCoord(this->coordToKey(pmax, depth), depth);    
-    
-    float diff[3];
-    unsigned int steps[3];
-    float step_size = this->resolution * pow(2, tree_depth-depth);
-    for (int i=0;i<3;++i) {
-      diff[i] = pmax_clamped(i) - pmin_clamped(i);
-      steps[i] = floor(diff[i] / step_size);
-      //      std::cout << "bbx " << i << " size: " << diff[i] << " " << steps[i] << " steps\n";
+
+    OcTreeKey min_key, max_key;
+    if (!coordToKeyChecked(pmin, min_key) || !coordToKeyChecked(pmax, max_key)){
+      OCTOMAP_ERROR_STR("Error in getUnknownLeafCenters: bounding box out of tree bounds");
+      return;
     }
-    
-    point3d p = pmin_clamped;
-    NODE* res;
-    for (unsigned int x=0; x<steps[0]; ++x) {
-      p.x() += step_size;
-      for (unsigned int y=0; y<steps[1]; ++y) {
-        p.y() += step_size;
-        for (unsigned int z=0; z<steps[2]; ++z) {
-          //          std::cout << "querying p=" << p << std::endl;
-          p.z() += step_size;
-          res = this->search(p,depth);
-          if (res == NULL) {
-            node_centers.push_back(p);
+
+    // unknown cubes above the requested depth are split into cells at that depth
+    const unsigned int shift = tree_depth - depth;
+    unsigned int first[3], last[3];
+    OcTreeKey cell_key;
+    for (unknown_bbx_iterator it = begin_unknown_bbx(min_key, max_key, depth), end = end_unknown_bbx(); it != end; ++it){
+      const OcTreeKey& key = it.getKey();
+      const key_type half = key_type(tree_max_val >> it.getDepth());
+      for (unsigned int i = 0; i < 3; ++i){
+        first[i] = std::max(unsigned(key[i]) - half, unsigned(min_key[i])) >> shift;
+        last[i] = std::min(half ? unsigned(key[i]) + half - 1 : unsigned(key[i]), unsigned(max_key[i])) >> shift;
+      }
+
+      for (unsigned int x = first[0]; x <= last[0]; ++x){
+        cell_key[0] = key_type(x << shift);
+        for (unsigned int y = first[1]; y <= last[1]; ++y){
+          cell_key[1] = key_type(y << shift);
+          for (unsigned int z = first[2]; z <= last[2]; ++z){
+            cell_key[2] = key_type(z << shift);
+            node_centers.push_back(keyToCoord(adjustKeyAtDepth(cell_key, depth), depth));
           }
         }
-        p.z() = pmin_clamped.z();
       }
-      p.y() = pmin_clamped.y();
     }
   }
 
 
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::splitLeafsBBX(const OcTreeKey& min, const OcTreeKey& max,
+                                             std::vector<leaf_bbx_iterator>& ranges,
+                                             size_t num_ranges, unsigned char maxDepth) const {
+    ranges.clear();
+    if (root == NULL)
+      return;
+    if (maxDepth == 0)
+      maxDepth = (unsigned char) tree_depth;
+
+    typedef typename leaf_bbx_iterator::StackElement StackElement;
+    std::vector<StackElement> subtrees, next_level;
+    StackElement s;
+    s.node = root;
+    s.depth = 0;
+    s.key[0] = s.key[1] = s.key[2] = tree_max_val;
+    subtrees.push_back(s);
+
+    // divide one level at a time, leafs are kept as they are:
+    bool divided = true;
+    while (subtrees.size() < num_ranges && divided){
+      divided = false;
+      next_level.clear();
+      for (size_t i = 0; i < subtrees.size(); ++i){
+        const StackElement& top = subtrees[i];
+        if (top.depth >= maxDepth || !nodeHasChildren(top.node)){
+          next_level.push_back(top);
+          continue;
+        }
+
+        divided = true;
+        s.depth = top.depth + 1;
+        key_type center_offset_key = tree_max_val >> s.depth;
+        for (unsigned int j = 0; j < 8; ++j){
+          if (!nodeChildExists(top.node, j))
+            continue;
+
+          computeChildKey(j, center_offset_key, top.key, s.key);
+          // overlap of query bbx and child bbx?
+          if ((min[0] <= (s.key[0] + center_offset_key)) && (max[0] >= (s.key[0] - center_offset_key))
+              && (min[1] <= (s.key[1] + center_offset_key)) && (max[1] >= (s.key[1] - center_offset_key))
+              && (min[2] <= (s.key[2] + center_offset_key)) && (max[2] >= (s.key[2] - center_offset_key)))
+          {
+            s.node = getNodeChild(top.node, j);
+            next_level.push_back(s);
+          }
+        }
+      }
+      subtrees.swap(next_level);
+    }
+
+    ranges.reserve(subtrees.size());
+    for (size_t i = 0; i < subtrees.size(); ++i)
+      ranges.push_back(leaf_bbx_iterator(this, min, max, subtrees[i], maxDepth));
+  }
+
+  template <class NODE,class I>
+  template <class FUNCTION>
+  void OcTreeBaseImpl<NODE,I>::parallelForLeafs(const OcTreeKey& min, const OcTreeKey& max,
+                                                FUNCTION fn, unsigned char maxDepth) const {
+#ifdef _OPENMP
+    // several ranges per thread to balance subtrees of different size
+    std::vector<leaf_bbx_iterator> ranges;
+    splitLeafsBBX(min, max, ranges, 8 * omp_get_max_threads(), maxDepth);
+    const leaf_bbx_iterator end = end_leafs_bbx();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < (int) ranges.size(); ++i){
+      for (leaf_bbx_iterator it = ranges[i]; it != end; ++it)
+        fn(it);
+    }
+#else
+    for (leaf_bbx_iterator it = begin_leafs_bbx(min, max, maxDepth), end = end_leafs_bbx(); it != end; ++it)
+      fn(it);
+#endif
+  }
+
+  template <class NODE,class I>
+  template <class FUNCTION>
+  void OcTreeBaseImpl<NODE,I>::parallelForLeafs(const point3d& min, const point3d& max,
+                                                FUNCTION fn, unsigned char maxDepth) const {
+    OcTreeKey min_key, max_key;
+    if (!coordToKeyChecked(min, min_key) || !coordToKeyChecked(max, max_key)){
+      OCTOMAP_ERROR_STR("Error in parallelForLeafs: bounding box out of tree bounds");
+      return;
+    }
+    parallelForLeafs(min_key, max_key, fn, maxDepth);
+  }
+
+  template <class NODE,class I>
+  template <class FUNCTION>
+  void OcTreeBaseImpl<NODE,I>::parallelForLeafs(FUNCTION fn, unsigned char maxDepth) const {
+    const key_type max_val = key_type(2*tree_max_val - 1);
+    parallelForLeafs(OcTreeKey(0, 0, 0), OcTreeKey(max_val, max_val, max_val), fn, maxDepth);
+  }
+
   template <class NODE,class I>
   size_t OcTreeBaseImpl<NODE,I>::getNumLeafNodes() const {
     if (root == NULL)
@@ -1095,6 +1441,9 @@ namespace octomap {
   size_t OcTreeBaseImpl<NODE,I>::getNumLeafNodesRecurs(const NODE* parent) const {
     assert(parent);
 
+    if (isNodePaged(parent)) // counted when paging out, not read back for this
+      return paged_nodes.find(parent)->second.num_leafs;
+
     if (!nodeHasChildren(parent)) // this is a leaf -> terminate
       return 1;
     
@@ -1108,6 +1457,300 @@ namespace octomap {
   }
 
 
+  template <class NODE,class I>
+  AbstractOcTreeNode* OcTreeBaseImpl<NODE,I>::paged_children[8] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+
+  template <class NODE,class I>
+  bool OcTreeBaseImpl<NODE,I>::enablePaging(const std::string& filename, unsigned int page_depth) {
+    if (page_depth == 0 || page_depth >= tree_depth){
+      OCTOMAP_ERROR("Paging depth must be between 1 and %d\n", tree_depth-1);
+      return false;
+    }
+    disablePaging();
+
+    page_file.open(filename.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (!page_file.is_open()){
+      OCTOMAP_ERROR_STR("Could not open page file " << filename);
+      return false;
+    }
+    this->page_filename = filename;
+    this->page_depth = page_depth;
+    paging_enabled = true;
+    page_clock = 0;
+    page_access.clear();
+    page_free.clear();
+    page_file_end = 0;
+    return true;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::disablePaging() {
+    if (!paging_enabled)
+      return;
+
+    pageInAll();
+    page_file.close();
+    std::remove(page_filename.c_str());
+    paging_enabled = false;
+    page_access.clear();
+    page_free.clear();
+    page_file_end = 0;
+  }
+
+  template <class NODE,class I>
+  size_t OcTreeBaseImpl<NODE,I>::updatePaging() {
+    if (!paging_enabled || root == NULL)
+      return 0;
+
+    ++page_clock;
+
+    // subtrees in memory with their last access, subtrees not seen before count as accessed now
+    std::vector<NODE*> nodes;
+    getNodesAtDepthRecurs(root, 0, page_depth, nodes);
+    std::vector<std::pair<unsigned int, NODE*> > subtrees;
+    subtrees.reserve(nodes.size());
+    PageAccessMap accesses;
+    for (size_t i = 0; i < nodes.size(); ++i){
+      if (isNodePaged(nodes[i]) || !nodeHasChildren(nodes[i]))
+        continue;
+      typename PageAccessMap::const_iterator it = page_access.find(nodes[i]);
+      unsigned int last_access = (it != page_access.end()) ? it->second : page_clock;
+      accesses[nodes[i]] = last_access;
+      subtrees.push_back(std::make_pair(last_access, nodes[i]));
+    }
+    page_access.swap(accesses);
+
+    // least recently accessed first
+    std::sort(subtrees.begin(), subtrees.end());
+    size_t memory = (page_memory_budget > 0) ? memoryUsage() : 0;
+    size_t num_paged = 0;
+    for (size_t i = 0; i < subtrees.size(); ++i){
+      bool idle = page_max_idle > 0 && page_clock - subtrees[i].first > page_max_idle;
+      bool over_budget = page_memory_budget > 0 && memory > page_memory_budget;
+      if (!idle && !over_budget)
+        break;
+
+      size_t freed = pageOutNode(subtrees[i].second);
+      if (freed == 0)
+        break;
+      page_access.erase(subtrees[i].second);
+      memory -= std::min(memory, freed);
+      ++num_paged;
+    }
+    page_file.flush();
+    return num_paged;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::pageInAll() const {
+    while (!paged_nodes.empty())
+      pageInNode(paged_nodes.begin()->first);
+  }
+
+  template <class NODE,class I>
+  bool OcTreeBaseImpl<NODE,I>::nodeHasPagedChild(const NODE* node) const {
+    if (paged_nodes.empty() || node->children == NULL || isNodePaged(node))
+      return false;
+
+    for (unsigned int i = 0; i < 8; i++){
+      if (node->children[i] != NULL && isNodePaged(static_cast<const NODE*>(node->children[i])))
+        return true;
+    }
+    return false;
+  }
+
+  template <class NODE,class I>
+  bool OcTreeBaseImpl<NODE,I>::pageInNode(const NODE* node) const {
+#ifdef _OPENMP
+    #pragma omp critical (octomap_paging)
+#endif
+    {
+      // may have been read by another thread meanwhile
+      typename PageRecordMap::iterator it = paged_nodes.find(node);
+      if (isNodePaged(node) && it != paged_nodes.end()){
+        const PageRecord record = it->second;
+        paged_nodes.erase(it);
+        paged_num_leafs -= record.num_leafs;
+        paged_num_nodes -= record.num_nodes;
+
+        std::string buffer((size_t) record.size, '\0');
+        page_file.clear();
+        page_file.seekg(record.offset);
+        page_file.read(&buffer[0], record.size);
+
+        // the children are read below a copy of node and attached only when
+        // complete, until then other threads see node as paged out and wait here:
+        NODE subtree;
+        subtree.copyData(*node);
+        if (page_file.good()){
+          std::istringstream s(buffer);
+          const size_t num_nodes = readPagedNodesRecurs(&subtree, s);
+          size_t& resident_size = const_cast<OcTreeBaseImpl<NODE,I>*>(this)->tree_size;
+#ifdef _OPENMP
+          #pragma omp atomic
+#endif
+          resident_size += num_nodes;
+          const_cast<OcTreeBaseImpl<NODE,I>*>(this)->restorePagedSubtree(&subtree);
+        } else {
+          OCTOMAP_ERROR_STR("Could not read paged out subtree from " << page_filename << ", it is lost.");
+        }
+#ifdef _OPENMP
+        #pragma omp flush
+#endif
+        const_cast<NODE*>(node)->children = subtree.children;
+        subtree.children = NULL;
+        page_free.insert(std::make_pair(record.size, record.offset));
+        page_access[node] = page_clock;
+      }
+    }
+    return node->children != NULL;
+  }
+
+  template <class NODE,class I>
+  NODE* OcTreeBaseImpl<NODE,I>::readPagedNodeCopy(const NODE* node) const {
+    NODE* copy = NULL;
+#ifdef _OPENMP
+    #pragma omp critical (octomap_paging)
+#endif
+    {
+      // may have been read back by another thread meanwhile
+      typename PageRecordMap::const_iterator it = paged_nodes.find(node);
+      if (isNodePaged(node) && it != paged_nodes.end()){
+        copy = new NODE();
+        copy->copyData(*node);
+        std::string buffer((size_t) it->second.size, '\0');
+        page_file.clear();
+        page_file.seekg(it->second.offset);
+        page_file.read(&buffer[0], it->second.size);
+        if (page_file.good()){
+          std::istringstream s(buffer);
+          readPagedNodesRecurs(copy, s);
+          const_cast<OcTreeBaseImpl<NODE,I>*>(this)->restorePagedSubtree(copy);
+        } else {
+          OCTOMAP_ERROR_STR("Could not read paged out subtree from " << page_filename);
+        }
+      }
+    }
+    return copy;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::deleteNodeCopy(NODE* node) {
+    if (node == NULL)
+      return;
+    if (node->children != NULL){
+      for (unsigned int i=0; i<8; i++)
+        deleteNodeCopy(static_cast<NODE*>(node->children[i]));
+      NODE::deleteChildrenArray(node->children);
+      node->children = NULL;
+    }
+    delete node;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::writePagedNodesRecurs(const NODE* node, std::ostream& s) const {
+    char children_char = 0;
+    for (unsigned int i=0; i<8; i++) {
+      if (nodeChildExists(node, i))
+        children_char |= (char) (1 << i);
+    }
+    s.write(&children_char, sizeof(char));
+
+    for (unsigned int i=0; i<8; i++) {
+      if (children_char & (1 << i)) {
+        const NODE* child = getNodeChild(node, i);
+        writePagedNode(child, s);
+        writePagedNodesRecurs(child, s);
+      }
+    }
+  }
+
+  template <class NODE,class I>
+  size_t OcTreeBaseImpl<NODE,I>::readPagedNodesRecurs(NODE* node, std::istream& s) const {
+    char children_char = 0;
+    s.read(&children_char, sizeof(char));
+    if (children_char == 0 || !s.good())
+      return 0;
+
+    size_t num_nodes = 0;
+    node->children = NODE::newChildrenArray();
+    for (unsigned int i=0; i<8; i++) {
+      if (children_char & (1 << i)) {
+        NODE* child = new NODE();
+        node->children[i] = static_cast<AbstractOcTreeNode*>(child);
+        readPagedNode(child, s);
+        num_nodes += 1 + readPagedNodesRecurs(child, s);
+      }
+    }
+    return num_nodes;
+  }
+
+  template <class NODE,class I>
+  size_t OcTreeBaseImpl<NODE,I>::pageOutNode(NODE* node) {
+    assert(!isNodePaged(node) && nodeHasChildren(node));
+
+    std::ostringstream s;
+    writePagedNodesRecurs(node, s);
+    const std::string data = s.str();
+
+    PageRecord record;
+    record.size = data.size();
+    record.num_leafs = getNumLeafNodesRecurs(node);
+    record.num_nodes = 0;
+    calcNumNodesRecurs(node, record.num_nodes);
+
+    // reuse the smallest unused extent that fits, otherwise append
+    std::multimap<uint64_t, uint64_t>::iterator free_it = page_free.lower_bound(record.size);
+    if (free_it != page_free.end()){
+      record.offset = free_it->second;
+      if (free_it->first > record.size)
+        page_free.insert(std::make_pair(free_it->first - record.size, record.offset + record.size));
+      page_free.erase(free_it);
+    } else {
+      record.offset = page_file_end;
+      page_file_end += record.size;
+    }
+
+    page_file.clear();
+    page_file.seekp(record.offset);
+    page_file.write(data.data(), data.size());
+    if (!page_file.good()){
+      OCTOMAP_ERROR_STR("Could not write subtree to page file " << page_filename);
+      page_free.insert(std::make_pair(record.size, record.offset));
+      return 0;
+    }
+
+    deleteNodeChildren(node);
+    node->children = paged_children;
+    paged_nodes[node] = record;
+    paged_num_leafs += record.num_leafs;
+    paged_num_nodes += record.num_nodes;
+
+    // nodes and child arrays (incl. the one of node) as in memoryUsage()
+    const size_t num_inner_nodes = record.num_nodes + 1 - record.num_leafs;
+    return memoryUsageNode() * record.num_nodes + num_inner_nodes * NODE::childrenArraySize();
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::discardPage(NODE* node) {
+    typename PageRecordMap::iterator it = paged_nodes.find(node);
+    if (it != paged_nodes.end()){
+      page_free.insert(std::make_pair(it->second.size, it->second.offset));
+      paged_num_leafs -= it->second.num_leafs;
+      paged_num_nodes -= it->second.num_nodes;
+      paged_nodes.erase(it);
+    }
+    node->children = NULL;
+  }
+
+  template <class NODE,class I>
+  void OcTreeBaseImpl<NODE,I>::markPageAccess(const NODE* node) const {
+#ifdef _OPENMP
+    #pragma omp critical (octomap_paging)
+#endif
+    page_access[node] = page_clock;
+  }
+
   template <class NODE,class I>
   double OcTreeBaseImpl<NODE,I>::volume() {
     double x,  y,  z;
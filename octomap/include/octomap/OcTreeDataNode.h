@@ -35,6 +35,7 @@
 #define OCTOMAP_OCTREE_DATA_NODE_H
 
 
+#include <algorithm>
 #include "octomap_types.h"
 #include "assert.h"
 
@@ -58,6 +59,8 @@ namespace octomap {
    * you have to implement (at least) the following functions to avoid slicing
    * errors and memory-related bugs:
    * createChild(), getChild(), getChild() const, expandNode() 
+   * Nodes with additional data also need readData() / writeData() and
+   * readDataBulk() / writeDataBulk() for file I/O.
    * See ColorOcTreeNode in ColorOcTree.h for an example. 
    */
   template<typename T> class OcTreeDataNode: public AbstractOcTreeNode {
@@ -112,6 +115,18 @@ namespace octomap {
     /// Write node payload (data only) to binary stream
     std::ostream& writeData(std::ostream &s) const;
 
+    /**
+     * Write the payloads of several nodes as contiguous arrays, one per data
+     * member, e.g. for OcTreeBaseImpl::writeDataBulk(). Node types with more data
+     * hide this function: call the base version, then append one array per member.
+     */
+    template <class NODE>
+    static std::ostream& writeDataBulk(const std::vector<const NODE*>& nodes, std::ostream &s);
+
+    /// Read the payloads of several nodes as written by writeDataBulk()
+    template <class NODE>
+    static std::istream& readDataBulk(const std::vector<NODE*>& nodes, std::istream &s);
+
 
     /// Make the templated data type available from the outside
     typedef T DataType;
@@ -120,6 +135,22 @@ namespace octomap {
   protected:
     void allocChildren();
 
+    /// allocates the array of the 8 (NULL) child pointers of an inner node.
+    /// Node types with data of their own per inner node hide this function,
+    /// deleteChildrenArray() and childrenArraySize() to allocate it in one block with that data.
+    static AbstractOcTreeNode** newChildrenArray();
+    /// frees an array allocated by newChildrenArray()
+    static void deleteChildrenArray(AbstractOcTreeNode** children) { delete[] children; }
+    /// @return size in bytes of an array allocated by newChildrenArray()
+    static size_t childrenArraySize() { return sizeof(AbstractOcTreeNode*[8]); }
+
+    /// writes one data member of all nodes as contiguous array (in blocks), for writeDataBulk()
+    template <class NODE, class M, class C>
+    static std::ostream& writeBulkArray(const std::vector<const NODE*>& nodes, M C::*member, std::ostream &s);
+    /// reads one data member of all nodes written by writeBulkArray()
+    template <class NODE, class M, class C>
+    static std::istream& readBulkArray(const std::vector<NODE*>& nodes, M C::*member, std::istream &s);
+
     /// pointer to array of children, may be NULL
     /// @note The tree class manages this pointer, the array, and the memory for it!
     /// The children of a node are always enforced to be the same type as the node
@@ -123,16 +123,64 @@ namespace octomap {
     return s;
   }
 
+  template <typename T>
+  template <class NODE>
+  std::ostream& OcTreeDataNode<T>::writeDataBulk(const std::vector<const NODE*>& nodes, std::ostream &s) {
+    return writeBulkArray(nodes, &OcTreeDataNode<T>::value, s);
+  }
+
+  template <typename T>
+  template <class NODE>
+  std::istream& OcTreeDataNode<T>::readDataBulk(const std::vector<NODE*>& nodes, std::istream &s) {
+    return readBulkArray(nodes, &OcTreeDataNode<T>::value, s);
+  }
+
+  template <typename T>
+  template <class NODE, class M, class C>
+  std::ostream& OcTreeDataNode<T>::writeBulkArray(const std::vector<const NODE*>& nodes, M C::*member, std::ostream &s) {
+    // gather and write in blocks that stay in the cache
+    const size_t block_size = 4096;
+    std::vector<M> block(std::min(block_size, nodes.size()));
+    for (size_t begin = 0; begin < nodes.size(); begin += block_size) {
+      size_t num = std::min(block_size, nodes.size() - begin);
+      for (size_t i = 0; i < num; ++i)
+        block[i] = nodes[begin + i]->*member;
+      s.write((const char*) &block[0], sizeof(M) * num);
+    }
+    return s;
+  }
+
+  template <typename T>
+  template <class NODE, class M, class C>
+  std::istream& OcTreeDataNode<T>::readBulkArray(const std::vector<NODE*>& nodes, M C::*member, std::istream &s) {
+    const size_t block_size = 4096;
+    std::vector<M> block(std::min(block_size, nodes.size()));
+    for (size_t begin = 0; begin < nodes.size(); begin += block_size) {
+      size_t num = std::min(block_size, nodes.size() - begin);
+      if (!s.read((char*) &block[0], sizeof(M) * num))
+        break;
+      for (size_t i = 0; i < num; ++i)
+        nodes[begin + i]->*member = block[i];
+    }
+    return s;
+  }
+
 
   // ============================================================
   // =  private methodes  =======================================
   // ============================================================
   template <typename T>
   void OcTreeDataNode<T>::allocChildren() {
-    children = new AbstractOcTreeNode*[8];
+    children = newChildrenArray();
+  }
+
+  template <typename T>
+  AbstractOcTreeNode** OcTreeDataNode<T>::newChildrenArray() {
+    AbstractOcTreeNode** children = new AbstractOcTreeNode*[8];
     for (unsigned int i=0; i<8; i++) {
       children[i] = NULL;
     }
+    return children;
   }
 
 
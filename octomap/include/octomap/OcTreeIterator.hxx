@@ -158,8 +158,11 @@
       OcTreeBaseImpl<NodeType,INTERFACE> const* tree; ///< Octree this iterator is working on
       uint8_t maxDepth; ///< Maximum depth for depth-limited queries
 
-      /// Internal recursion stack. Apparently a stack of vector works fastest here.
-      std::stack<StackElement,std::vector<StackElement> > stack;
+      /// Maximum number of stack elements: up to 8 siblings are pushed at each level of the tree
+      static const unsigned int STACK_CAPACITY = 8*16 + 2;
+
+      /// Internal recursion stack with a fixed size, no allocations and cheap copies
+      FixedStack<StackElement, STACK_CAPACITY> stack;
       
       /// One step of depth-first tree traversal.
       /// How this is used depends on the actual iterator.
@@ -389,6 +392,30 @@
         }
       }
 
+      /**
+      * Constructor of the iterator for the leafs of a single subtree in the
+      * bounding box, as created by OcTreeBaseImpl::splitLeafsBBX().
+      *
+      * @param tree OcTreeBaseImpl on which the iterator is used on
+      * @param min Minimum OcTreeKey to be included in the axis-aligned boundingbox
+      * @param max Maximum OcTreeKey to be included in the axis-aligned boundingbox
+      * @param subtree Root of the subtree to traverse (needs to overlap the bounding box)
+      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
+      */
+      leaf_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* tree, const OcTreeKey& min, const OcTreeKey& max,
+                        const typename iterator_base::StackElement& subtree, uint8_t depth=0)
+        : iterator_base(tree, depth), minKey(min), maxKey(max)
+      {
+        // tree could be empty (= no stack)
+        if (this->stack.size() > 0){
+          // replace root by the subtree and advance to its first leaf:
+          this->stack.pop();
+          this->stack.push(subtree);
+          this->stack.push(subtree);
+          this->operator ++();
+        }
+      }
+
       leaf_bbx_iterator(const leaf_bbx_iterator& other) : iterator_base(other) {
         minKey = other.minKey;
         maxKey = other.maxKey;
@@ -460,4 +487,355 @@
     };
 
 
+    /**
+     * Bounding-box iterator over unknown space. Instead of existing nodes,
+     * this iterator returns the missing children of existing inner nodes
+     * (or the root volume of an empty tree) as maximal unknown cubes that
+     * overlap a given bounding box. The traversal only visits existing nodes,
+     * so its run time is proportional to the size of the tree inside of the box
+     * rather than its volume. See below for example usage.
+     *
+     * There is no node for an unknown cube, so the dereference operators
+     * return NULL. Use getCoordinate(), getSize(), getKey() and getDepth()
+     * to access the volume instead. With a depth limit, nodes at that depth
+     * are considered known (even if parts of their subtree are not).
+     * Note that the non-trivial call to tree->end_unknown_bbx() should be done only once
+     * for efficiency!
+     *
+     * @code
+     * for(OcTreeTYPE::unknown_bbx_iterator it = tree->begin_unknown_bbx(min,max),
+     *        end=tree->end_unknown_bbx(); it!= end; ++it)
+     * {
+     *   std::cout << "Unknown cube center: " << it.getCoordinate() << std::endl;
+     *   std::cout << "Unknown cube size: " << it.getSize() << std::endl;
+     * }
+     * @endcode
+     */
+    class unknown_bbx_iterator : public iterator_base {
+    public:
+      unknown_bbx_iterator() : iterator_base() {};
+      /**
+      * Constructor of the iterator. The bounding box corners min and max are
+      * converted into an OcTreeKey first.
+      *
+      * @param tree OcTreeBaseImpl on which the iterator is used on
+      * @param min Minimum point3d of the axis-aligned boundingbox
+      * @param max Maximum point3d of the axis-aligned boundingbox
+      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
+      */
+      unknown_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* tree, const point3d& min, const point3d& max, uint8_t depth=0)
+        : iterator_base(tree, depth)
+      {
+        if (tree && tree->coordToKeyChecked(min, minKey) && tree->coordToKeyChecked(max, maxKey)){
+          init(tree, depth);
+        } else {
+          // coordinates invalid, set to end iterator
+          while (!this->stack.empty())
+            this->stack.pop();
+          this->tree = NULL;
+          this->maxDepth = 0;
+        }
+      }
+
+      /**
+      * Constructor of the iterator. This version uses the exact keys as axis-aligned
+      * bounding box (including min and max).
+      *
+      * @param tree OcTreeBaseImpl on which the iterator is used on
+      * @param min Minimum OcTreeKey to be included in the axis-aligned boundingbox
+      * @param max Maximum OcTreeKey to be included in the axis-aligned boundingbox
+      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
+      */
+      unknown_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* tree, const OcTreeKey& min, const OcTreeKey& max, uint8_t depth=0)
+        : iterator_base(tree, depth), minKey(min), maxKey(max)
+      {
+        if (tree)
+          init(tree, depth);
+      }
+
+      unknown_bbx_iterator(const unknown_bbx_iterator& other) : iterator_base(other) {
+        minKey = other.minKey;
+        maxKey = other.maxKey;
+      }
+
+      /// postfix increment operator of iterator (it++)
+      unknown_bbx_iterator operator++(int){
+        unknown_bbx_iterator result = *this;
+        ++(*this);
+        return result;
+      }
+
+      /// prefix increment operator of iterator (++it)
+      unknown_bbx_iterator& operator++(){
+        if (this->stack.empty()){
+          this->tree = NULL; // TODO check?
+
+        } else {
+          this->stack.pop();
+
+          // skip forward to next unknown cube
+          while(!this->stack.empty() && this->stack.top().node != NULL){
+            if (this->stack.top().depth < this->maxDepth
+                && this->tree->nodeHasChildren(this->stack.top().node))
+              this->singleIncrement();
+            else // known leaf
+              this->stack.pop();
+          }
+          // done: either stack is empty (== end iterator) or a next unknown cube is reached!
+          if (this->stack.empty())
+            this->tree = NULL;
+        }
+
+        return *this;
+      };
+
+    protected:
+
+      void init(OcTreeBaseImpl<NodeType,INTERFACE> const* tree, uint8_t depth){
+        if (this->stack.empty()){
+          // empty tree: the complete volume is unknown
+          typename iterator_base::StackElement s;
+          s.node = NULL;
+          s.depth = 0;
+          s.key[0] = s.key[1] = s.key[2] = tree->tree_max_val;
+          this->stack.push(s);
+          this->tree = tree;
+          this->maxDepth = (depth == 0) ? tree->getTreeDepth() : depth;
+        } else {
+          // advance from root to next unknown cube in bbx:
+          this->stack.push(this->stack.top());
+          this->operator ++();
+        }
+      }
+
+      void singleIncrement(){
+        typename iterator_base::StackElement top = this->stack.top();
+        this->stack.pop();
+
+        typename iterator_base::StackElement s;
+        s.depth = top.depth +1;
+        key_type center_offset_key = this->tree->tree_max_val >> s.depth;
+        // push on stack in reverse order
+        for (int i=7; i>=0; --i) {
+          computeChildKey(i, center_offset_key, top.key, s.key);
+
+          // overlap of query bbx and child bbx?
+          if ((minKey[0] <= (s.key[0] + center_offset_key)) && (maxKey[0] >= (s.key[0] - center_offset_key))
+              && (minKey[1] <= (s.key[1] + center_offset_key)) && (maxKey[1] >= (s.key[1] - center_offset_key))
+              && (minKey[2] <= (s.key[2] + center_offset_key)) && (maxKey[2] >= (s.key[2] - center_offset_key)))
+          {
+            // missing children are pushed as unknown (NULL) cubes
+            if (this->tree->nodeChildExists(top.node, i))
+              s.node = this->tree->getNodeChild(top.node, i);
+            else
+              s.node = NULL;
+            this->stack.push(s);
+            assert(s.depth <= this->maxDepth);
+          }
+        }
+      }
+
+
+      OcTreeKey minKey;
+      OcTreeKey maxKey;
+    };
+
+    /**
+     * Frustum leaf iterator. This iterator will traverse all leaf nodes
+     * that intersect a view frustum, e.g. the field of view of a camera,
+     * given by a sensor pose, horizontal and vertical opening angles and
+     * a near and far clipping distance. See below for example usage.
+     *
+     * Subtrees completely outside of one of the frustum planes are skipped,
+     * subtrees completely inside of the frustum are traversed without
+     * any further intersection tests. The test is conservative: a node is
+     * traversed if its bounding box is not fully outside of all six planes,
+     * so a few nodes close to the frustum edges may be returned although
+     * they do not intersect it.
+     * Note that the non-trivial call to tree->end_leafs_frustum() should
+     * be done only once for efficiency!
+     *
+     * @code
+     * for(OcTreeTYPE::leaf_frustum_iterator it = tree->begin_leafs_frustum(pose, fov_h, fov_v, near, far),
+     *        end=tree->end_leafs_frustum(); it!= end; ++it)
+     * {
+     *   //manipulate node, e.g.:
+     *   std::cout << "Node center: " << it.getCoordinate() << std::endl;
+     *   std::cout << "Node size: " << it.getSize() << std::endl;
+     *   std::cout << "Node value: " << it->getValue() << std::endl;
+     * }
+     * @endcode
+     */
+    class leaf_frustum_iterator : public iterator_base {
+    public:
+      leaf_frustum_iterator() : iterator_base() {};
+      /**
+      * Constructor of the iterator. The frustum is given in the sensor frame
+      * with the x-axis as viewing direction, y to the left and z upwards
+      * (the convention of octomap scans) and transformed by sensor_pose.
+      *
+      * @param tree OcTreeBaseImpl on which the iterator is used on
+      * @param sensor_pose Origin and orientation of the frustum
+      * @param fov_h Full horizontal opening angle (radians, < pi)
+      * @param fov_v Full vertical opening angle (radians, < pi)
+      * @param min_range Distance of the near plane along the viewing direction
+      * @param max_range Distance of the far plane along the viewing direction
+      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
+      */
+      leaf_frustum_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* tree, const pose6d& sensor_pose,
+                            double fov_h, double fov_v, double min_range, double max_range, uint8_t depth=0)
+        : iterator_base(tree, depth)
+      {
+        // tree could be empty (= no stack)
+        if (this->stack.size() > 0){
+          computePlanes(sensor_pose, fov_h, fov_v, min_range, max_range);
+
+          uint8_t rootMask = ALL_PLANES;
+          if (!testNode(this->stack.top(), rootMask)){
+            // frustum does not touch the tree at all, set to end iterator
+            this->stack.pop();
+            this->tree = NULL;
+            this->maxDepth = 0;
+          } else {
+            // advance from root to next valid leaf in frustum:
+            masks.push(rootMask);
+            this->stack.push(this->stack.top());
+            masks.push(rootMask);
+            this->operator ++();
+          }
+        }
+      }
+
+      leaf_frustum_iterator(const leaf_frustum_iterator& other) : iterator_base(other), masks(other.masks) {
+        for (unsigned int i = 0; i < 6; ++i){
+          planeNormals[i] = other.planeNormals[i];
+          planeOffsets[i] = other.planeOffsets[i];
+        }
+      }
+
+      leaf_frustum_iterator& operator=(const leaf_frustum_iterator& other){
+        iterator_base::operator=(other);
+        masks = other.masks;
+        for (unsigned int i = 0; i < 6; ++i){
+          planeNormals[i] = other.planeNormals[i];
+          planeOffsets[i] = other.planeOffsets[i];
+        }
+        return *this;
+      }
+
+      /// postfix increment operator of iterator (it++)
+      leaf_frustum_iterator operator++(int){
+        leaf_frustum_iterator result = *this;
+        ++(*this);
+        return result;
+      }
+
+      /// prefix increment operator of iterator (++it)
+      leaf_frustum_iterator& operator++(){
+        if (this->stack.empty()){
+          this->tree = NULL; // TODO check?
+
+        } else {
+          this->stack.pop();
+          masks.pop();
+
+          // skip forward to next leaf
+          while(!this->stack.empty()
+              && this->stack.top().depth < this->maxDepth
+              && this->tree->nodeHasChildren(this->stack.top().node))
+          {
+            this->singleIncrement();
+          }
+          // done: either stack is empty (== end iterator) or a next leaf node is reached!
+          if (this->stack.empty())
+            this->tree = NULL;
+        }
+
+        return *this;
+      };
+
+    protected:
+      /// bit mask with one bit for each of the six frustum planes
+      static const uint8_t ALL_PLANES = 0x3F;
+
+      void singleIncrement(){
+        typename iterator_base::StackElement top = this->stack.top();
+        this->stack.pop();
+        uint8_t topMask = masks.top();
+        masks.pop();
+
+        typename iterator_base::StackElement s;
+        s.depth = top.depth +1;
+        key_type center_offset_key = this->tree->tree_max_val >> s.depth;
+        // push on stack in reverse order
+        for (int i=7; i>=0; --i) {
+          if (this->tree->nodeChildExists(top.node, i)) {
+            computeChildKey(i, center_offset_key, top.key, s.key);
+
+            // parent completely inside: no more tests needed for the subtree
+            uint8_t childMask = topMask;
+            if (childMask == 0 || testNode(s, childMask)){
+              s.node = this->tree->getNodeChild(top.node, i);
+              this->stack.push(s);
+              masks.push(childMask);
+              assert(s.depth <= this->maxDepth);
+            }
+          }
+        }
+      }
+
+      /// sets up the six inward-facing frustum planes in world coordinates
+      void computePlanes(const pose6d& sensor_pose, double fov_h, double fov_v,
+                         double min_range, double max_range){
+        const double sh = sin(0.5*fov_h), ch = cos(0.5*fov_h);
+        const double sv = sin(0.5*fov_v), cv = cos(0.5*fov_v);
+
+        point3d normals[6] = {
+          point3d(1.0f, 0.0f, 0.0f),                          // near
+          point3d(-1.0f, 0.0f, 0.0f),                         // far
+          point3d((float) sh, (float) -ch, 0.0f),             // left
+          point3d((float) sh, (float) ch, 0.0f),              // right
+          point3d((float) sv, 0.0f, (float) -cv),             // top
+          point3d((float) sv, 0.0f, (float) cv)               // bottom
+        };
+        const point3d& origin = sensor_pose.trans();
+        for (unsigned int i = 0; i < 6; ++i){
+          planeNormals[i] = sensor_pose.rot().rotate(normals[i]);
+          planeOffsets[i] = -planeNormals[i].dot(origin);
+        }
+        planeOffsets[0] -= min_range;
+        planeOffsets[1] += max_range;
+      }
+
+      /**
+       * Tests the bounding box of a node against all planes in mask. Planes
+       * that the box is completely inside of are removed from mask.
+       *
+       * @return false if the box is completely outside of one plane
+       */
+      bool testNode(const typename iterator_base::StackElement& s, uint8_t& mask) const {
+        const double halfSize = 0.5 * this->tree->getNodeSize(s.depth);
+        const point3d center = this->tree->keyToCoord(s.key, s.depth);
+        for (unsigned int i = 0; i < 6; ++i){
+          if (!(mask & (1 << i)))
+            continue;
+
+          const point3d& n = planeNormals[i];
+          double dist = n.dot(center) + planeOffsets[i];
+          double radius = halfSize * (fabs(n.x()) + fabs(n.y()) + fabs(n.z()));
+          if (dist < -radius)
+            return false;
+          else if (dist >= radius)
+            mask &= ~(1 << i);
+        }
+        return true;
+      }
+
+      point3d planeNormals[6];
+      double planeOffsets[6];
+      /// remaining planes to test, parallel to the node stack
+      FixedStack<uint8_t, iterator_base::STACK_CAPACITY> masks;
+    };
+
+
 #endif /* OCTREEITERATOR_HXX_ */
@@ -80,16 +80,47 @@ namespace octomap {
     float getMaxChildLogOdds() const;
 
     /// update this node's occupancy according to its children's maximum occupancy
+    /// and the summary flags of its subtree
     inline void updateOccupancyChildren() {
       this->setLogOdds(this->getMaxChildLogOdds());  // conservative
+      this->updateHasUnknown();
     }
 
+    /// Copy the payload (log odds occupancy and summary flags) from rhs into this node
+    inline void copyData(const OcTreeNode& from){
+      value = from.value;
+      flags = from.flags;
+    }
+
+
+    // -- subtree summary  ----------------------------
+
+    /**
+     * @return true if the subtree below this node contains unknown space, i.e.,
+     * one of its inner nodes is missing a child. Always false for leafs.
+     * Together with the maximum occupancy stored in inner nodes, this tells
+     * whether a subtree is completely free, contains occupied or unknown space.
+     * Maintained by updateOccupancyChildren(), so it is only valid when the
+     * inner nodes are up to date (see OccupancyOcTreeBase::updateInnerOccupancy()).
+     */
+    inline bool hasUnknown() const { return (flags & HAS_UNKNOWN) != 0; }
+
+    /// recomputes the unknown space flag of this node from its children
+    void updateHasUnknown();
+
     /// adds p to the node's logOdds value (with no boundary / threshold checking!)
     void addValue(const float& p);
     
 
   protected:
+    enum SummaryFlags { HAS_UNKNOWN = 1 };
+    /// number of low bits of flags used for the summary flags, the others
+    /// are free for the data of derived node types (see OcTreeNodeStamped)
+    static const unsigned int NUM_SUMMARY_FLAG_BITS = 1;
+
     // "value" stores log odds occupancy probability
+    /// summary of the subtree below this node (fits into the padding after "value")
+    uint32_t flags;
   };
 
 } // end namespace
@@ -42,35 +42,36 @@
 namespace octomap {
   
   // node definition
+  /**
+   * Node of an OcTreeStamped. The timestamp is kept in the upper 31 bits of
+   * the summary flags of OcTreeNode, so that the node is as large as an
+   * OcTreeNode. It thus covers the same range as a signed 32 bit time_t
+   * (until 2038), and is copied by copyData() together with the flags.
+   */
   class OcTreeNodeStamped : public OcTreeNode {    
 
   public:
-    OcTreeNodeStamped() : OcTreeNode(), timestamp(0) {}
+    OcTreeNodeStamped() : OcTreeNode() {}
 
-    OcTreeNodeStamped(const OcTreeNodeStamped& rhs) : OcTreeNode(rhs), timestamp(rhs.timestamp) {}
+    OcTreeNodeStamped(const OcTreeNodeStamped& rhs) : OcTreeNode(rhs) {}
 
     bool operator==(const OcTreeNodeStamped& rhs) const{
-      return (rhs.value == value && rhs.timestamp == timestamp);
-    }
-    
-    void copyData(const OcTreeNodeStamped& from){
-      OcTreeNode::copyData(from);
-      timestamp = from.getTimestamp();
+      return (rhs.value == value && rhs.getTimestamp() == getTimestamp());
     }
       
     // timestamp
-    inline unsigned int getTimestamp() const { return timestamp; }
-    inline void updateTimestamp() { timestamp = (unsigned int) time(NULL);}
-    inline void setTimestamp(unsigned int timestamp) {this->timestamp = timestamp; }
+    inline unsigned int getTimestamp() const { return flags >> NUM_SUMMARY_FLAG_BITS; }
+    inline void updateTimestamp() { setTimestamp((unsigned int) time(NULL)); }
+    inline void setTimestamp(unsigned int timestamp) {
+      flags = (flags & ((1u << NUM_SUMMARY_FLAG_BITS) - 1)) | (uint32_t(timestamp) << NUM_SUMMARY_FLAG_BITS);
+    }
 
     // update occupancy and timesteps of inner nodes 
     inline void updateOccupancyChildren() {      
       this->setLogOdds(this->getMaxChildLogOdds());  // conservative
+      this->updateHasUnknown();
       updateTimestamp();
     }
-
-  protected:
-    unsigned int timestamp;
   };
 
 
@@ -96,6 +97,10 @@ namespace octomap {
     void integrateMissNoTime(OcTreeNodeStamped* node) const;
 
   protected:
+    /// pages out the timestamps together with the occupancy (see enablePaging())
+    virtual void writePagedNode(const OcTreeNodeStamped* node, std::ostream& s) const;
+    virtual void readPagedNode(OcTreeNodeStamped* node, std::istream& s) const;
+
     /**
      * Static member object which ensures that this OcTree's prototype
      * ends up in the classIDMapping only once. You need this as a 
@@ -43,6 +43,7 @@
 #include "octomap_utils.h"
 #include "OcTreeBaseImpl.h"
 #include "AbstractOccupancyOcTree.h"
+#include "PrefixCoder.h"
 
 
 namespace octomap {
@@ -263,6 +264,7 @@ namespace octomap {
      * Creates the maximum likelihood map by calling toMaxLikelihood on all
      * tree nodes, setting their occupancy to the corresponding occupancy thresholds.
      * This enables a very efficient compression if you call prune() afterwards.
+     * All nodes are converted in a single pass, with OpenMP in parallel.
      */
     virtual void toMaxLikelihood();
 
@@ -302,6 +304,33 @@ namespace octomap {
     virtual bool castRay(const point3d& origin, const point3d& direction, point3d& end,
                  bool ignoreUnknownCells=false, double maxRange=-1.0) const;
 
+    /**
+     * Checks the line of sight between two points. The voxels on the line are
+     * traversed in the same order as by computeRayKeys(), but on the fly and
+     * without a KeyRay: the traversal stops at the first blocking voxel, and
+     * voxels inside the same coarse (pruned) free or unknown node as the
+     * previous voxel are passed without another lookup. The voxels
+     * containing a and b themselves are not checked.
+     *
+     * @param[in] a start point
+     * @param[in] b end point
+     * @param[in] treatUnknownAsBlocked whether unknown voxels block the line of sight
+     * @return true if no occupied (or unknown, if treated as blocked) voxel lies between a and b.
+     *   false if a or b is out of the map bounds.
+     */
+    bool isLineOfSight(const point3d& a, const point3d& b, bool treatUnknownAsBlocked = false) const;
+
+    /**
+     * Checks the line of sight for many point pairs, see above. The pairs are
+     * processed in parallel if OpenMP is enabled.
+     *
+     * @param[in] pairs start and end points
+     * @param[out] visible result for each pair
+     * @param[in] treatUnknownAsBlocked whether unknown voxels block the line of sight
+     */
+    void isLineOfSight(const std::vector<std::pair<point3d, point3d> >& pairs, std::vector<bool>& visible,
+                       bool treatUnknownAsBlocked = false) const;
+
     /**
      * Retrieves the entry point of a ray into a voxel. This is the closest intersection point of the ray
      * originating from origin and a plane of the axis aligned cube.
@@ -327,6 +356,222 @@ namespace octomap {
 		 * @return True if the input voxel is known in the occupancy grid, and false if it is unknown.
 		 */
 		bool getNormals(const point3d& point, std::vector<point3d>& normals, bool unknownStatus=true) const;
+
+    /**
+     * Extracts the surface between occupied and free space of the whole map as an
+     * indexed triangle mesh. This uses the same marching cubes step (MCTables.h) and
+     * conventions as getNormals(): cube corners are the voxel centers at the finest
+     * resolution and triangle vertices are the edge midpoints (no interpolation).
+     * Only cubes at the border of leaf nodes are evaluated (in parallel with OpenMP),
+     * faces of large leafs only where the adjacent space has a different state.
+     * The eight corners of a cube are looked up with a single descent to their
+     * common ancestor, there is no cache between cubes.
+     *
+     * @param[out] vertices Mesh vertices, shared between adjacent triangles
+     * @param[out] normals Vertex normals (normalized sum of the adjacent face normals, pointing to free space)
+     * @param[out] triangles Three vertex indices per triangle, counter-clockwise seen from free space
+     * @param[in] unknownStatus consider unknown cells as free (false) or occupied (default, true).
+     */
+    void extractSurfaceMesh(std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                            std::vector<unsigned int>& triangles, bool unknownStatus=true) const;
+
+    /**
+     * Extracts the surface mesh in a bounding box only, i.e. from all cubes whose
+     * minimum corner voxel lies in the box. See extractSurfaceMesh() above.
+     *
+     * @return false if the bounding box is out of the tree bounds
+     */
+    bool extractSurfaceMesh(const point3d& bbx_min, const point3d& bbx_max,
+                            std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                            std::vector<unsigned int>& triangles, bool unknownStatus=true) const;
+
+    /// Extracts the surface mesh from all cubes whose minimum corner key lies between
+    /// min_key and max_key (inclusive). See extractSurfaceMesh() above.
+    void extractSurfaceMesh(const OcTreeKey& min_key, const OcTreeKey& max_key,
+                            std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                            std::vector<unsigned int>& triangles, bool unknownStatus=true) const;
+
+    //-- nearest neighbor queries
+
+    /// Occupied leaf node returned by getKNearestOccupied() and getOccupiedInRadius()
+    struct OccupiedNeighbor {
+      NODE* node;
+      OcTreeKey key;
+      unsigned int depth;
+      point3d center; ///< center of the node's volume
+      double size;    ///< side length of the node's volume
+      double distance; ///< distance from the query point to the node's volume (0 if inside)
+    };
+
+    /**
+     * Best-first search for the k occupied leaf nodes closest to a query point.
+     * Subtrees are visited in the order of the distance to their bounding box,
+     * and subtrees whose inner node is not occupied (i.e. all of the subtree is
+     * free) are skipped entirely. Inner node occupancy needs to be up to date,
+     * call updateInnerOccupancy() after lazy updates.
+     *
+     * @param[in] query Query point
+     * @param[in] k Maximum number of neighbors to return
+     * @param[out] neighbors Closest occupied leafs, sorted by increasing distance
+     * @param[in] maxDistance Only return nodes closer than this (< 0: no limit, default)
+     * @return number of neighbors found
+     */
+    size_t getKNearestOccupied(const point3d& query, unsigned int k, std::vector<OccupiedNeighbor>& neighbors,
+                               double maxDistance=-1.0) const;
+
+    /**
+     * Finds all occupied leaf nodes whose volume is within radius of a query point.
+     * Subtrees are pruned by their bounding box and skipped if they are completely free,
+     * see getKNearestOccupied().
+     *
+     * @param[in] query Query point
+     * @param[in] radius Search radius
+     * @param[out] neighbors Occupied leafs within radius (unsorted)
+     * @return number of neighbors found
+     */
+    size_t getOccupiedInRadius(const point3d& query, double radius, std::vector<OccupiedNeighbor>& neighbors) const;
+
+    //-- region predicates
+
+    /**
+     * Region predicates on an axis-aligned bounding box. They use the summary of
+     * inner nodes (maximum occupancy and OcTreeNode::hasUnknown()): subtrees that
+     * are completely inside the box are answered without descending into them,
+     * and free or fully known subtrees are skipped, so the cost depends on the
+     * surface of the box rather than its volume. Parts of the box outside of the
+     * map count as unknown. Inner nodes need to be up to date, call
+     * updateInnerOccupancy() after lazy updates.
+     */
+    /// @return true if all of the bounding box is known and free
+    bool isBBXFree(const point3d& min, const point3d& max) const;
+    /// @return true if all voxels between min and max (inclusive) are known and free
+    bool isBBXFree(const OcTreeKey& min, const OcTreeKey& max) const;
+    /// @return true if an occupied node intersects the bounding box
+    bool hasOccupiedInBBX(const point3d& min, const point3d& max) const;
+    /// @return true if an occupied node intersects the keys between min and max (inclusive)
+    bool hasOccupiedInBBX(const OcTreeKey& min, const OcTreeKey& max) const;
+    /// @return true if any part of the bounding box is unknown
+    bool hasUnknownInBBX(const point3d& min, const point3d& max) const;
+    /// @return true if any voxel between min and max (inclusive) is unknown
+    bool hasUnknownInBBX(const OcTreeKey& min, const OcTreeKey& max) const;
+
+    //-- bounding box editing
+
+    /**
+     * Deletes everything inside the axis-aligned box, which becomes unknown.
+     * Subtrees completely inside the box are removed at once and only nodes on
+     * the boundary of the box are expanded, the inner nodes above are updated
+     * once on the way back up. Deletions are not reported to change detection.
+     * @return false if the box does not intersect the map
+     */
+    bool deleteAABB(const point3d& min, const point3d& max);
+    /// deletes all voxels between min and max (inclusive), see deleteAABB(const point3d&, const point3d&)
+    virtual void deleteAABB(const OcTreeKey& min, const OcTreeKey& max);
+
+    /**
+     * Sets all of the axis-aligned box (including unknown space) to the log-odds
+     * value, clamped to the clamping thresholds. Subtrees completely inside the
+     * box are replaced by a single leaf and only nodes on the boundary of the
+     * box are expanded. Changes are not reported to change detection.
+     * @return false if the box does not intersect the map
+     */
+    bool setAABB(const point3d& min, const point3d& max, float log_odds_value);
+    /// sets all voxels between min and max (inclusive), see setAABB(const point3d&, const point3d&, float)
+    virtual void setAABB(const OcTreeKey& min, const OcTreeKey& max, float log_odds_value);
+
+    //-- collision checks
+
+    /**
+     * Collision checks of geometric shapes against the map. Only nodes which
+     * overlap the shape are visited, free subtrees are skipped based on the
+     * summary of inner nodes, and the search stops at the first occupied leaf.
+     * Unknown space overlapping the shape is a collision if unknownIsOccupied
+     * is set. Inner nodes need to be up to date, call updateInnerOccupancy()
+     * after lazy updates.
+     */
+    /// @return true if the sphere intersects occupied space
+    bool collidesWithSphere(const point3d& center, double radius, bool unknownIsOccupied = false) const;
+    /// @return true if the capsule from p1 to p2 (= the volume swept by a sphere moving along the segment) intersects occupied space
+    bool collidesWithCapsule(const point3d& p1, const point3d& p2, double radius, bool unknownIsOccupied = false) const;
+    /// @return true if the box with center, orientation and half side lengths (along its own axes) intersects occupied space
+    bool collidesWithOBB(const point3d& center, const octomath::Quaternion& rotation, const point3d& half_extents,
+                         bool unknownIsOccupied = false) const;
+
+    /**
+     * Checks a whole trajectory of a sphere moving along waypoints, i.e., the
+     * capsules between all consecutive waypoints (see collidesWithCapsule()).
+     * @return index i of the first segment (waypoints[i] to waypoints[i+1]) in collision, -1 if free
+     */
+    int checkTrajectory(const std::vector<point3d>& waypoints, double radius, bool unknownIsOccupied = false) const;
+
+    //-- 2D projection
+
+    /// value written per cell by projectTo2D()
+    enum ProjectionMode {
+      PROJECT_OCCUPANCY,  ///< maximum occupancy probability in the column, -1 if all unknown
+      PROJECT_MIN_HEIGHT, ///< lower end of the lowest occupied voxel, NaN if none
+      PROJECT_MAX_HEIGHT  ///< upper end of the highest occupied voxel, NaN if none
+    };
+
+    /**
+     * Projects the map between min and max (inclusive) into a dense 2D grid
+     * at the finest resolution. The grid has width = max[0]-min[0]+1 columns
+     * and height = max[1]-min[1]+1 rows and is stored row by row, i.e., the
+     * cell of key (x, y) is grid[(y-min[1])*width + (x-min[0])]. Only voxels
+     * with a z key between min[2] and max[2] are projected. Coarse leafs fill
+     * all of their cells at once. With OpenMP, strips of the grid are
+     * processed in parallel.
+     *
+     * @param[in] min lower corner of the projected region
+     * @param[in] max upper corner of the projected region
+     * @param[in] mode value of the cells, see ProjectionMode
+     * @param[out] grid caller-provided buffer of width*height cells
+     */
+    void projectTo2D(const OcTreeKey& min, const OcTreeKey& max, ProjectionMode mode, float* grid) const;
+
+    /**
+     * Updates a projection computed by projectTo2D() with the same min, max and
+     * mode: only the columns of keys reported by change detection (see
+     * enableChangeDetection()) are projected again. The changed keys are not reset.
+     *
+     * Change detection only reports new voxels and changes of the occupancy
+     * state, which is all the height modes depend on. PROJECT_OCCUPANCY also
+     * depends on the occupancy values, so it is always projected completely.
+     * Deleted voxels are not reported either, after deleteNode() or
+     * deleteAABB() call projectTo2D() again.
+     */
+    void updateProjection2D(const OcTreeKey& min, const OcTreeKey& max, ProjectionMode mode, float* grid) const;
+
+    //-- Level of detail
+
+    /**
+     * Copies the map into lod with all nodes below depth collapsed into
+     * leafs at that depth. The collapsed leafs keep the aggregated data of
+     * the inner nodes (e.g., the maximum occupancy of their children), so
+     * the resulting tree is a coarse, smaller version of this one with the
+     * same resolution and sensor model. With OpenMP, the subtrees of the
+     * root are copied in parallel.
+     *
+     * @param depth depth of the leafs in lod (0: full depth, i.e., a plain copy)
+     * @param lod tree to fill, its previous content is cleared (must not be this tree)
+     */
+    void extractLOD(unsigned int depth, OccupancyOcTreeBase<NODE>& lod) const;
+
+    /**
+     * Copies the map into lod with a level of detail decreasing with the
+     * distance to focus: nodes closer than radius keep the full resolution,
+     * and every doubling of the distance beyond radius collapses one more
+     * level, but never above min_depth.
+     *
+     * @param focus point of full detail, e.g., the position of the robot
+     * @param radius distance up to which the full resolution is kept
+     * @param min_depth coarsest depth of the leafs in lod
+     * @param lod tree to fill, its previous content is cleared (must not be this tree)
+     */
+    void extractLOD(const point3d& focus, double radius, unsigned int min_depth,
+                    OccupancyOcTreeBase<NODE>& lod) const;
+
+
 	
     //-- set BBX limit (limits tree updates to this bounding box)
 
@@ -413,6 +658,25 @@ namespace octomap {
      */
     std::istream& readBinaryData(std::istream &s);
 
+    /**
+     * Reads only the data (=complete tree structure) from memory, e.g., a
+     * memory-mapped file, like readBinaryData(std::istream&) but without
+     * going through a stream for every node.
+     * @return number of bytes read
+     */
+    size_t readBinaryData(const char* data, size_t size);
+
+    /**
+     * Reads the node data (complete tree structure) from the input stream,
+     * see OcTreeBaseImpl::readData(), and restores the summary flags of the
+     * inner nodes which are not part of the stream.
+     */
+    std::istream& readData(std::istream &s);
+
+    /// Reads the node data in bulk layout, see OcTreeBaseImpl::readDataBulk(),
+    /// and restores the summary flags of the inner nodes like readData()
+    std::istream& readDataBulk(std::istream &s);
+
     /**
      * Read node from binary stream (max-likelihood value), recursively
      * continue with all children.
@@ -422,6 +686,13 @@ namespace octomap {
      */
     std::istream& readBinaryNode(std::istream &s, NODE* node);
 
+    /**
+     * Reads node from binary data in memory like readBinaryNode(std::istream&, NODE*),
+     * data is advanced past the node and its children.
+     * @return false if the data ends before the node is complete
+     */
+    bool readBinaryNode(const char*& data, const char* end, NODE* node);
+
     /**
      * Write node to binary stream (max-likelihood value),
      * recursively continue with all children.
@@ -441,6 +712,63 @@ namespace octomap {
      */
     std::ostream& writeBinaryData(std::ostream &s) const;
 
+    /**
+     * Appends the data of writeBinary() to data, i.e., the binary encoding of this
+     * tree after toMaxLikelihood() and prune(), without changing the tree. The
+     * subtrees of the root are encoded in parallel.
+     * @return number of nodes in the encoded tree
+     */
+    size_t writeBinarySnapshotData(std::string& data) const;
+
+    /**
+     * Writes the data of a compressed binary file (without header), see
+     * AbstractOccupancyOcTree::writeBinaryCompressed(): the 16 bit child codes
+     * of writeBinaryNode() are coded with two PrefixCodes computed for the tree,
+     * one for the parents of the lowest level and one for all other nodes.
+     * The subtrees of the root's children are coded as independent streams,
+     * so that they can be written and read in parallel.
+     */
+    std::ostream& writeBinaryCompressedData(std::ostream &s) const;
+
+    /**
+     * Reads the data of a compressed binary file (without header) from memory.
+     * @return number of bytes read
+     */
+    size_t readBinaryCompressedData(const char* data, size_t size);
+
+    /**
+     * Writes the subtrees at patch_depth which contain nodes changed since the
+     * last resetChangeDetection() (without header), see
+     * AbstractOccupancyOcTree::writeBinaryDelta(). Each subtree is stored with
+     * its key and written like writeBinaryNode(), or as a leaf or unknown if
+     * the tree is pruned or empty there.
+     */
+    std::ostream& writeBinaryDeltaData(std::ostream &s, unsigned int patch_depth) const;
+
+    /**
+     * Applies delta data written by writeBinaryDeltaData() to this tree by
+     * replacing the stored subtrees.
+     * @return false if the data is corrupted
+     */
+    bool readBinaryDeltaData(std::istream &s);
+
+    /**
+     * Writes the data of a chunked binary file (without header), see
+     * AbstractOccupancyOcTree::writeBinaryChunked(). The subtrees at chunk_depth
+     * (and leafs above) are encoded in parallel as separate chunks, preceded by
+     * an index with their offset, size and bounding box.
+     */
+    std::ostream& writeBinaryChunkedData(std::ostream &s, unsigned int chunk_depth) const;
+
+    /**
+     * Reads the data of a chunked binary file (without header) from memory. The
+     * chunks are decoded in parallel. If use_bbx is set, only the chunks
+     * overlapping the box between min and max are read.
+     * @return number of bytes read
+     */
+    size_t readBinaryChunkedData(const char* data, size_t size, bool use_bbx,
+                                 const point3d& min, const point3d& max);
+
 
     /**
      * Updates the occupancy of all inner nodes to reflect their children's occupancy.
@@ -484,8 +812,186 @@ namespace octomap {
 
     void updateInnerOccupancyRecurs(NODE* node, unsigned int depth);
     
+    /// converts node and all nodes below it down to max_depth, see toMaxLikelihood()
     void toMaxLikelihoodRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
 
+    /**
+     * Marching cubes index of the cube spanned by the finest-resolution voxels at key cube
+     * and cube+1 (corner order as in getNormals()). The corners are looked up with a single
+     * descent to their common ancestor.
+     */
+    int computeCubeIndex(const OcTreeKey& cube, bool unknownStatus) const;
+
+    /**
+     * Adds the cubes with minimum corner keys lo..hi (inclusive) to cube_keys (packed as
+     * in extractSurfaceMesh()), leaving out the parts where all corners are in state.
+     */
+    void collectSurfaceCubes(const int lo[3], const int hi[3], bool state, bool unknownStatus,
+                             std::vector<uint64_t>& cube_keys) const;
+
+    /// @return true if all voxels of the subtree of node (at key and depth) between min and max
+    /// (inclusive) are occupied (state true) or free, counting unknown voxels as unknownStatus
+    bool isBBXUniformRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                            const OcTreeKey& min, const OcTreeKey& max, bool state, bool unknownStatus) const;
+
+    /**
+     * Checks if the node at key and depth overlaps the keys between min and max (inclusive).
+     * @param[out] inside true if the node is completely inside
+     */
+    bool nodeOverlapsBBX(const OcTreeKey& key, unsigned int depth, const OcTreeKey& min,
+                         const OcTreeKey& max, bool& inside) const;
+
+    /// recursive call of deleteAABB(), @return true if node needs to be deleted by its parent
+    bool deleteAABBRecurs(NODE* node, const OcTreeKey& key, unsigned int depth,
+                          const OcTreeKey& min, const OcTreeKey& max);
+
+    /// recursive call of setAABB() for a node overlapping the box
+    void setAABBRecurs(NODE* node, bool node_just_created, const OcTreeKey& key, unsigned int depth,
+                       const OcTreeKey& min, const OcTreeKey& max, float log_odds_value);
+
+    /**
+     * Searches the subtree of node (at key and depth) within the keys min..max (inclusive)
+     * for occupied nodes (if occupied is set) or unknown space (if unknown is set).
+     * @return true if any was found
+     */
+    bool searchBBXRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                         const OcTreeKey& min, const OcTreeKey& max, bool occupied, bool unknown) const;
+
+    /// sets the cells of a projection in the key range min..max (x and y) to their initial value
+    void resetProjection2D(const OcTreeKey& min, const OcTreeKey& max, const OcTreeKey& grid_min,
+                           unsigned int width, ProjectionMode mode, float* grid) const;
+
+    /// projects the leafs between min and max into the grid starting at grid_min, see projectTo2D()
+    void projectLeafsTo2D(const OcTreeKey& min, const OcTreeKey& max, const OcTreeKey& grid_min,
+                          unsigned int width, ProjectionMode mode, float* grid) const;
+
+    /// child codes of node as in writeBinaryNode() (2 bits per child)
+    unsigned int getBinaryChildCodes(const NODE* node) const;
+
+    /// index of the PrefixCode for the child codes of a node at depth, see writeBinaryCompressedData()
+    unsigned int binaryCompressionCodeIndex(unsigned int depth) const { return depth + 1 >= this->tree_depth ? 1 : 0; }
+
+    /// adds the child codes of node and its inner children to counts (one vector per code index)
+    void countBinaryCompressedCodes(const NODE* node, unsigned int depth, std::vector<uint32_t>* counts) const;
+
+    /// writes the child codes of node and its inner children, see writeBinaryCompressedData()
+    void writeBinaryCompressedNode(BitWriter& writer, const PrefixCode* codes,
+                                   const NODE* node, unsigned int depth) const;
+
+    /// reads node and its children, @return false if the data is corrupted
+    bool readBinaryCompressedNode(BitReader& reader, const PrefixCode* codes,
+                                  NODE* node, unsigned int depth);
+
+    /**
+     * Appends the binary encoding of node (as in writeBinaryNode()) to data as if the
+     * tree was converted to maximum likelihood and pruned, see writeBinarySnapshotData().
+     * @return code of the node after pruning (1: free leaf, 2: occupied leaf, 3: inner node),
+     *   num_nodes is increased by the number of nodes below it
+     */
+    unsigned int writeBinarySnapshotNode(const NODE* node, std::string& data, size_t& num_nodes) const;
+
+    /// reads one subtree of delta data and replaces it in the tree, see readBinaryDeltaData()
+    bool readBinaryPatch(std::istream &s);
+
+    /// entry of the chunk index in a chunked binary file, see writeBinaryChunkedData()
+    struct BinaryChunk {
+      OcTreeKey key;
+      unsigned int depth;
+      /// 1: free leaf, 2: occupied leaf, 3: inner node (as in writeBinaryNode())
+      unsigned int state;
+      uint64_t offset;
+      uint64_t size;
+      point3d min;
+      point3d max;
+    };
+
+    /**
+     * collects the chunks below node at key and depth, see writeBinaryChunkedData().
+     * Chunks in a subtree which is paged out (or if encode_now) are encoded
+     * into payloads right away, their node is NULL; the other payloads are empty.
+     */
+    void collectBinaryChunksRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                                   unsigned int chunk_depth, std::vector<BinaryChunk>& chunks,
+                                   std::vector<const NODE*>& chunk_nodes,
+                                   std::vector<std::string>& payloads, bool encode_now) const;
+
+    /// updates occupancy and summary flags of the inner nodes above max_depth
+    void updateInnerOccupancyToDepthRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
+
+    /// decides which nodes are collapsed into leafs by extractLOD()
+    struct LODCriterion {
+      unsigned int max_depth;
+      unsigned int min_depth;
+      bool use_focus;
+      point3d focus;
+      double radius;
+      /// @return true if the node at key and depth becomes a leaf in the extracted tree
+      bool collapse(const OccupancyOcTreeBase<NODE>& tree, const OcTreeKey& key, unsigned int depth) const;
+    };
+
+    /// fills lod with a copy of the map collapsed according to criterion, see extractLOD()
+    void extractLOD(const LODCriterion& criterion, OccupancyOcTreeBase<NODE>& lod) const;
+
+    /// copies src at key and depth into the node dst of lod, @return number of nodes created below dst
+    size_t copyLODRecurs(const NODE* src, NODE* dst, const OcTreeKey& key, unsigned int depth,
+                         const LODCriterion& criterion, OccupancyOcTreeBase<NODE>& lod) const;
+
+    /// sphere for collision checks
+    struct CollisionSphere {
+      point3d center;
+      double sqr_radius;
+      /// @return true if the cube with center c and half side length h overlaps the shape
+      bool overlaps(const point3d& c, double h) const;
+    };
+
+    /// capsule for collision checks
+    struct CollisionCapsule {
+      point3d p1, p2;
+      double radius;
+      bool overlaps(const point3d& c, double h) const;
+      /// squared distance from the point a + t*b to the cube around the origin with half side length h
+      static double sqrDistanceToCube(const double a[3], const double b[3], double t, double h);
+    };
+
+    /// oriented box for collision checks
+    struct CollisionOBB {
+      point3d center;
+      point3d axes[3];
+      point3d half_extents;
+      bool overlaps(const point3d& c, double h) const;
+    };
+
+    /// @return true if the node at key and depth (NULL: unknown) contains a collision with the shape
+    template <class SHAPE>
+    bool collidesRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                        const SHAPE& shape, bool unknownIsOccupied) const;
+
+    /**
+     * Converts a metric bounding box to keys, clamped to the map.
+     * @return false if the box does not intersect the map
+     */
+    bool bbxToKeysClamped(const point3d& min, const point3d& max,
+                          OcTreeKey& min_key, OcTreeKey& max_key, bool& clamped) const;
+
+    /// recomputes OcTreeNode::hasUnknown() of all inner nodes below node
+    void updateHasUnknownRecurs(NODE* node);
+
+    /// restores the summary flags of a subtree read back from the page file
+    virtual void restorePagedSubtree(NODE* node) { updateHasUnknownRecurs(node); }
+
+    /// squared distance from a point to the volume of the node at key and depth (0 if inside)
+    double squaredDistanceToNode(const point3d& p, const OcTreeKey& key, unsigned int depth) const;
+
+    /// node on the queue of getKNearestOccupied()
+    struct NeighborCandidate {
+      NODE* node;
+      OcTreeKey key;
+      unsigned int depth;
+      double sqr_distance;
+      /// inverted ordering: the priority queue pops the closest candidate first
+      bool operator<(const NeighborCandidate& other) const { return sqr_distance > other.sqr_distance; }
+    };
+
 
   protected:
     bool use_bbx_limit;  ///< use bounding box for queries (needs to be set)?
@@ -32,7 +32,11 @@
  */
 
 #include <bitset>
+#include <cstring>
 #include <algorithm>
+#include <limits>
+#include <queue>
+#include <sstream>
 
 #include <octomap/MCTables.h>
 
@@ -74,11 +78,15 @@ namespace octomap {
 
   template <class NODE>
   void OccupancyOcTreeBase<NODE>::insertPointCloud(const ScanNode& scan, double maxrange, bool lazy_eval, bool discretize) {
+    // the scan of a lazily read graph is loaded here:
+    const Pointcloud* cloud = scan.getScan();
+    if (cloud == NULL)
+      return;
+
     // performs transformation to data and sensor origin first
-    Pointcloud& cloud = *(scan.scan);
     pose6d frame_origin = scan.pose;
     point3d sensor_origin = frame_origin.inv().transform(scan.pose.trans());
-    insertPointCloud(cloud, sensor_origin, frame_origin, maxrange, lazy_eval, discretize);
+    insertPointCloud(*cloud, sensor_origin, frame_origin, maxrange, lazy_eval, discretize);
   }
 
 
@@ -99,6 +107,10 @@ namespace octomap {
     for (KeySet::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
       updateNode(*it, true, lazy_eval);
     }
+
+    // each scan is an access period for paging
+    if (this->isPagingEnabled())
+      this->updatePaging();
   }
 
   template <class NODE>
@@ -142,6 +154,9 @@ namespace octomap {
       }
 
     }
+
+    if (this->isPagingEnabled())
+      this->updatePaging();
   }
 
   template <class NODE>
@@ -433,6 +448,9 @@ namespace octomap {
     bool created_node = false;
 
     assert(node);
+    // updateNode() records the access in search()
+    if (depth == this->page_depth && this->isPagingEnabled())
+      this->markPageAccess(node);
 
     // follow down to last level
     if (depth < this->tree_depth) {
@@ -492,8 +510,10 @@ namespace octomap {
 
   template <class NODE>
   void OccupancyOcTreeBase<NODE>::updateInnerOccupancy(){
-    if (this->root)
+    if (this->root){
       this->updateInnerOccupancyRecurs(this->root, 0);
+      this->updateAggregateData();
+    }
   }
 
   template <class NODE>
@@ -519,13 +539,16 @@ namespace octomap {
     if (this->root == NULL)
       return;
 
-    // convert bottom up
-    for (unsigned int depth=this->tree_depth; depth>0; depth--) {
-      toMaxLikelihoodRecurs(this->root, 0, depth);
+    // each node is converted on its own, so a single pass over all nodes suffices:
+    std::vector<NODE*> subtrees;
+    this->getNodesAtDepthRecurs(this->root, 0, this->parallel_subtree_depth, subtrees);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < (int) subtrees.size(); ++i) {
+      toMaxLikelihoodRecurs(subtrees[i], this->parallel_subtree_depth, this->tree_depth);
     }
-
-    // convert root
-    nodeToMaxLikelihood(this->root);
+    toMaxLikelihoodRecurs(this->root, 0, this->parallel_subtree_depth-1);
   }
 
   template <class NODE>
@@ -534,6 +557,7 @@ namespace octomap {
 
     assert(node);
 
+    nodeToMaxLikelihood(node);
     if (depth < max_depth) {
       for (unsigned int i=0; i<8; i++) {
         if (this->nodeChildExists(node, i)) {
@@ -541,10 +565,6 @@ namespace octomap {
         }
       }
     }
-
-    else { // max level reached
-      nodeToMaxLikelihood(node);
-    }
   }
   
   template <class NODE>
@@ -636,238 +656,1411 @@ namespace octomap {
   }
   
   template <class NODE>
-  bool OccupancyOcTreeBase<NODE>::castRay(const point3d& origin, const point3d& directionP, point3d& end, 
-                                          bool ignoreUnknown, double maxRange) const {
-
-    /// ----------  see OcTreeBase::computeRayKeys  -----------
-
-    // Initialization phase -------------------------------------------------------
-    OcTreeKey current_key;
-    if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::coordToKeyChecked(origin, current_key) ) {
-      OCTOMAP_WARNING_STR("Coordinates out of bounds during ray casting");
-      return false;
+  int OccupancyOcTreeBase<NODE>::computeCubeIndex(const OcTreeKey& cube, bool unknownStatus) const {
+    // corner order of getNormals(): (+x,+y), (+x,-y), (-x,-y), (-x,+y), bottom then top
+    static const int x_offset[8] = {1, 1, 0, 0, 1, 1, 0, 0};
+    static const int y_offset[8] = {1, 0, 0, 1, 1, 0, 0, 1};
+    static const int z_offset[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+    // descend once to the common ancestor of all corners (keys cube and cube+1)
+    NODE* node = this->root;
+    int level = int(this->tree_depth) - 1;
+    while (node != NULL && this->nodeHasChildren(node)){
+      if ((unsigned(cube[0]) >> level) != ((unsigned(cube[0]) + 1) >> level)
+          || (unsigned(cube[1]) >> level) != ((unsigned(cube[1]) + 1) >> level)
+          || (unsigned(cube[2]) >> level) != ((unsigned(cube[2]) + 1) >> level))
+        break;
+
+      unsigned int pos = computeChildIdx(cube, level);
+      node = this->nodeChildExists(node, pos) ? this->getNodeChild(node, pos) : NULL;
+      --level;
     }
 
-    NODE* startingNode = this->search(current_key);
-    if (startingNode){
-      if (this->isNodeOccupied(startingNode)){
-        // Occupied node found at origin 
-        // (need to convert from key, since origin does not need to be a voxel center)
-        end = this->keyToCoord(current_key);
-        return true;
+    // all corners in one leaf or unknown volume:
+    if (node == NULL)
+      return unknownStatus ? 255 : 0;
+    else if (!this->nodeHasChildren(node))
+      return this->isNodeOccupied(node) ? 255 : 0;
+
+    int cube_index = 0;
+    OcTreeKey corner;
+    for (unsigned int v = 0; v < 8; ++v){
+      corner[0] = key_type(cube[0] + x_offset[v]);
+      corner[1] = key_type(cube[1] + y_offset[v]);
+      corner[2] = key_type(cube[2] + z_offset[v]);
+
+      NODE* corner_node = node;
+      for (int l = level; corner_node != NULL && l >= 0 && this->nodeHasChildren(corner_node); --l){
+        unsigned int pos = computeChildIdx(corner, l);
+        corner_node = this->nodeChildExists(corner_node, pos) ? this->getNodeChild(corner_node, pos) : NULL;
       }
-    } else if(!ignoreUnknown){
-      end = this->keyToCoord(current_key);
-      return false;
+      if (corner_node != NULL ? this->isNodeOccupied(corner_node) : unknownStatus)
+        cube_index |= (1 << v);
     }
+    return cube_index;
+  }
 
-    point3d direction = directionP.normalized();
-    bool max_range_set = (maxRange > 0.0);
-
-    int step[3]; 
-    double tMax[3];
-    double tDelta[3];
-
-    for(unsigned int i=0; i < 3; ++i) {
-      // compute step direction
-      if (direction(i) > 0.0) step[i] =  1;
-      else if (direction(i) < 0.0)   step[i] = -1;
-      else step[i] = 0;
-
-      // compute tMax, tDelta
-      if (step[i] != 0) {
-        // corner point of voxel (in direction of ray)
-        double voxelBorder = this->keyToCoord(current_key[i]);
-        voxelBorder += double(step[i] * this->resolution * 0.5);
-
-        tMax[i] = ( voxelBorder - origin(i) ) / direction(i);
-        tDelta[i] = this->resolution / fabs( direction(i) );
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::collectSurfaceCubes(const int lo[3], const int hi[3], bool state, bool unknownStatus,
+                                                      std::vector<uint64_t>& cube_keys) const {
+    const uint64_t num_cubes = uint64_t(hi[0] - lo[0] + 1) * uint64_t(hi[1] - lo[1] + 1) * uint64_t(hi[2] - lo[2] + 1);
+    if (num_cubes > 64){
+      // no surface in the cubes if all of their corners (voxels lo..hi+1) have the same state:
+      OcTreeKey corner_min, corner_max;
+      for (unsigned int i = 0; i < 3; ++i){
+        corner_min[i] = key_type(lo[i]);
+        corner_max[i] = key_type(hi[i] + 1);
       }
-      else {
-        tMax[i] =  std::numeric_limits<double>::max();
-        tDelta[i] = std::numeric_limits<double>::max();
+      OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+      if (isBBXUniformRecurs(this->root, root_key, 0, corner_min, corner_max, state, unknownStatus))
+        return;
+
+      // split along the longest side:
+      unsigned int a = 0;
+      for (unsigned int i = 1; i < 3; ++i){
+        if (hi[i] - lo[i] > hi[a] - lo[a])
+          a = i;
       }
+      const int mid = lo[a] + (hi[a] - lo[a]) / 2;
+      int lower_hi[3] = {hi[0], hi[1], hi[2]};
+      int upper_lo[3] = {lo[0], lo[1], lo[2]};
+      lower_hi[a] = mid;
+      upper_lo[a] = mid + 1;
+      collectSurfaceCubes(lo, lower_hi, state, unknownStatus, cube_keys);
+      collectSurfaceCubes(upper_lo, hi, state, unknownStatus, cube_keys);
+      return;
     }
 
-    if (step[0] == 0 && step[1] == 0 && step[2] == 0){
-    	OCTOMAP_ERROR("Raycasting in direction (0,0,0) is not possible!");
-    	return false;
+    for (int cz = lo[2]; cz <= hi[2]; ++cz){
+      for (int cy = lo[1]; cy <= hi[1]; ++cy){
+        for (int cx = lo[0]; cx <= hi[0]; ++cx)
+          cube_keys.push_back((uint64_t(cz) << 32) | (uint64_t(cy) << 16) | uint64_t(cx));
+      }
     }
+  }
 
-    // for speedup:
-    double maxrange_sq = maxRange *maxRange;
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::isBBXUniformRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                                                     const OcTreeKey& min, const OcTreeKey& max,
+                                                     bool state, bool unknownStatus) const {
+    bool inside;
+    if (!nodeOverlapsBBX(key, depth, min, max, inside))
+      return true;
+    if (node == NULL)
+      return unknownStatus == state;
+    if (!this->nodeHasChildren(node))
+      return this->isNodeOccupied(node) == state;
+
+    OcTreeKey child_key;
+    key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      computeChildKey(i, center_offset_key, key, child_key);
+      const NODE* child = this->nodeChildExists(node, i) ? this->getNodeChild(node, i) : NULL;
+      if (!isBBXUniformRecurs(child, child_key, depth + 1, min, max, state, unknownStatus))
+        return false;
+    }
+    return true;
+  }
 
-    // Incremental phase  ---------------------------------------------------------
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::extractSurfaceMesh(std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                                                     std::vector<unsigned int>& triangles, bool unknownStatus) const {
+    const key_type max_val = key_type(2*this->tree_max_val - 1);
+    extractSurfaceMesh(OcTreeKey(0, 0, 0), OcTreeKey(max_val, max_val, max_val),
+                       vertices, normals, triangles, unknownStatus);
+  }
 
-    bool done = false;
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::extractSurfaceMesh(const point3d& bbx_min, const point3d& bbx_max,
+                                                     std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                                                     std::vector<unsigned int>& triangles, bool unknownStatus) const {
+    OcTreeKey min_key, max_key;
+    if (!this->coordToKeyChecked(bbx_min, min_key) || !this->coordToKeyChecked(bbx_max, max_key)){
+      OCTOMAP_ERROR_STR("Error in extractSurfaceMesh: bounding box out of tree bounds");
+      vertices.clear();
+      normals.clear();
+      triangles.clear();
+      return false;
+    }
+    extractSurfaceMesh(min_key, max_key, vertices, normals, triangles, unknownStatus);
+    return true;
+  }
 
-    while (!done) {
-      unsigned int dim;
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::extractSurfaceMesh(const OcTreeKey& min_key, const OcTreeKey& max_key,
+                                                     std::vector<point3d>& vertices, std::vector<point3d>& normals,
+                                                     std::vector<unsigned int>& triangles, bool unknownStatus) const {
+    vertices.clear();
+    normals.clear();
+    triangles.clear();
+    if (this->root == NULL)
+      return;
 
-      // find minimum tMax:
-      if (tMax[0] < tMax[1]){
-        if (tMax[0] < tMax[2]) dim = 0;
-        else                   dim = 2;
-      }
-      else {
-        if (tMax[1] < tMax[2]) dim = 1;
-        else                   dim = 2;
+    // A cube is spanned by the voxel centers of its minimum corner key c and c+1.
+    // Surface cubes have corners of both states. With unknown cells as occupied, each
+    // of them contains a free voxel, otherwise an occupied one. All cubes completely
+    // inside of a leaf are uniform, so only the shell of cubes around each leaf of
+    // that state needs to be evaluated, and only where it borders other states:
+    const bool seed_state = !unknownStatus;
+    const int max_corner = 2 * int(this->tree_max_val) - 2;
+    // cubes at the upper bbx border reach into the next voxel:
+    OcTreeKey leaf_max_key;
+    for (unsigned int i = 0; i < 3; ++i)
+      leaf_max_key[i] = key_type(std::min(int(max_key[i]) + 1, max_corner + 1));
+
+    // cubes as packed keys (z, y, x), sorted and made unique below:
+    std::vector<uint64_t> cube_keys;
+    for (typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::leaf_bbx_iterator it = this->begin_leafs_bbx(min_key, leaf_max_key),
+           end = this->end_leafs_bbx(); it != end; ++it){
+      if (this->isNodeOccupied(*it) != seed_state)
+        continue;
+
+      const OcTreeKey& key = it.getKey();
+      const int half = int(this->tree_max_val >> it.getDepth());
+      int leaf_lo[3], leaf_hi[3], lo[3], hi[3];
+      for (unsigned int i = 0; i < 3; ++i){
+        // the leaf spans the keys [leaf_lo, leaf_hi] (a single key at the lowest level)
+        leaf_lo[i] = (half > 0) ? int(key[i]) - half : int(key[i]);
+        leaf_hi[i] = (half > 0) ? int(key[i]) + half - 1 : int(key[i]);
+        // cubes touching the leaf, limited to the bbx
+        lo[i] = std::max(std::max(leaf_lo[i] - 1, 0), int(min_key[i]));
+        hi[i] = std::min(std::min(leaf_hi[i], max_corner), int(max_key[i]));
       }
 
-      // check for overflow:
-      if ((step[dim] < 0 && current_key[dim] == 0)
-    		  || (step[dim] > 0 && current_key[dim] == 2* this->tree_max_val-1))
-      {
-        OCTOMAP_WARNING("Coordinate hit bounds in dim %d, aborting raycast\n", dim);
-        // return border point nevertheless:
-        end = this->keyToCoord(current_key);
-        return false;
+      if (half <= 1){
+        // small leafs: all cubes of the shell
+        for (int cz = lo[2]; cz <= hi[2]; ++cz){
+          const bool inside_z = (cz >= leaf_lo[2] && cz < leaf_hi[2]);
+          for (int cy = lo[1]; cy <= hi[1]; ++cy){
+            const bool inside_yz = inside_z && (cy >= leaf_lo[1] && cy < leaf_hi[1]);
+            for (int cx = lo[0]; cx <= hi[0]; ++cx){
+              // skip the cubes in the interior of the leaf
+              if (inside_yz && cx >= leaf_lo[0] && cx < leaf_hi[0]){
+                cx = leaf_hi[0] - 1;
+                continue;
+              }
+              cube_keys.push_back((uint64_t(cz) << 32) | (uint64_t(cy) << 16) | uint64_t(cx));
+            }
+          }
+        }
+        continue;
       }
 
-      // advance in direction "dim"
-      current_key[dim] += step[dim];
-      tMax[dim] += tDelta[dim];
+      // larger leafs: the shell consists of one slab of cubes per face, each face
+      // is refined only where the space beyond it is not in the seed state
+      for (unsigned int a = 0; a < 3; ++a){
+        for (unsigned int side = 0; side < 2; ++side){
+          int slab_lo[3], slab_hi[3];
+          bool empty = false;
+          for (unsigned int i = 0; i < 3; ++i){
+            slab_lo[i] = lo[i];
+            slab_hi[i] = hi[i];
+            // edges and corners of the shell belong to the slab of the lower axis
+            if (i < a){
+              slab_lo[i] = std::max(slab_lo[i], leaf_lo[i]);
+              slab_hi[i] = std::min(slab_hi[i], leaf_hi[i] - 1);
+            }
+            empty = empty || slab_lo[i] > slab_hi[i];
+          }
+          const int c = side ? leaf_hi[a] : leaf_lo[a] - 1;
+          if (empty || c < lo[a] || c > hi[a])
+            continue;
+          slab_lo[a] = slab_hi[a] = c;
+          collectSurfaceCubes(slab_lo, slab_hi, seed_state, unknownStatus, cube_keys);
+        }
+      }
+    }
 
+    std::sort(cube_keys.begin(), cube_keys.end());
+    cube_keys.erase(std::unique(cube_keys.begin(), cube_keys.end()), cube_keys.end());
 
-      // generate world coords from key
-      end = this->keyToCoord(current_key);
+    // marching cubes step for each cube, vertex ids are the packed edge midpoints
+    // in doubled key coordinates:
+    std::vector<std::vector<uint64_t> > thread_vertex_ids;
+    std::vector<std::vector<point3d> > thread_face_normals;
+#ifdef _OPENMP
+    thread_vertex_ids.resize(omp_get_max_threads());
+    thread_face_normals.resize(omp_get_max_threads());
+    #pragma omp parallel
+#else
+    thread_vertex_ids.resize(1);
+    thread_face_normals.resize(1);
+#endif
+    {
+#ifdef _OPENMP
+      const int thread_idx = omp_get_thread_num();
+#else
+      const int thread_idx = 0;
+#endif
+      std::vector<uint64_t>& vertex_ids = thread_vertex_ids[thread_idx];
+      std::vector<point3d>& face_normals = thread_face_normals[thread_idx];
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic, 256)
+#endif
+      for (int c = 0; c < (int) cube_keys.size(); ++c){
+        const OcTreeKey cube(key_type(cube_keys[c]), key_type(cube_keys[c] >> 16), key_type(cube_keys[c] >> 32));
+        const int cube_index = computeCubeIndex(cube, unknownStatus);
 
-      // check for maxrange:
-      if (max_range_set){
-        double dist_from_origin_sq(0.0);
-        for (unsigned int j = 0; j < 3; j++) {
-          dist_from_origin_sq += ((end(j) - origin(j)) * (end(j) - origin(j)));
+        if (edgeTable[cube_index] == 0)
+          continue;
+
+        for (int i = 0; triTable[cube_index][i] != -1; i += 3){
+          point3d p[3];
+          for (unsigned int j = 0; j < 3; ++j){
+            p[j] = vertexList[triTable[cube_index][i+j]];
+            uint64_t id = 0;
+            for (unsigned int k = 0; k < 3; ++k)
+              id |= uint64_t(2 * int(cube[k]) + 1 + int(p[j](k))) << (20 * k);
+            vertex_ids.push_back(id);
+          }
+          face_normals.push_back((p[1] - p[0]).cross(p[2] - p[0]).normalize());
         }
-        if (dist_from_origin_sq > maxrange_sq)
-          return false;
-
       }
+    }
 
-      NODE* currentNode = this->search(current_key);
-      if (currentNode){
-        if (this->isNodeOccupied(currentNode)) {
-          done = true;
-          break;
+    // merge into the shared vertex list:
+    typedef unordered_ns::unordered_map<uint64_t, unsigned int> VertexIdMap;
+    VertexIdMap vertex_map;
+    const double half_res = 0.5 * this->resolution;
+    const int doubled_center = 2 * int(this->tree_max_val) - 1;
+    for (size_t t = 0; t < thread_vertex_ids.size(); ++t){
+      const std::vector<uint64_t>& vertex_ids = thread_vertex_ids[t];
+      const std::vector<point3d>& face_normals = thread_face_normals[t];
+      for (size_t i = 0; i < vertex_ids.size(); ++i){
+        std::pair<typename VertexIdMap::iterator, bool> inserted =
+            vertex_map.insert(std::make_pair(vertex_ids[i], (unsigned int) vertices.size()));
+        if (inserted.second){
+          point3d v;
+          for (unsigned int k = 0; k < 3; ++k)
+            v(k) = float((int((vertex_ids[i] >> (20 * k)) & 0xFFFFF) - doubled_center) * half_res);
+          vertices.push_back(v);
+          normals.push_back(point3d(0, 0, 0));
         }
-        // otherwise: node is free and valid, raycasting continues
-      } else if (!ignoreUnknown){ // no node found, this usually means we are in "unknown" areas
-        return false;
+        const unsigned int idx = inserted.first->second;
+        triangles.push_back(idx);
+        normals[idx] += face_normals[i / 3];
       }
-    } // end while
+    }
 
-    return true;
+    for (size_t i = 0; i < normals.size(); ++i){
+      if (normals[i].norm() > 0.0)
+        normals[i].normalize();
+    }
   }
 
   template <class NODE>
-  bool OccupancyOcTreeBase<NODE>::getRayIntersection (const point3d& origin, const point3d& direction, const point3d& center,
-                 point3d& intersection, double delta/*=0.0*/) const {
-    // We only need three normals for the six planes
-    octomap::point3d normalX(1, 0, 0);
-    octomap::point3d normalY(0, 1, 0);
-    octomap::point3d normalZ(0, 0, 1);
-
-    // One point on each plane, let them be the center for simplicity
-    octomap::point3d pointXNeg(center(0) - float(this->resolution / 2.0), center(1), center(2));
-    octomap::point3d pointXPos(center(0) + float(this->resolution / 2.0), center(1), center(2));
-    octomap::point3d pointYNeg(center(0), center(1) - float(this->resolution / 2.0), center(2));
-    octomap::point3d pointYPos(center(0), center(1) + float(this->resolution / 2.0), center(2));
-    octomap::point3d pointZNeg(center(0), center(1), center(2) - float(this->resolution / 2.0));
-    octomap::point3d pointZPos(center(0), center(1), center(2) + float(this->resolution / 2.0));
-
-    double lineDotNormal = 0.0;
-    double d = 0.0;
-    double outD = std::numeric_limits<double>::max();
-    octomap::point3d intersect;
-    bool found = false;
+  double OccupancyOcTreeBase<NODE>::squaredDistanceToNode(const point3d& p, const OcTreeKey& key,
+                                                          unsigned int depth) const {
+    const double half_size = 0.5 * this->getNodeSize(depth);
+    double sqr_dist = 0.0;
+    for (unsigned int i = 0; i < 3; ++i){
+      double d = fabs(p(i) - this->keyToCoord(key[i], depth)) - half_size;
+      if (d > 0.0)
+        sqr_dist += d*d;
+    }
+    return sqr_dist;
+  }
 
-    // Find the intersection (if any) with each place
-    // Line dot normal will be zero if they are parallel, in which case no intersection can be the entry one
-    // if there is an intersection does it occur in the bounded plane of the voxel
-    // if yes keep only the closest (smallest distance to sensor origin).
-    if((lineDotNormal = normalX.dot(direction))){
-      d = (pointXNeg - origin).dot(normalX) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6) ||
-         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::getKNearestOccupied(const point3d& query, unsigned int k,
+                                                        std::vector<OccupiedNeighbor>& neighbors,
+                                                        double maxDistance) const {
+    neighbors.clear();
+    if (this->root == NULL || k == 0 || !this->isNodeOccupied(this->root))
+      return 0;
+
+    const double max_sqr_dist = (maxDistance < 0.0) ? std::numeric_limits<double>::max() : maxDistance*maxDistance;
+
+    std::priority_queue<NeighborCandidate> queue;
+    NeighborCandidate c;
+    c.node = this->root;
+    c.key[0] = c.key[1] = c.key[2] = this->tree_max_val;
+    c.depth = 0;
+    c.sqr_distance = squaredDistanceToNode(query, c.key, 0);
+    queue.push(c);
+
+    while (!queue.empty() && neighbors.size() < k){
+      NeighborCandidate top = queue.top();
+      queue.pop();
+      if (top.sqr_distance > max_sqr_dist)
+        break;
+
+      if (!this->nodeHasChildren(top.node)){
+        // only occupied nodes are queued, and no other node can be closer:
+        OccupiedNeighbor n;
+        n.node = top.node;
+        n.key = top.key;
+        n.depth = top.depth;
+        n.center = this->keyToCoord(top.key, top.depth);
+        n.size = this->getNodeSize(top.depth);
+        n.distance = sqrt(top.sqr_distance);
+        neighbors.push_back(n);
+        continue;
       }
 
-      d = (pointXPos - origin).dot(normalX) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6) ||
-         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
+      c.depth = top.depth + 1;
+      key_type center_offset_key = this->tree_max_val >> c.depth;
+      for (unsigned int i = 0; i < 8; ++i){
+        if (!this->nodeChildExists(top.node, i))
+          continue;
+        c.node = this->getNodeChild(top.node, i);
+        // free subtree (max. occupancy of all children below threshold):
+        if (!this->isNodeOccupied(c.node))
+          continue;
+
+        computeChildKey(i, center_offset_key, top.key, c.key);
+        c.sqr_distance = squaredDistanceToNode(query, c.key, c.depth);
+        if (c.sqr_distance <= max_sqr_dist)
+          queue.push(c);
       }
     }
 
-    if((lineDotNormal = normalY.dot(direction))){
-      d = (pointYNeg - origin).dot(normalY) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
-         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
+    return neighbors.size();
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::getOccupiedInRadius(const point3d& query, double radius,
+                                                        std::vector<OccupiedNeighbor>& neighbors) const {
+    neighbors.clear();
+    if (this->root == NULL || radius < 0.0 || !this->isNodeOccupied(this->root))
+      return 0;
+
+    const double sqr_radius = radius*radius;
+    std::vector<NeighborCandidate> stack;
+    NeighborCandidate c;
+    c.node = this->root;
+    c.key[0] = c.key[1] = c.key[2] = this->tree_max_val;
+    c.depth = 0;
+    c.sqr_distance = squaredDistanceToNode(query, c.key, 0);
+    if (c.sqr_distance <= sqr_radius)
+      stack.push_back(c);
+
+    while (!stack.empty()){
+      NeighborCandidate top = stack.back();
+      stack.pop_back();
+
+      if (!this->nodeHasChildren(top.node)){
+        OccupiedNeighbor n;
+        n.node = top.node;
+        n.key = top.key;
+        n.depth = top.depth;
+        n.center = this->keyToCoord(top.key, top.depth);
+        n.size = this->getNodeSize(top.depth);
+        n.distance = sqrt(top.sqr_distance);
+        neighbors.push_back(n);
+        continue;
       }
 
-      d = (pointYPos - origin).dot(normalY) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
-         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
+      c.depth = top.depth + 1;
+      key_type center_offset_key = this->tree_max_val >> c.depth;
+      for (unsigned int i = 0; i < 8; ++i){
+        if (!this->nodeChildExists(top.node, i))
+          continue;
+        c.node = this->getNodeChild(top.node, i);
+        if (!this->isNodeOccupied(c.node))
+          continue;
+
+        computeChildKey(i, center_offset_key, top.key, c.key);
+        c.sqr_distance = squaredDistanceToNode(query, c.key, c.depth);
+        if (c.sqr_distance <= sqr_radius)
+          stack.push_back(c);
       }
     }
 
-    if((lineDotNormal = normalZ.dot(direction))){
-      d = (pointZNeg - origin).dot(normalZ) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
-         intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
-      }
+    return neighbors.size();
+  }
 
-      d = (pointZPos - origin).dot(normalZ) / lineDotNormal;
-      intersect = direction * float(d) + origin;
-      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
-         intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6))){
-        outD = std::min(outD, d);
-        found = true;
-      }
-    }
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::isBBXFree(const point3d& min, const point3d& max) const {
+    OcTreeKey min_key, max_key;
+    bool clamped;
+    if (!bbxToKeysClamped(min, max, min_key, max_key, clamped) || clamped)
+      return false;
+    return isBBXFree(min_key, max_key);
+  }
 
-    // Substract (add) a fraction to ensure no ambiguity on the starting voxel
-    // Don't start on a bondary.
-    if(found)
-      intersection = direction * float(outD + delta) + origin;
-    
-    return found;
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::isBBXFree(const OcTreeKey& min, const OcTreeKey& max) const {
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return !searchBBXRecurs(this->root, root_key, 0, min, max, true, true);
   }
 
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::hasOccupiedInBBX(const point3d& min, const point3d& max) const {
+    OcTreeKey min_key, max_key;
+    bool clamped;
+    if (!bbxToKeysClamped(min, max, min_key, max_key, clamped))
+      return false;
+    return hasOccupiedInBBX(min_key, max_key);
+  }
 
-  template <class NODE> inline bool 
-  OccupancyOcTreeBase<NODE>::integrateMissOnRay(const point3d& origin, const point3d& end, bool lazy_eval) {
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::hasOccupiedInBBX(const OcTreeKey& min, const OcTreeKey& max) const {
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return searchBBXRecurs(this->root, root_key, 0, min, max, true, false);
+  }
 
-    if (!this->computeRayKeys(origin, end, this->keyrays.at(0))) {
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::hasUnknownInBBX(const point3d& min, const point3d& max) const {
+    OcTreeKey min_key, max_key;
+    bool clamped;
+    if (!bbxToKeysClamped(min, max, min_key, max_key, clamped) || clamped)
+      return true;
+    return hasUnknownInBBX(min_key, max_key);
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::hasUnknownInBBX(const OcTreeKey& min, const OcTreeKey& max) const {
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return searchBBXRecurs(this->root, root_key, 0, min, max, false, true);
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::deleteAABB(const point3d& min, const point3d& max) {
+    OcTreeKey min_key, max_key;
+    bool clamped;
+    if (!bbxToKeysClamped(min, max, min_key, max_key, clamped))
       return false;
-    }
-    
-    for(KeyRay::iterator it=this->keyrays[0].begin(); it != this->keyrays[0].end(); it++) {
-      updateNode(*it, false, lazy_eval); // insert freespace measurement
-    }
-  
+    deleteAABB(min_key, max_key);
     return true;
   }
 
-  template <class NODE> bool 
-  OccupancyOcTreeBase<NODE>::insertRay(const point3d& origin, const point3d& end, double maxrange, bool lazy_eval)
-  {
-    // cut ray at maxrange
-    if ((maxrange > 0) && ((end - origin).norm () > maxrange)) 
-      {
-        point3d direction = (end - origin).normalized ();
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::deleteAABB(const OcTreeKey& min, const OcTreeKey& max) {
+    if (this->root == NULL)
+      return;
+
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    bool inside;
+    if (nodeOverlapsBBX(root_key, 0, min, max, inside)
+        && deleteAABBRecurs(this->root, root_key, 0, min, max))
+      this->clear();
+    else
+      this->updateAggregateData();
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::setAABB(const point3d& min, const point3d& max, float log_odds_value) {
+    OcTreeKey min_key, max_key;
+    bool clamped;
+    if (!bbxToKeysClamped(min, max, min_key, max_key, clamped))
+      return false;
+    setAABB(min_key, max_key, log_odds_value);
+    return true;
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::setAABB(const OcTreeKey& min, const OcTreeKey& max, float log_odds_value) {
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    bool inside;
+    if (!nodeOverlapsBBX(root_key, 0, min, max, inside))
+      return;
+
+    // clamp log odds within range:
+    log_odds_value = std::min(std::max(log_odds_value, this->clamping_thres_min), this->clamping_thres_max);
+
+    bool createdRoot = false;
+    if (this->root == NULL){
+      this->root = new NODE();
+      this->tree_size++;
+      createdRoot = true;
+    }
+    setAABBRecurs(this->root, createdRoot, root_key, 0, min, max, log_odds_value);
+    this->updateAggregateData();
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::nodeOverlapsBBX(const OcTreeKey& key, unsigned int depth, const OcTreeKey& min,
+                                                  const OcTreeKey& max, bool& inside) const {
+    // key range covered by the node:
+    const int half_size = this->tree_max_val >> depth;
+    inside = true;
+    for (unsigned int i = 0; i < 3; ++i){
+      const int node_min = int(key[i]) - half_size;
+      const int node_max = half_size ? int(key[i]) + half_size - 1 : int(key[i]);
+      if (node_max < int(min[i]) || node_min > int(max[i]))
+        return false;
+      if (node_min < int(min[i]) || node_max > int(max[i]))
+        inside = false;
+    }
+    return true;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::deleteAABBRecurs(NODE* node, const OcTreeKey& key, unsigned int depth,
+                                                   const OcTreeKey& min, const OcTreeKey& max) {
+    bool inside;
+    if (!nodeOverlapsBBX(key, depth, min, max, inside))
+      return false;
+    if (inside)
+      return true;
+
+    // on the boundary of the box (never at the finest level): keep the part outside
+    if (!this->nodeHasChildren(node))
+      this->expandNode(node);
+
+    OcTreeKey child_key;
+    const key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      if (!this->nodeChildExists(node, i))
+        continue;
+      computeChildKey(i, center_offset_key, key, child_key);
+      NODE* child = this->getNodeChild(node, i);
+      if (deleteAABBRecurs(child, child_key, depth + 1, min, max)){
+        this->deleteNodeChildren(child);
+        this->deleteNodeChild(node, i);
+      }
+    }
+
+    if (!this->nodeHasChildren(node))
+      return true;
+
+    node->updateOccupancyChildren();
+    return false;
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::setAABBRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
+                                                unsigned int depth, const OcTreeKey& min, const OcTreeKey& max,
+                                                float log_odds_value) {
+    bool inside;
+    nodeOverlapsBBX(key, depth, min, max, inside);
+    if (inside){
+      this->deleteNodeChildren(node);
+      node->setLogOdds(log_odds_value);
+      node->updateHasUnknown();
+      return;
+    }
+
+    // on the boundary of the box (never at the finest level): keep the part outside
+    if (!node_just_created && !this->nodeHasChildren(node))
+      this->expandNode(node);
+
+    OcTreeKey child_key;
+    const key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      computeChildKey(i, center_offset_key, key, child_key);
+      bool child_inside;
+      if (!nodeOverlapsBBX(child_key, depth + 1, min, max, child_inside))
+        continue;
+
+      if (this->nodeChildExists(node, i))
+        setAABBRecurs(this->getNodeChild(node, i), false, child_key, depth + 1, min, max, log_odds_value);
+      else
+        setAABBRecurs(this->createNodeChild(node, i), true, child_key, depth + 1, min, max, log_odds_value);
+    }
+
+    if (!this->pruneNode(node))
+      node->updateOccupancyChildren();
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::searchBBXRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                                                  const OcTreeKey& min, const OcTreeKey& max,
+                                                  bool occupied, bool unknown) const {
+    bool inside;
+    if (!nodeOverlapsBBX(key, depth, min, max, inside))
+      return false;
+
+    if (node == NULL)
+      return unknown;
+
+    // the summary of the subtree rules out any hit:
+    const bool has_children = this->nodeHasChildren(node);
+    if (!(occupied && this->isNodeOccupied(node)) && !(unknown && has_children && node->hasUnknown()))
+      return false;
+
+    // leafs are never unknown, inner nodes completely inside are answered by their summary:
+    if (!has_children || inside)
+      return true;
+
+    OcTreeKey child_key;
+    key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      computeChildKey(i, center_offset_key, key, child_key);
+      const NODE* child = this->nodeChildExists(node, i) ? this->getNodeChild(node, i) : NULL;
+      if (searchBBXRecurs(child, child_key, depth + 1, min, max, occupied, unknown))
+        return true;
+    }
+    return false;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::collidesWithSphere(const point3d& center, double radius,
+                                                     bool unknownIsOccupied) const {
+    CollisionSphere sphere;
+    sphere.center = center;
+    sphere.sqr_radius = radius*radius;
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return collidesRecurs(this->root, root_key, 0, sphere, unknownIsOccupied);
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::collidesWithCapsule(const point3d& p1, const point3d& p2, double radius,
+                                                      bool unknownIsOccupied) const {
+    CollisionCapsule capsule;
+    capsule.p1 = p1;
+    capsule.p2 = p2;
+    capsule.radius = radius;
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return collidesRecurs(this->root, root_key, 0, capsule, unknownIsOccupied);
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::collidesWithOBB(const point3d& center, const octomath::Quaternion& rotation,
+                                                  const point3d& half_extents, bool unknownIsOccupied) const {
+    CollisionOBB box;
+    box.center = center;
+    box.axes[0] = rotation.rotate(point3d(1.0f, 0.0f, 0.0f));
+    box.axes[1] = rotation.rotate(point3d(0.0f, 1.0f, 0.0f));
+    box.axes[2] = rotation.rotate(point3d(0.0f, 0.0f, 1.0f));
+    box.half_extents = half_extents;
+    OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    return collidesRecurs(this->root, root_key, 0, box, unknownIsOccupied);
+  }
+
+  template <class NODE>
+  int OccupancyOcTreeBase<NODE>::checkTrajectory(const std::vector<point3d>& waypoints, double radius,
+                                                 bool unknownIsOccupied) const {
+    if (waypoints.size() == 1)
+      return collidesWithSphere(waypoints[0], radius, unknownIsOccupied) ? 0 : -1;
+
+    for (size_t i = 0; i + 1 < waypoints.size(); ++i){
+      if (collidesWithCapsule(waypoints[i], waypoints[i+1], radius, unknownIsOccupied))
+        return int(i);
+    }
+    return -1;
+  }
+
+  template <class NODE>
+  template <class SHAPE>
+  bool OccupancyOcTreeBase<NODE>::collidesRecurs(const NODE* node, const OcTreeKey& key, unsigned int depth,
+                                                 const SHAPE& shape, bool unknownIsOccupied) const {
+    if (!shape.overlaps(this->keyToCoord(key, depth), 0.5 * this->getNodeSize(depth)))
+      return false;
+
+    if (node == NULL)
+      return unknownIsOccupied;
+
+    if (!this->nodeHasChildren(node))
+      return this->isNodeOccupied(node);
+
+    // the summary rules out the whole subtree:
+    if (!this->isNodeOccupied(node) && !(unknownIsOccupied && node->hasUnknown()))
+      return false;
+
+    OcTreeKey child_key;
+    key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      computeChildKey(i, center_offset_key, key, child_key);
+      const NODE* child = this->nodeChildExists(node, i) ? this->getNodeChild(node, i) : NULL;
+      if (collidesRecurs(child, child_key, depth + 1, shape, unknownIsOccupied))
+        return true;
+    }
+    return false;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::CollisionSphere::overlaps(const point3d& c, double h) const {
+    double sqr_dist = 0.0;
+    for (unsigned int i = 0; i < 3; ++i){
+      double d = fabs(center(i) - c(i)) - h;
+      if (d > 0.0)
+        sqr_dist += d*d;
+    }
+    return sqr_dist <= sqr_radius;
+  }
+
+  template <class NODE>
+  double OccupancyOcTreeBase<NODE>::CollisionCapsule::sqrDistanceToCube(const double a[3], const double b[3],
+                                                                          double t, double h){
+    double sqr_dist = 0.0;
+    for (unsigned int i = 0; i < 3; ++i){
+      double d = fabs(a[i] + t*b[i]) - h;
+      if (d > 0.0)
+        sqr_dist += d*d;
+    }
+    return sqr_dist;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::CollisionCapsule::overlaps(const point3d& c, double h) const {
+    double a[3], b[3];
+    for (unsigned int i = 0; i < 3; ++i){
+      a[i] = p1(i) - c(i);
+      b[i] = p2(i) - p1(i);
+      // bounding box of the capsule:
+      if (std::min(a[i], a[i] + b[i]) - radius > h || std::max(a[i], a[i] + b[i]) + radius < -h)
+        return false;
+    }
+
+    const double sqr_radius = radius*radius;
+    if (sqrDistanceToCube(a, b, 0.0, h) <= sqr_radius || sqrDistanceToCube(a, b, 1.0, h) <= sqr_radius)
+      return true;
+
+    // the squared distance is convex in t, golden section search for its minimum:
+    const double ratio = 0.5 * (sqrt(5.0) - 1.0);
+    double lower = 0.0, upper = 1.0;
+    double t1 = upper - ratio, t2 = ratio;
+    double f1 = sqrDistanceToCube(a, b, t1, h), f2 = sqrDistanceToCube(a, b, t2, h);
+    for (unsigned int iter = 0; iter < 40; ++iter){
+      if (f1 <= sqr_radius || f2 <= sqr_radius)
+        return true;
+      if (f1 < f2){
+        upper = t2;
+        t2 = t1;
+        f2 = f1;
+        t1 = upper - ratio * (upper - lower);
+        f1 = sqrDistanceToCube(a, b, t1, h);
+      } else {
+        lower = t1;
+        t1 = t2;
+        f1 = f2;
+        t2 = lower + ratio * (upper - lower);
+        f2 = sqrDistanceToCube(a, b, t2, h);
+      }
+    }
+    return false;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::CollisionOBB::overlaps(const point3d& c, double h) const {
+    // separating axis test between the cube (world axes) and the box
+    const double eps = 1e-9;
+    double R[3][3], absR[3][3], t[3];
+    for (unsigned int i = 0; i < 3; ++i){
+      t[i] = center(i) - c(i);
+      for (unsigned int j = 0; j < 3; ++j){
+        R[i][j] = axes[j](i);
+        absR[i][j] = fabs(R[i][j]) + eps;
+      }
+    }
+
+    // axes of the cube:
+    for (unsigned int i = 0; i < 3; ++i){
+      double rb = half_extents(0)*absR[i][0] + half_extents(1)*absR[i][1] + half_extents(2)*absR[i][2];
+      if (fabs(t[i]) > h + rb)
+        return false;
+    }
+
+    // axes of the box:
+    for (unsigned int j = 0; j < 3; ++j){
+      double ra = h * (absR[0][j] + absR[1][j] + absR[2][j]);
+      if (fabs(t[0]*R[0][j] + t[1]*R[1][j] + t[2]*R[2][j]) > ra + half_extents(j))
+        return false;
+    }
+
+    // cross products of both:
+    for (unsigned int i = 0; i < 3; ++i){
+      const unsigned int i1 = (i+1) % 3, i2 = (i+2) % 3;
+      for (unsigned int j = 0; j < 3; ++j){
+        const unsigned int j1 = (j+1) % 3, j2 = (j+2) % 3;
+        double ra = h * (absR[i1][j] + absR[i2][j]);
+        double rb = half_extents(j1)*absR[i][j2] + half_extents(j2)*absR[i][j1];
+        if (fabs(t[i2]*R[i1][j] - t[i1]*R[i2][j]) > ra + rb)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::projectTo2D(const OcTreeKey& min, const OcTreeKey& max,
+                                              ProjectionMode mode, float* grid) const {
+    if (min[0] > max[0] || min[1] > max[1])
+      return;
+    const unsigned int width = max[0] - min[0] + 1;
+
+#ifdef _OPENMP
+    // strips along y never write to the same cell
+    const unsigned int height = max[1] - min[1] + 1;
+    const int num_strips = (int) std::min(height, 8u * (unsigned int) omp_get_max_threads());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int s = 0; s < num_strips; ++s){
+      OcTreeKey strip_min = min, strip_max = max;
+      strip_min[1] = key_type(min[1] + (unsigned int) s * height / num_strips);
+      strip_max[1] = key_type(min[1] + (unsigned int) (s + 1) * height / num_strips - 1);
+      resetProjection2D(strip_min, strip_max, min, width, mode, grid);
+      projectLeafsTo2D(strip_min, strip_max, min, width, mode, grid);
+    }
+#else
+    resetProjection2D(min, max, min, width, mode, grid);
+    projectLeafsTo2D(min, max, min, width, mode, grid);
+#endif
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::updateProjection2D(const OcTreeKey& min, const OcTreeKey& max,
+                                                     ProjectionMode mode, float* grid) const {
+    if (min[0] > max[0] || min[1] > max[1])
+      return;
+    // changes of the occupancy values are not tracked:
+    if (mode == PROJECT_OCCUPANCY){
+      projectTo2D(min, max, mode, grid);
+      return;
+    }
+    const unsigned int width = max[0] - min[0] + 1;
+
+    // changed columns inside of the grid, as packed (y, x) keys:
+    std::vector<unsigned int> columns;
+    for (KeyBoolMap::const_iterator it = changed_keys.begin(); it != changed_keys.end(); ++it){
+      const OcTreeKey& key = it->first;
+      if (key[0] >= min[0] && key[0] <= max[0] && key[1] >= min[1] && key[1] <= max[1]
+          && key[2] >= min[2] && key[2] <= max[2])
+        columns.push_back((unsigned int) key[1] << 16 | key[0]);
+    }
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int i = 0; i < (int) columns.size(); ++i){
+      OcTreeKey column_min = min, column_max = max;
+      column_min[0] = column_max[0] = key_type(columns[i] & 0xFFFF);
+      column_min[1] = column_max[1] = key_type(columns[i] >> 16);
+      resetProjection2D(column_min, column_max, min, width, mode, grid);
+      projectLeafsTo2D(column_min, column_max, min, width, mode, grid);
+    }
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::resetProjection2D(const OcTreeKey& min, const OcTreeKey& max,
+                                                    const OcTreeKey& grid_min, unsigned int width,
+                                                    ProjectionMode mode, float* grid) const {
+    const float initial = (mode == PROJECT_OCCUPANCY) ? -1.0f : std::numeric_limits<float>::quiet_NaN();
+    for (unsigned int y = min[1]; y <= max[1]; ++y){
+      float* row = grid + (y - grid_min[1]) * width;
+      std::fill(row + (min[0] - grid_min[0]), row + (max[0] - grid_min[0]) + 1, initial);
+    }
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::projectLeafsTo2D(const OcTreeKey& min, const OcTreeKey& max,
+                                                   const OcTreeKey& grid_min, unsigned int width,
+                                                   ProjectionMode mode, float* grid) const {
+    const double half_resolution = 0.5 * this->resolution;
+    for (typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::leaf_bbx_iterator
+           it = this->begin_leafs_bbx(min, max), end = this->end_leafs_bbx(); it != end; ++it){
+      const bool occupied = this->isNodeOccupied(*it);
+      if (!occupied && mode != PROJECT_OCCUPANCY)
+        continue;
+
+      // key range of the leaf, clipped to the bounding box:
+      const OcTreeKey& key = it.getKey();
+      const int half_size = this->tree_max_val >> it.getDepth();
+      int leaf_min[3], leaf_max[3];
+      for (unsigned int i = 0; i < 3; ++i){
+        leaf_min[i] = std::max(int(key[i]) - half_size, int(min[i]));
+        leaf_max[i] = std::min(half_size ? int(key[i]) + half_size - 1 : int(key[i]), int(max[i]));
+      }
+
+      float value;
+      if (mode == PROJECT_OCCUPANCY)
+        value = (float) it->getOccupancy();
+      else if (mode == PROJECT_MIN_HEIGHT)
+        value = float(this->keyToCoord(key_type(leaf_min[2])) - half_resolution);
+      else
+        value = float(this->keyToCoord(key_type(leaf_max[2])) + half_resolution);
+
+      // area fill:
+      for (int y = leaf_min[1]; y <= leaf_max[1]; ++y){
+        float* cell = grid + (y - grid_min[1]) * width + (leaf_min[0] - grid_min[0]);
+        for (int x = leaf_min[0]; x <= leaf_max[0]; ++x, ++cell){
+          if (mode == PROJECT_MIN_HEIGHT){
+            if (!(*cell <= value)) // also replaces NaN
+              *cell = value;
+          } else if (!(*cell >= value))
+            *cell = value;
+        }
+      }
+    }
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::extractLOD(unsigned int depth, OccupancyOcTreeBase<NODE>& lod) const {
+    assert(depth <= this->tree_depth);
+    LODCriterion criterion;
+    criterion.max_depth = (depth == 0) ? this->tree_depth : depth;
+    criterion.min_depth = criterion.max_depth;
+    criterion.use_focus = false;
+    criterion.radius = 0.0;
+    extractLOD(criterion, lod);
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::extractLOD(const point3d& focus, double radius, unsigned int min_depth,
+                                             OccupancyOcTreeBase<NODE>& lod) const {
+    assert(min_depth <= this->tree_depth);
+    LODCriterion criterion;
+    criterion.max_depth = this->tree_depth;
+    criterion.min_depth = min_depth;
+    criterion.use_focus = true;
+    criterion.focus = focus;
+    criterion.radius = radius;
+    extractLOD(criterion, lod);
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::LODCriterion::collapse(const OccupancyOcTreeBase<NODE>& tree,
+                                                         const OcTreeKey& key, unsigned int depth) const {
+    if (depth >= max_depth)
+      return true;
+    if (!use_focus || depth < min_depth)
+      return false;
+
+    // nodes of 2^k voxels are kept up to a distance of 2^(k-1) * radius:
+    const double max_distance = radius * double(1 << (tree.tree_depth - 1 - depth));
+    return tree.squaredDistanceToNode(focus, key, depth) > max_distance*max_distance;
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::extractLOD(const LODCriterion& criterion, OccupancyOcTreeBase<NODE>& lod) const {
+    if (&lod == this){
+      OCTOMAP_ERROR("extractLOD: cannot extract a tree into itself\n");
+      return;
+    }
+
+    lod.clear();
+    lod.setResolution(this->resolution);
+    lod.clamping_thres_min = this->clamping_thres_min;
+    lod.clamping_thres_max = this->clamping_thres_max;
+    lod.prob_hit_log = this->prob_hit_log;
+    lod.prob_miss_log = this->prob_miss_log;
+    lod.occ_prob_thres_log = this->occ_prob_thres_log;
+    if (this->root == NULL)
+      return;
+
+    lod.root = new NODE();
+    lod.root->copyData(*this->root);
+    size_t num_nodes = 1;
+
+    const OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+    if (!this->nodeHasChildren(this->root) || criterion.collapse(*this, root_key, 0)){
+      lod.root->updateHasUnknown();
+    }
+    else {
+      // create the children of the root first, their subtrees are independent:
+      const NODE* src_children[8];
+      NODE* dst_children[8];
+      OcTreeKey child_keys[8];
+      for (unsigned int i = 0; i < 8; ++i){
+        src_children[i] = NULL;
+        dst_children[i] = NULL;
+        if (this->nodeChildExists(this->root, i)){
+          src_children[i] = this->getNodeChild(static_cast<const NODE*>(this->root), i);
+          dst_children[i] = lod.allocNodeChild(lod.root, i);
+          computeChildKey(i, this->tree_max_val >> 1, root_key, child_keys[i]);
+        }
+      }
+
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic) reduction(+:num_nodes)
+#endif
+      for (int i = 0; i < 8; ++i){
+        if (src_children[i] != NULL)
+          num_nodes += 1 + copyLODRecurs(src_children[i], dst_children[i], child_keys[i], 1, criterion, lod);
+      }
+    }
+
+    lod.tree_size = num_nodes;
+    lod.size_changed = true;
+    // copyData() took over the aggregates of the uncollapsed source nodes:
+    lod.updateAggregateData();
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::copyLODRecurs(const NODE* src, NODE* dst, const OcTreeKey& key,
+                                                  unsigned int depth, const LODCriterion& criterion,
+                                                  OccupancyOcTreeBase<NODE>& lod) const {
+    dst->copyData(*src);
+    if (!this->nodeHasChildren(src) || criterion.collapse(*this, key, depth)){
+      dst->updateHasUnknown(); // the new leaf covers its whole volume
+      return 0;
+    }
+
+    size_t num_nodes = 0;
+    const key_type center_offset_key = this->tree_max_val >> (depth + 1);
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(src, i)){
+        NODE* child = lod.allocNodeChild(dst, i);
+        OcTreeKey child_key;
+        computeChildKey(i, center_offset_key, key, child_key);
+        num_nodes += 1 + copyLODRecurs(this->getNodeChild(src, i), child, child_key,
+                                       depth + 1, criterion, lod);
+      }
+    }
+    return num_nodes;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::bbxToKeysClamped(const point3d& min, const point3d& max,
+                                                   OcTreeKey& min_key, OcTreeKey& max_key, bool& clamped) const {
+    const double max_key_val = 2.0 * this->tree_max_val - 1.0;
+    clamped = false;
+    for (unsigned int i = 0; i < 3; ++i){
+      double k_min = floor(this->resolution_factor * min(i)) + this->tree_max_val;
+      double k_max = floor(this->resolution_factor * max(i)) + this->tree_max_val;
+      if (k_max < 0.0 || k_min > max_key_val || k_min > k_max)
+        return false;
+      if (k_min < 0.0){
+        k_min = 0.0;
+        clamped = true;
+      }
+      if (k_max > max_key_val){
+        k_max = max_key_val;
+        clamped = true;
+      }
+      min_key[i] = key_type(k_min);
+      max_key[i] = key_type(k_max);
+    }
+    return true;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::castRay(const point3d& origin, const point3d& directionP, point3d& end, 
+                                          bool ignoreUnknown, double maxRange) const {
+
+    /// ----------  see OcTreeBase::computeRayKeys  -----------
+
+    // Initialization phase -------------------------------------------------------
+    OcTreeKey current_key;
+    if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::coordToKeyChecked(origin, current_key) ) {
+      OCTOMAP_WARNING_STR("Coordinates out of bounds during ray casting");
+      return false;
+    }
+
+    NODE* startingNode = this->search(current_key);
+    if (startingNode){
+      if (this->isNodeOccupied(startingNode)){
+        // Occupied node found at origin 
+        // (need to convert from key, since origin does not need to be a voxel center)
+        end = this->keyToCoord(current_key);
+        return true;
+      }
+    } else if(!ignoreUnknown){
+      end = this->keyToCoord(current_key);
+      return false;
+    }
+
+    point3d direction = directionP.normalized();
+    bool max_range_set = (maxRange > 0.0);
+
+    int step[3]; 
+    double tMax[3];
+    double tDelta[3];
+
+    for(unsigned int i=0; i < 3; ++i) {
+      // compute step direction
+      if (direction(i) > 0.0) step[i] =  1;
+      else if (direction(i) < 0.0)   step[i] = -1;
+      else step[i] = 0;
+
+      // compute tMax, tDelta
+      if (step[i] != 0) {
+        // corner point of voxel (in direction of ray)
+        double voxelBorder = this->keyToCoord(current_key[i]);
+        voxelBorder += double(step[i] * this->resolution * 0.5);
+
+        tMax[i] = ( voxelBorder - origin(i) ) / direction(i);
+        tDelta[i] = this->resolution / fabs( direction(i) );
+      }
+      else {
+        tMax[i] =  std::numeric_limits<double>::max();
+        tDelta[i] = std::numeric_limits<double>::max();
+      }
+    }
+
+    if (step[0] == 0 && step[1] == 0 && step[2] == 0){
+    	OCTOMAP_ERROR("Raycasting in direction (0,0,0) is not possible!");
+    	return false;
+    }
+
+    // for speedup:
+    double maxrange_sq = maxRange *maxRange;
+
+    // Incremental phase  ---------------------------------------------------------
+
+    bool done = false;
+
+    while (!done) {
+      unsigned int dim;
+
+      // find minimum tMax:
+      if (tMax[0] < tMax[1]){
+        if (tMax[0] < tMax[2]) dim = 0;
+        else                   dim = 2;
+      }
+      else {
+        if (tMax[1] < tMax[2]) dim = 1;
+        else                   dim = 2;
+      }
+
+      // check for overflow:
+      if ((step[dim] < 0 && current_key[dim] == 0)
+    		  || (step[dim] > 0 && current_key[dim] == 2* this->tree_max_val-1))
+      {
+        OCTOMAP_WARNING("Coordinate hit bounds in dim %d, aborting raycast\n", dim);
+        // return border point nevertheless:
+        end = this->keyToCoord(current_key);
+        return false;
+      }
+
+      // advance in direction "dim"
+      current_key[dim] += step[dim];
+      tMax[dim] += tDelta[dim];
+
+
+      // generate world coords from key
+      end = this->keyToCoord(current_key);
+
+      // check for maxrange:
+      if (max_range_set){
+        double dist_from_origin_sq(0.0);
+        for (unsigned int j = 0; j < 3; j++) {
+          dist_from_origin_sq += ((end(j) - origin(j)) * (end(j) - origin(j)));
+        }
+        if (dist_from_origin_sq > maxrange_sq)
+          return false;
+
+      }
+
+      NODE* currentNode = this->search(current_key);
+      if (currentNode){
+        if (this->isNodeOccupied(currentNode)) {
+          done = true;
+          break;
+        }
+        // otherwise: node is free and valid, raycasting continues
+      } else if (!ignoreUnknown){ // no node found, this usually means we are in "unknown" areas
+        return false;
+      }
+    } // end while
+
+    return true;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::isLineOfSight(const point3d& a, const point3d& b,
+                                                bool treatUnknownAsBlocked) const {
+    // DDA as in computeRayKeys()
+    OcTreeKey key_a, key_b;
+    if ( !this->coordToKeyChecked(a, key_a) || !this->coordToKeyChecked(b, key_b) ) {
+      OCTOMAP_WARNING_STR("coordinates ( " << a << " -> " << b << ") out of bounds in isLineOfSight");
+      return false;
+    }
+    if (key_a == key_b)
+      return true;
+    if (this->root == NULL)
+      return !treatUnknownAsBlocked;
+
+    point3d direction = (b - a);
+    float length = (float) direction.norm();
+    direction /= length;
+
+    int    step[3];
+    double tMax[3];
+    double tDelta[3];
+    OcTreeKey current_key = key_a;
+    for(unsigned int i=0; i < 3; ++i) {
+      if (direction(i) > 0.0) step[i] =  1;
+      else if (direction(i) < 0.0)   step[i] = -1;
+      else step[i] = 0;
+
+      if (step[i] != 0) {
+        double voxelBorder = this->keyToCoord(current_key[i]);
+        voxelBorder += (float) (step[i] * this->resolution * 0.5);
+        tMax[i] = ( voxelBorder - a(i) ) / direction(i);
+        tDelta[i] = this->resolution / fabs( direction(i) );
+      }
+      else {
+        tMax[i] =  std::numeric_limits<double>::max( );
+        tDelta[i] = std::numeric_limits<double>::max( );
+      }
+    }
+
+    // key range of the node found by the last lookup
+    key_type cube_min[3] = {1, 1, 1};
+    key_type cube_max[3] = {0, 0, 0};
+    // nodes on the path of the last lookup, the next one continues from the common ancestor
+    assert(this->tree_depth < 32);
+    const NODE* path[32];
+    path[0] = this->root;
+    unsigned int path_depth = 0;
+    OcTreeKey last_key = key_a;
+    while (true) {
+      unsigned int dim;
+      if (tMax[0] < tMax[1]){
+        if (tMax[0] < tMax[2]) dim = 0;
+        else                   dim = 2;
+      }
+      else {
+        if (tMax[1] < tMax[2]) dim = 1;
+        else                   dim = 2;
+      }
+
+      current_key[dim] += step[dim];
+      tMax[dim] += tDelta[dim];
+      assert (current_key[dim] < 2*this->tree_max_val);
+
+      if (current_key == key_b || std::min(std::min(tMax[0], tMax[1]), tMax[2]) > length)
+        return true;
+
+      // still inside of the last (free) node?
+      if (current_key[0] >= cube_min[0] && current_key[0] <= cube_max[0]
+          && current_key[1] >= cube_min[1] && current_key[1] <= cube_max[1]
+          && current_key[2] >= cube_min[2] && current_key[2] <= cube_max[2])
+        continue;
+
+      const unsigned int diff = (current_key[0] ^ last_key[0]) | (current_key[1] ^ last_key[1])
+                                | (current_key[2] ^ last_key[2]);
+      unsigned int depth = path_depth;
+      while (depth > 0 && (diff >> (this->tree_depth - depth)) != 0)
+        --depth;
+      const NODE* node = path[depth];
+      while (node && this->nodeHasChildren(node)){
+        unsigned int pos = computeChildIdx(current_key, this->tree_depth - 1 - depth);
+        node = this->nodeChildExists(node, pos) ? this->getNodeChild(node, pos) : NULL;
+        path[++depth] = node;
+      }
+      path_depth = node ? depth : depth - 1;
+      last_key = current_key;
+
+      if (node ? this->isNodeOccupied(node) : treatUnknownAsBlocked)
+        return false;
+
+      const key_type cube_mask = key_type((1 << (this->tree_depth - depth)) - 1);
+      for (unsigned int i = 0; i < 3; ++i){
+        cube_min[i] = current_key[i] & ~cube_mask;
+        cube_max[i] = current_key[i] | cube_mask;
+      }
+    }
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::isLineOfSight(const std::vector<std::pair<point3d, point3d> >& pairs,
+                                                std::vector<bool>& visible, bool treatUnknownAsBlocked) const {
+    // std::vector<bool> can not be written concurrently
+    std::vector<char> result(pairs.size());
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (int i = 0; i < (int) pairs.size(); ++i)
+      result[i] = isLineOfSight(pairs[i].first, pairs[i].second, treatUnknownAsBlocked);
+
+    visible.assign(result.begin(), result.end());
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::getRayIntersection (const point3d& origin, const point3d& direction, const point3d& center,
+                 point3d& intersection, double delta/*=0.0*/) const {
+    // We only need three normals for the six planes
+    octomap::point3d normalX(1, 0, 0);
+    octomap::point3d normalY(0, 1, 0);
+    octomap::point3d normalZ(0, 0, 1);
+
+    // One point on each plane, let them be the center for simplicity
+    octomap::point3d pointXNeg(center(0) - float(this->resolution / 2.0), center(1), center(2));
+    octomap::point3d pointXPos(center(0) + float(this->resolution / 2.0), center(1), center(2));
+    octomap::point3d pointYNeg(center(0), center(1) - float(this->resolution / 2.0), center(2));
+    octomap::point3d pointYPos(center(0), center(1) + float(this->resolution / 2.0), center(2));
+    octomap::point3d pointZNeg(center(0), center(1), center(2) - float(this->resolution / 2.0));
+    octomap::point3d pointZPos(center(0), center(1), center(2) + float(this->resolution / 2.0));
+
+    double lineDotNormal = 0.0;
+    double d = 0.0;
+    double outD = std::numeric_limits<double>::max();
+    octomap::point3d intersect;
+    bool found = false;
+
+    // Find the intersection (if any) with each place
+    // Line dot normal will be zero if they are parallel, in which case no intersection can be the entry one
+    // if there is an intersection does it occur in the bounded plane of the voxel
+    // if yes keep only the closest (smallest distance to sensor origin).
+    if((lineDotNormal = normalX.dot(direction))){
+      d = (pointXNeg - origin).dot(normalX) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6) ||
+         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+
+      d = (pointXPos - origin).dot(normalX) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6) ||
+         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+    }
+
+    if((lineDotNormal = normalY.dot(direction))){
+      d = (pointYNeg - origin).dot(normalY) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
+         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+
+      d = (pointYPos - origin).dot(normalY) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
+         intersect(2) < (pointZNeg(2) - 1e-6) || intersect(2) > (pointZPos(2) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+    }
+
+    if((lineDotNormal = normalZ.dot(direction))){
+      d = (pointZNeg - origin).dot(normalZ) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
+         intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+
+      d = (pointZPos - origin).dot(normalZ) / lineDotNormal;
+      intersect = direction * float(d) + origin;
+      if(!(intersect(0) < (pointXNeg(0) - 1e-6) || intersect(0) > (pointXPos(0) + 1e-6) ||
+         intersect(1) < (pointYNeg(1) - 1e-6) || intersect(1) > (pointYPos(1) + 1e-6))){
+        outD = std::min(outD, d);
+        found = true;
+      }
+    }
+
+    // Substract (add) a fraction to ensure no ambiguity on the starting voxel
+    // Don't start on a bondary.
+    if(found)
+      intersection = direction * float(outD + delta) + origin;
+    
+    return found;
+  }
+
+
+  template <class NODE> inline bool 
+  OccupancyOcTreeBase<NODE>::integrateMissOnRay(const point3d& origin, const point3d& end, bool lazy_eval) {
+
+    if (!this->computeRayKeys(origin, end, this->keyrays.at(0))) {
+      return false;
+    }
+    
+    for(KeyRay::iterator it=this->keyrays[0].begin(); it != this->keyrays[0].end(); it++) {
+      updateNode(*it, false, lazy_eval); // insert freespace measurement
+    }
+  
+    return true;
+  }
+
+  template <class NODE> bool 
+  OccupancyOcTreeBase<NODE>::insertRay(const point3d& origin, const point3d& end, double maxrange, bool lazy_eval)
+  {
+    // cut ray at maxrange
+    if ((maxrange > 0) && ((end - origin).norm () > maxrange)) 
+      {
+        point3d direction = (end - origin).normalized ();
         point3d new_end = origin + direction * (float) maxrange;
         return integrateMissOnRay(origin, new_end,lazy_eval);
       }
@@ -937,11 +2130,61 @@ namespace octomap {
 
     this->root = new NODE();
     this->readBinaryNode(s, this->root);
+    this->root->updateHasUnknown();
     this->size_changed = true;
     this->tree_size = OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::calcNumNodes();  // compute number of nodes    
+    this->updateAggregateData();
+    return s;
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::readBinaryData(const char* data, size_t size){
+    // tree needs to be newly created or cleared externally
+    if (this->root) {
+      OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
+      return 0;
+    }
+
+    const char* pos = data;
+    this->root = new NODE();
+    this->tree_size = 1;
+    if (!this->readBinaryNode(pos, data + size, this->root))
+      OCTOMAP_ERROR_STR("Binary data ended unexpectedly after " << (pos - data) << " bytes.");
+    this->root->updateHasUnknown();
+    this->size_changed = true;
+    this->updateAggregateData();
+    return size_t(pos - data);
+  }
+
+  template <class NODE>
+  std::istream& OccupancyOcTreeBase<NODE>::readData(std::istream &s){
+    OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::readData(s);
+    if (this->root){
+      updateHasUnknownRecurs(this->root);
+      this->updateAggregateData();
+    }
+    return s;
+  }
+
+  template <class NODE>
+  std::istream& OccupancyOcTreeBase<NODE>::readDataBulk(std::istream &s){
+    OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::readDataBulk(s);
+    if (this->root){
+      updateHasUnknownRecurs(this->root);
+      this->updateAggregateData();
+    }
     return s;
   }
 
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::updateHasUnknownRecurs(NODE* node){
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(node, i))
+        updateHasUnknownRecurs(this->getNodeChild(node, i));
+    }
+    node->updateHasUnknown();
+  }
+
   template <class NODE>
   std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryData(std::ostream &s) const{
     OCTOMAP_DEBUG("Writing %zu nodes to output stream...", this->size());
@@ -950,6 +2193,589 @@ namespace octomap {
     return s;
   }
 
+  template <class NODE>
+  std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryChunkedData(std::ostream &s, unsigned int chunk_depth) const{
+    if (chunk_depth > this->tree_depth)
+      chunk_depth = this->tree_depth;
+
+    std::vector<BinaryChunk> chunks;
+    std::vector<const NODE*> chunk_nodes;
+    std::vector<std::string> payloads;
+    if (this->root){
+      OcTreeKey root_key(this->tree_max_val, this->tree_max_val, this->tree_max_val);
+      collectBinaryChunksRecurs(this->root, root_key, 0, chunk_depth, chunks, chunk_nodes, payloads, false);
+    }
+    OCTOMAP_DEBUG("Writing %zu nodes in %zu chunks to output stream...", this->size(), chunks.size());
+
+    // the subtrees are independent of each other and encoded in parallel
+    // (except for those in paged out subtrees, see collectBinaryChunksRecurs()):
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < (int) chunks.size(); ++i){
+      if (chunks[i].state == 3 && chunk_nodes[i] != NULL){
+        std::ostringstream buffer;
+        writeBinaryNode(buffer, chunk_nodes[i]);
+        payloads[i] = buffer.str();
+      }
+    }
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i){
+      chunks[i].offset = offset;
+      chunks[i].size = payloads[i].size();
+      offset += chunks[i].size;
+    }
+
+    // index: chunk depth, number of chunks, and one entry per chunk
+    uint32_t index_depth = chunk_depth;
+    uint32_t num_chunks = (uint32_t) chunks.size();
+    s.write((char*)&index_depth, sizeof(index_depth));
+    s.write((char*)&num_chunks, sizeof(num_chunks));
+    for (size_t i = 0; i < chunks.size(); ++i){
+      const BinaryChunk& chunk = chunks[i];
+      uint8_t depth = (uint8_t) chunk.depth;
+      uint8_t state = (uint8_t) chunk.state;
+      s.write((char*)&chunk.key.k[0], 3*sizeof(key_type));
+      s.write((char*)&depth, sizeof(depth));
+      s.write((char*)&state, sizeof(state));
+      s.write((char*)&chunk.offset, sizeof(chunk.offset));
+      s.write((char*)&chunk.size, sizeof(chunk.size));
+      for (unsigned int j = 0; j < 3; ++j)
+        s.write((char*)&chunk.min(j), sizeof(float));
+      for (unsigned int j = 0; j < 3; ++j)
+        s.write((char*)&chunk.max(j), sizeof(float));
+    }
+
+    for (size_t i = 0; i < payloads.size(); ++i)
+      s.write(payloads[i].data(), payloads[i].size());
+
+    return s;
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::writeBinarySnapshotData(std::string& data) const{
+    if (this->root == NULL)
+      return 0;
+
+    // the root is never pruned, its subtrees are encoded in parallel:
+    std::string child_data[8];
+    size_t child_nodes[8];
+    unsigned int child_codes[8];
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < 8; ++i){
+      child_nodes[i] = 0;
+      child_codes[i] = 0;
+      if (this->nodeChildExists(this->root, i))
+        child_codes[i] = writeBinarySnapshotNode(this->getNodeChild(this->root, i), child_data[i], child_nodes[i]);
+    }
+
+    size_t num_nodes = 1;
+    unsigned int codes = 0;
+    for (unsigned int i = 0; i < 8; ++i){
+      codes |= child_codes[i] << (2*i);
+      if (child_codes[i] != 0)
+        num_nodes += 1 + child_nodes[i];
+    }
+    data.push_back((char)(codes & 0xFF));
+    data.push_back((char)(codes >> 8));
+    for (unsigned int i = 0; i < 8; ++i)
+      data.append(child_data[i]);
+
+    return num_nodes;
+  }
+
+  template <class NODE>
+  std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryCompressedData(std::ostream &s) const{
+    OCTOMAP_DEBUG("Compressing %zu nodes to output stream...", this->size());
+
+    // stream 0 holds the codes and the child codes of the root, followed by
+    // one independent stream per inner child of the root (coded in parallel):
+    std::vector<const NODE*> subtrees;
+    std::vector<std::string> streams(1);
+    PrefixCode codes[2];
+    if (this->root){
+      for (unsigned int i = 0; i < 8; ++i){
+        if (this->nodeChildExists(this->root, i) && this->nodeHasChildrenOrIsPaged(this->getNodeChild(this->root, i)))
+          subtrees.push_back(this->getNodeChild(this->root, i));
+      }
+      streams.resize(1 + subtrees.size());
+
+      // the codes are computed from the number of occurrences of all child codes:
+      std::vector<std::vector<uint32_t> > subtree_counts(2 * subtrees.size());
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic)
+#endif
+      for (int i = 0; i < (int) subtrees.size(); ++i){
+        subtree_counts[2*i].assign(PrefixCode::NUM_SYMBOLS, 0);
+        subtree_counts[2*i + 1].assign(PrefixCode::NUM_SYMBOLS, 0);
+        countBinaryCompressedCodes(subtrees[i], 1, &subtree_counts[2*i]);
+      }
+      std::vector<uint32_t> counts[2];
+      for (unsigned int c = 0; c < 2; ++c){
+        counts[c].assign(PrefixCode::NUM_SYMBOLS, 0);
+        for (size_t i = 0; i < subtrees.size(); ++i){
+          for (unsigned int symbol = 0; symbol < PrefixCode::NUM_SYMBOLS; ++symbol)
+            counts[c][symbol] += subtree_counts[2*i + c][symbol];
+        }
+      }
+      counts[binaryCompressionCodeIndex(0)][getBinaryChildCodes(this->root)]++;
+      codes[0].build(counts[0]);
+      codes[1].build(counts[1]);
+
+      BitWriter writer;
+      codes[0].writeTable(writer);
+      codes[1].writeTable(writer);
+      codes[binaryCompressionCodeIndex(0)].encode(writer, getBinaryChildCodes(this->root));
+      writer.flush();
+      streams[0] = writer.data();
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < (int) subtrees.size(); ++i){
+      BitWriter writer;
+      writeBinaryCompressedNode(writer, codes, subtrees[i], 1);
+      writer.flush();
+      streams[i + 1] = writer.data();
+    }
+
+    uint32_t num_streams = (uint32_t) streams.size();
+    uint64_t data_size = sizeof(num_streams) + num_streams * sizeof(uint64_t);
+    for (size_t i = 0; i < streams.size(); ++i)
+      data_size += streams[i].size();
+
+    s.write((char*)&data_size, sizeof(data_size));
+    s.write((char*)&num_streams, sizeof(num_streams));
+    for (size_t i = 0; i < streams.size(); ++i){
+      uint64_t stream_size = streams[i].size();
+      s.write((char*)&stream_size, sizeof(stream_size));
+    }
+    for (size_t i = 0; i < streams.size(); ++i)
+      s.write(streams[i].data(), streams[i].size());
+    return s;
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::readBinaryCompressedData(const char* data, size_t size){
+    // tree needs to be newly created or cleared externally
+    if (this->root) {
+      OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
+      return 0;
+    }
+
+    uint64_t data_size = 0;
+    uint32_t num_streams = 0;
+    if (size < sizeof(data_size) + sizeof(num_streams)){
+      OCTOMAP_ERROR_STR("Compressed binary data missing.");
+      return 0;
+    }
+    memcpy(&data_size, data, sizeof(data_size));
+    memcpy(&num_streams, data + sizeof(data_size), sizeof(num_streams));
+    if (data_size > size - sizeof(data_size) || num_streams < 1 || num_streams > 9
+        || data_size < sizeof(num_streams) + num_streams * sizeof(uint64_t)){
+      OCTOMAP_ERROR_STR("Compressed binary data is corrupted.");
+      return 0;
+    }
+
+    std::vector<const char*> streams(num_streams);
+    std::vector<uint64_t> stream_sizes(num_streams);
+    const char* pos = data + sizeof(data_size) + sizeof(num_streams);
+    uint64_t remaining = data_size - sizeof(num_streams) - num_streams * sizeof(uint64_t);
+    const char* stream = pos + num_streams * sizeof(uint64_t);
+    for (uint32_t i = 0; i < num_streams; ++i, pos += sizeof(uint64_t)){
+      memcpy(&stream_sizes[i], pos, sizeof(uint64_t));
+      if (stream_sizes[i] > remaining){
+        OCTOMAP_ERROR_STR("Compressed binary data ended unexpectedly.");
+        return 0;
+      }
+      streams[i] = stream;
+      stream += stream_sizes[i];
+      remaining -= stream_sizes[i];
+    }
+
+    // the codes and the root's children first, then the subtrees of its inner children in parallel:
+    this->root = new NODE();
+    this->tree_size = 1;
+    BitReader reader(streams[0], size_t(stream_sizes[0]));
+    PrefixCode codes[2];
+    if (!codes[0].readTable(reader) || !codes[1].readTable(reader)){
+      OCTOMAP_ERROR_STR("Compressed binary data is corrupted.");
+      return 0;
+    }
+    unsigned int child_codes = codes[binaryCompressionCodeIndex(0)].decode(reader);
+    std::vector<NODE*> subtrees;
+    for (unsigned int i = 0; i < 8; ++i){
+      const unsigned int code = (child_codes >> (2*i)) & 3;
+      if (code == 0)
+        continue;
+
+      NODE* child = this->createNodeChild(this->root, i);
+      if (code == 1)
+        child->setLogOdds(this->clamping_thres_min);
+      else if (code == 2)
+        child->setLogOdds(this->clamping_thres_max);
+      else
+        subtrees.push_back(child);
+    }
+    if (reader.overrunData() || subtrees.size() + 1 != num_streams){
+      OCTOMAP_ERROR_STR("Compressed binary data is corrupted.");
+      return 0;
+    }
+
+    int num_failed = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(+:num_failed)
+#endif
+    for (int i = 0; i < (int) subtrees.size(); ++i){
+      BitReader subtree_reader(streams[i + 1], size_t(stream_sizes[i + 1]));
+      NODE* child = subtrees[i];
+      if (!readBinaryCompressedNode(subtree_reader, codes, child, 1))
+        ++num_failed;
+      child->setLogOdds(child->getMaxChildLogOdds());
+      child->updateHasUnknown();
+    }
+    if (num_failed > 0){
+      OCTOMAP_ERROR_STR("Compressed binary data is corrupted.");
+      return 0;
+    }
+
+    this->root->setLogOdds(this->clamping_thres_max);
+    this->root->updateHasUnknown();
+    this->size_changed = true;
+    this->updateAggregateData();
+    return sizeof(data_size) + size_t(data_size);
+  }
+
+  template <class NODE>
+  std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryDeltaData(std::ostream &s, unsigned int patch_depth) const{
+    if (patch_depth > this->tree_depth)
+      patch_depth = this->tree_depth;
+
+    // all changed keys, reduced to their subtree at patch_depth (packed for sorting):
+    std::vector<uint64_t> patches;
+    patches.reserve(changed_keys.size());
+    for (KeyBoolMap::const_iterator it = changed_keys.begin(); it != changed_keys.end(); ++it){
+      const OcTreeKey key = this->adjustKeyAtDepth(it->first, patch_depth);
+      patches.push_back(((uint64_t) key[0] << 32) | ((uint64_t) key[1] << 16) | (uint64_t) key[2]);
+    }
+    std::sort(patches.begin(), patches.end());
+    patches.erase(std::unique(patches.begin(), patches.end()), patches.end());
+    OCTOMAP_DEBUG("Writing %zu changed subtrees to output stream...", patches.size());
+
+    uint32_t num_patches = (uint32_t) patches.size();
+    s.write((char*)&num_patches, sizeof(num_patches));
+    for (size_t i = 0; i < patches.size(); ++i){
+      OcTreeKey key((key_type)(patches[i] >> 32), (key_type)(patches[i] >> 16), (key_type) patches[i]);
+
+      // find the subtree, or the leaf or unknown space containing it
+      // (a paged out subtree on the way is read only temporarily):
+      const NODE* node = this->root;
+      NODE* paged_copy = NULL;
+      for (unsigned int depth = 0; node && depth < patch_depth && this->nodeHasChildrenOrIsPaged(node); ++depth){
+        if (this->isNodePaged(node) && paged_copy == NULL && (paged_copy = this->readPagedNodeCopy(node)))
+          node = paged_copy;
+        const unsigned int pos = computeChildIdx(key, this->tree_depth - 1 - depth);
+        node = this->nodeChildExists(node, pos) ? this->getNodeChild(node, pos) : NULL;
+      }
+
+      // 0: unknown, 1: free leaf, 2: occupied leaf, 3: inner node (as in writeBinaryNode())
+      uint8_t state = 0;
+      if (node == NULL)
+        state = 0;
+      else if (this->nodeHasChildrenOrIsPaged(node))
+        state = 3;
+      else if (this->isNodeOccupied(node))
+        state = 2;
+      else
+        state = 1;
+
+      uint8_t depth = (uint8_t) patch_depth;
+      s.write((char*)&key.k[0], 3*sizeof(key_type));
+      s.write((char*)&depth, sizeof(depth));
+      s.write((char*)&state, sizeof(state));
+      if (state == 3)
+        writeBinaryNode(s, node);
+      this->deleteNodeCopy(paged_copy);
+    }
+    return s;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::readBinaryDeltaData(std::istream &s){
+    uint32_t num_patches = 0;
+    s.read((char*)&num_patches, sizeof(num_patches));
+    bool success = true;
+    for (uint32_t i = 0; i < num_patches && s.good(); ++i){
+      if (!readBinaryPatch(s)){
+        OCTOMAP_ERROR_STR("Invalid subtree " << i << " in delta data.");
+        success = false;
+        break;
+      }
+    }
+    // patches applied so far stay in the tree:
+    if (this->root)
+      this->updateAggregateData();
+    if (!success)
+      return false;
+
+    if (!s.good()){
+      OCTOMAP_ERROR_STR("Delta data ended unexpectedly.");
+      return false;
+    }
+    return true;
+  }
+
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::readBinaryPatch(std::istream &s){
+    OcTreeKey key;
+    uint8_t depth, state;
+    s.read((char*)&key.k[0], 3*sizeof(key_type));
+    s.read((char*)&depth, sizeof(depth));
+    s.read((char*)&state, sizeof(state));
+    if (!s.good() || depth > this->tree_depth || state > 3)
+      return false;
+
+    bool node_just_created = false;
+    if (this->root == NULL){
+      if (state == 0)
+        return true;
+      this->root = new NODE();
+      this->tree_size = 1;
+      this->size_changed = true;
+      node_just_created = true;
+    }
+
+    // path down to the subtree, pruned nodes on the way are expanded:
+    std::vector<NODE*> path;
+    std::vector<unsigned int> path_idx;
+    NODE* node = this->root;
+    for (unsigned int d = 0; d < depth; ++d){
+      const unsigned int pos = computeChildIdx(key, this->tree_depth - 1 - d);
+      if (!this->nodeChildExists(node, pos)){
+        if (!this->nodeHasChildren(node) && !node_just_created)
+          this->expandNode(node);
+        else if (state == 0)
+          return true; // unknown already
+        else {
+          this->createNodeChild(node, pos);
+          node_just_created = true;
+        }
+      }
+      path.push_back(node);
+      path_idx.push_back(pos);
+      node = this->getNodeChild(node, pos);
+    }
+
+    // replace the subtree:
+    this->deleteNodeChildren(node);
+    if (state == 1)
+      node->setLogOdds(this->clamping_thres_min);
+    else if (state == 2)
+      node->setLogOdds(this->clamping_thres_max);
+    else if (state == 3){
+      readBinaryNode(s, node);
+      node->setLogOdds(node->getMaxChildLogOdds());
+      node->updateHasUnknown();
+    }
+
+    if (path.empty()){
+      if (state == 0)
+        this->clear();
+      return s.good();
+    }
+    if (state == 0)
+      this->deleteNodeChild(path.back(), path_idx.back());
+
+    // update the nodes above, nodes without any children left are deleted:
+    for (size_t d = path.size(); d-- > 0; ){
+      NODE* parent = path[d];
+      if (!this->nodeHasChildren(parent)){
+        if (d == 0)
+          this->clear();
+        else
+          this->deleteNodeChild(path[d-1], path_idx[d-1]);
+      }
+      else if (!this->pruneNode(parent))
+        parent->updateOccupancyChildren();
+    }
+    return s.good();
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::collectBinaryChunksRecurs(const NODE* node, const OcTreeKey& key,
+                                                            unsigned int depth, unsigned int chunk_depth,
+                                                            std::vector<BinaryChunk>& chunks,
+                                                            std::vector<const NODE*>& chunk_nodes,
+                                                            std::vector<std::string>& payloads,
+                                                            bool encode_now) const{
+    if (depth < chunk_depth && this->nodeHasChildrenOrIsPaged(node)){
+      // a paged out subtree is read only temporarily, so its chunks are encoded right away
+      typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::PagedNodeReader paged(*this, node);
+      const bool encode_children = encode_now || paged.get() != node;
+      const key_type center_offset_key = this->tree_max_val >> (depth + 1);
+      for (unsigned int i = 0; i < 8; ++i){
+        if (this->nodeChildExists(paged.get(), i)){
+          OcTreeKey child_key;
+          computeChildKey(i, center_offset_key, key, child_key);
+          collectBinaryChunksRecurs(this->getNodeChild(paged.get(), i), child_key, depth + 1, chunk_depth,
+                                    chunks, chunk_nodes, payloads, encode_children);
+        }
+      }
+      return;
+    }
+
+    BinaryChunk chunk;
+    chunk.key = key;
+    chunk.depth = depth;
+    if (this->nodeHasChildrenOrIsPaged(node))
+      chunk.state = 3;
+    else if (this->isNodeOccupied(node))
+      chunk.state = 2;
+    else
+      chunk.state = 1;
+    chunk.offset = chunk.size = 0;
+    const double half_size = this->getNodeSize(depth) / 2.0;
+    const point3d center = this->keyToCoord(key, depth);
+    chunk.min = center - point3d(half_size, half_size, half_size);
+    chunk.max = center + point3d(half_size, half_size, half_size);
+    chunks.push_back(chunk);
+    if (encode_now && chunk.state == 3){
+      std::ostringstream buffer;
+      writeBinaryNode(buffer, node);
+      payloads.push_back(buffer.str());
+      chunk_nodes.push_back(NULL);
+    } else {
+      payloads.push_back(std::string());
+      chunk_nodes.push_back(node);
+    }
+  }
+
+  template <class NODE>
+  size_t OccupancyOcTreeBase<NODE>::readBinaryChunkedData(const char* data, size_t size, bool use_bbx,
+                                                          const point3d& min, const point3d& max){
+    // tree needs to be newly created or cleared externally
+    if (this->root) {
+      OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
+      return 0;
+    }
+
+    const size_t entry_size = 3*sizeof(key_type) + 2*sizeof(uint8_t) + 2*sizeof(uint64_t) + 6*sizeof(float);
+    uint32_t chunk_depth = 0;
+    uint32_t num_chunks = 0;
+    if (size < 2*sizeof(uint32_t)){
+      OCTOMAP_ERROR_STR("Chunk index missing in binary data.");
+      return 0;
+    }
+    memcpy(&chunk_depth, data, sizeof(chunk_depth));
+    memcpy(&num_chunks, data + sizeof(chunk_depth), sizeof(num_chunks));
+    const char* pos = data + 2*sizeof(uint32_t);
+    if (chunk_depth > this->tree_depth || uint64_t(size - (pos - data)) < uint64_t(num_chunks) * entry_size){
+      OCTOMAP_ERROR_STR("Invalid chunk index in binary data.");
+      return 0;
+    }
+
+    const char* payload = pos + size_t(num_chunks) * entry_size;
+    const uint64_t payload_size = uint64_t(size - (payload - data));
+    uint64_t payload_end = 0;
+    std::vector<BinaryChunk> chunks;
+    chunks.reserve(num_chunks);
+    for (uint32_t i = 0; i < num_chunks; ++i, pos += entry_size){
+      BinaryChunk chunk;
+      uint8_t depth, state;
+      const char* entry = pos;
+      memcpy(&chunk.key.k[0], entry, 3*sizeof(key_type));     entry += 3*sizeof(key_type);
+      memcpy(&depth, entry, sizeof(depth));                   entry += sizeof(depth);
+      memcpy(&state, entry, sizeof(state));                   entry += sizeof(state);
+      memcpy(&chunk.offset, entry, sizeof(chunk.offset));     entry += sizeof(chunk.offset);
+      memcpy(&chunk.size, entry, sizeof(chunk.size));         entry += sizeof(chunk.size);
+      for (unsigned int j = 0; j < 3; ++j, entry += sizeof(float))
+        memcpy(&chunk.min(j), entry, sizeof(float));
+      for (unsigned int j = 0; j < 3; ++j, entry += sizeof(float))
+        memcpy(&chunk.max(j), entry, sizeof(float));
+      chunk.depth = depth;
+      chunk.state = state;
+
+      if (chunk.depth > chunk_depth || chunk.state < 1 || chunk.state > 3
+          || chunk.offset > payload_size || chunk.size > payload_size - chunk.offset){
+        OCTOMAP_ERROR_STR("Invalid entry " << i << " in chunk index.");
+        return 0;
+      }
+      payload_end = std::max(payload_end, chunk.offset + chunk.size);
+
+      if (use_bbx && (chunk.max.x() < min.x() || chunk.min.x() > max.x()
+                      || chunk.max.y() < min.y() || chunk.min.y() > max.y()
+                      || chunk.max.z() < min.z() || chunk.min.z() > max.z()))
+        continue;
+      chunks.push_back(chunk);
+    }
+
+    if (chunks.empty())
+      return size_t(payload - data + payload_end);
+
+    // the nodes above the chunks are created first, each chunk is then read into its own subtree:
+    this->root = new NODE();
+    this->tree_size = 1;
+    std::vector<NODE*> chunk_nodes(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i){
+      NODE* node = this->root;
+      for (unsigned int d = 0; d < chunks[i].depth; ++d){
+        const unsigned int pos_child = computeChildIdx(chunks[i].key, this->tree_depth - 1 - d);
+        if (this->nodeChildExists(node, pos_child))
+          node = this->getNodeChild(node, pos_child);
+        else
+          node = this->createNodeChild(node, pos_child);
+      }
+      chunk_nodes[i] = node;
+      if (chunks[i].state == 1)
+        node->setLogOdds(this->clamping_thres_min);
+      else if (chunks[i].state == 2)
+        node->setLogOdds(this->clamping_thres_max);
+    }
+
+    int num_failed = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(+:num_failed)
+#endif
+    for (int i = 0; i < (int) chunks.size(); ++i){
+      if (chunks[i].state != 3)
+        continue;
+
+      const char* chunk_data = payload + chunks[i].offset;
+      const char* chunk_end = chunk_data + chunks[i].size;
+      NODE* node = chunk_nodes[i];
+      if (!this->readBinaryNode(chunk_data, chunk_end, node) || chunk_data != chunk_end)
+        ++num_failed;
+      node->setLogOdds(node->getMaxChildLogOdds());
+      node->updateHasUnknown();
+    }
+    if (num_failed > 0){
+      OCTOMAP_ERROR_STR("Binary data of " << num_failed << " chunks is corrupted.");
+      return 0;
+    }
+
+    updateInnerOccupancyToDepthRecurs(this->root, 0, chunk_depth);
+    this->size_changed = true;
+    this->updateAggregateData();
+    return size_t(payload - data + payload_end);
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::updateInnerOccupancyToDepthRecurs(NODE* node, unsigned int depth,
+                                                                    unsigned int max_depth){
+    if (depth >= max_depth || !this->nodeHasChildren(node))
+      return;
+
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(node, i))
+        updateInnerOccupancyToDepthRecurs(this->getNodeChild(node, i), depth + 1, max_depth);
+    }
+    node->updateOccupancyChildren();
+  }
+
   template <class NODE>
   std::istream& OccupancyOcTreeBase<NODE>::readBinaryNode(std::istream &s, NODE* node){
 
@@ -1014,6 +2840,7 @@ namespace octomap {
         if (fabs(child->getLogOdds() + 200.)<1e-3) {
           readBinaryNode(s, child);
           child->setLogOdds(child->getMaxChildLogOdds());
+          child->updateHasUnknown();
         }
       } // end if child exists
     } // end for children
@@ -1022,10 +2849,181 @@ namespace octomap {
   }
 
   template <class NODE>
-  std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryNode(std::ostream &s, const NODE* node) const{
+  bool OccupancyOcTreeBase<NODE>::readBinaryNode(const char*& data, const char* end, NODE* node){
+    assert(node);
+
+    if (end - data < 2)
+      return false;
+
+    // 2 bits per child: 01 free leaf, 10 occupied leaf, 11 inner node, 00 unknown
+    const unsigned int child_codes = (unsigned int)(unsigned char) data[0]
+                                   | ((unsigned int)(unsigned char) data[1] << 8);
+    data += 2;
+
+    // inner nodes default to occupied
+    node->setLogOdds(this->clamping_thres_max);
+
+    // the subtrees of inner children follow in the order of the children:
+    for (unsigned int i=0; i<8; i++) {
+      const unsigned int code = (child_codes >> (2*i)) & 3;
+      if (code == 0)
+        continue;
+
+      NODE* child = this->createNodeChild(node, i);
+      if (code == 1)
+        child->setLogOdds(this->clamping_thres_min);
+      else if (code == 2)
+        child->setLogOdds(this->clamping_thres_max);
+      else {
+        if (!readBinaryNode(data, end, child))
+          return false;
+        child->setLogOdds(child->getMaxChildLogOdds());
+        child->updateHasUnknown();
+      }
+    }
+
+    return true;
+  }
+
+  template <class NODE>
+  unsigned int OccupancyOcTreeBase<NODE>::writeBinarySnapshotNode(const NODE* paged_node, std::string& data,
+                                                                  size_t& num_nodes) const{
+    // a paged out subtree is read only temporarily
+    typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::PagedNodeReader paged(*this, paged_node);
+    const NODE* node = paged.get();
+    if (!this->nodeHasChildren(node))
+      return this->isNodeOccupied(node) ? 2 : 1;
+
+    // the child codes are known after the children, so they are filled in afterwards:
+    const size_t start = data.size();
+    data.append(2, '\0');
+
+    size_t child_nodes = 0;
+    unsigned int codes = 0;
+    unsigned int first_code = 0;
+    bool collapsible = true;
+    for (unsigned int i = 0; i < 8; ++i){
+      if (!this->nodeChildExists(node, i)){
+        collapsible = false;
+        continue;
+      }
+      const unsigned int code = writeBinarySnapshotNode(this->getNodeChild(node, i), data, child_nodes);
+      codes |= code << (2*i);
+      ++child_nodes;
+      if (first_code == 0)
+        first_code = code;
+      if (code == 3 || code != first_code)
+        collapsible = false;
+    }
+
+    // pruned, all children are equal leafs:
+    if (collapsible){
+      data.resize(start);
+      return first_code;
+    }
+
+    data[start] = (char)(codes & 0xFF);
+    data[start + 1] = (char)(codes >> 8);
+    num_nodes += child_nodes;
+    return 3;
+  }
+
+  template <class NODE>
+  unsigned int OccupancyOcTreeBase<NODE>::getBinaryChildCodes(const NODE* node) const{
+    unsigned int child_codes = 0;
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(node, i)){
+        const NODE* child = this->getNodeChild(node, i);
+        if (this->nodeHasChildrenOrIsPaged(child))
+          child_codes |= 3 << (2*i);
+        else if (this->isNodeOccupied(child))
+          child_codes |= 2 << (2*i);
+        else
+          child_codes |= 1 << (2*i);
+      }
+    }
+    return child_codes;
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::countBinaryCompressedCodes(const NODE* paged_node, unsigned int depth,
+                                                             std::vector<uint32_t>* counts) const{
+    assert(paged_node);
+    // a paged out subtree is read only temporarily
+    typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::PagedNodeReader paged(*this, paged_node);
+    const NODE* node = paged.get();
+
+    counts[binaryCompressionCodeIndex(depth)][getBinaryChildCodes(node)]++;
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(node, i)){
+        const NODE* child = this->getNodeChild(node, i);
+        if (this->nodeHasChildrenOrIsPaged(child))
+          countBinaryCompressedCodes(child, depth + 1, counts);
+      }
+    }
+  }
+
+  template <class NODE>
+  void OccupancyOcTreeBase<NODE>::writeBinaryCompressedNode(BitWriter& writer, const PrefixCode* codes,
+                                                            const NODE* paged_node, unsigned int depth) const{
+    assert(paged_node);
+    // a paged out subtree is read only temporarily
+    typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::PagedNodeReader paged(*this, paged_node);
+    const NODE* node = paged.get();
+
+    codes[binaryCompressionCodeIndex(depth)].encode(writer, getBinaryChildCodes(node));
+    for (unsigned int i = 0; i < 8; ++i){
+      if (this->nodeChildExists(node, i)){
+        const NODE* child = this->getNodeChild(node, i);
+        if (this->nodeHasChildrenOrIsPaged(child))
+          writeBinaryCompressedNode(writer, codes, child, depth + 1);
+      }
+    }
+  }
 
+  template <class NODE>
+  bool OccupancyOcTreeBase<NODE>::readBinaryCompressedNode(BitReader& reader, const PrefixCode* codes,
+                                                           NODE* node, unsigned int depth){
     assert(node);
 
+    if (reader.overrunData() || depth >= this->tree_depth)
+      return false;
+
+    // inner nodes default to occupied
+    node->setLogOdds(this->clamping_thres_max);
+
+    const unsigned int child_codes = codes[binaryCompressionCodeIndex(depth)].decode(reader);
+
+    // the subtrees of inner children follow in the order of the children:
+    for (unsigned int i = 0; i < 8; ++i){
+      const unsigned int code = (child_codes >> (2*i)) & 3;
+      if (code == 0)
+        continue;
+
+      NODE* child = this->createNodeChild(node, i);
+      if (code == 1)
+        child->setLogOdds(this->clamping_thres_min);
+      else if (code == 2)
+        child->setLogOdds(this->clamping_thres_max);
+      else {
+        if (!readBinaryCompressedNode(reader, codes, child, depth + 1))
+          return false;
+        child->setLogOdds(child->getMaxChildLogOdds());
+        child->updateHasUnknown();
+      }
+    }
+
+    return true;
+  }
+
+  template <class NODE>
+  std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryNode(std::ostream &s, const NODE* paged_node) const{
+
+    assert(paged_node);
+    // a paged out subtree is read only temporarily
+    typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::PagedNodeReader paged(*this, paged_node);
+    const NODE* node = paged.get();
+
     // 2 bits for each children, 8 children per node -> 16 bits
     std::bitset<8> child1to4;
     std::bitset<8> child5to8;
@@ -1042,7 +3040,7 @@ namespace octomap {
     for (unsigned int i=0; i<4; i++) {
       if (this->nodeChildExists(node, i)) {
         const NODE* child = this->getNodeChild(node, i);
-        if      (this->nodeHasChildren(child))  { child1to4[i*2] = 1; child1to4[i*2+1] = 1; }
+        if      (this->nodeHasChildrenOrIsPaged(child))  { child1to4[i*2] = 1; child1to4[i*2+1] = 1; }
         else if (this->isNodeOccupied(child)) { child1to4[i*2] = 0; child1to4[i*2+1] = 1; }
         else                            { child1to4[i*2] = 1; child1to4[i*2+1] = 0; }
       }
@@ -1054,7 +3052,7 @@ namespace octomap {
     for (unsigned int i=0; i<4; i++) {
       if (this->nodeChildExists(node, i+4)) {
         const NODE* child = this->getNodeChild(node, i+4);
-        if      (this->nodeHasChildren(child))  { child5to8[i*2] = 1; child5to8[i*2+1] = 1; }
+        if      (this->nodeHasChildrenOrIsPaged(child))  { child5to8[i*2] = 1; child5to8[i*2+1] = 1; }
         else if (this->isNodeOccupied(child)) { child5to8[i*2] = 0; child5to8[i*2+1] = 1; }
         else                            { child5to8[i*2] = 1; child5to8[i*2+1] = 0; }
       }
@@ -1076,7 +3074,7 @@ namespace octomap {
     for (unsigned int i=0; i<8; i++) {
       if (this->nodeChildExists(node, i)) {
         const NODE* child = this->getNodeChild(node, i);
-        if (this->nodeHasChildren(child)) {
+        if (this->nodeHasChildrenOrIsPaged(child)) {
           writeBinaryNode(s, child);
         }
       }
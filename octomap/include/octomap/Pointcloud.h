@@ -111,8 +111,18 @@ namespace octomap {
 
     // I/O methods
 
+    /// Reads points in the binary format of writeBinary and appends them
     std::istream& readBinary(std::istream &s);
+    /**
+     * Reads points in the binary format of writeBinary from a memory block,
+     * e.g. of a memory-mapped file, and appends them.
+     * @return number of bytes read, 0 on error
+     */
+    size_t readBinary(const char* data, size_t size);
+    /// @return size in bytes of the binary point cloud starting at data (0 if it exceeds size)
+    static size_t binaryDataSize(const char* data, size_t size);
     std::istream& read(std::istream &s);
+    /// Writes all points in one bulk operation: uint32 count, then per point int32 3 and 3 doubles (host byte order, like ScanGraph::writeBinary)
     std::ostream& writeBinary(std::ostream &s) const;
 
   protected:
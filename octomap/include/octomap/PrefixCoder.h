@@ -0,0 +1,191 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef OCTOMAP_PREFIX_CODER_H
+#define OCTOMAP_PREFIX_CODER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace octomap {
+
+  /// Writes bit strings (most significant bit first) into a byte string
+  class BitWriter {
+  public:
+    BitWriter() : buffer(0), num_bits(0) {}
+
+    /// appends the lowest length bits of value (length <= 32)
+    inline void writeBits(uint32_t value, unsigned int length){
+      buffer = (buffer << length) | (value & ((uint64_t(1) << length) - 1));
+      num_bits += length;
+      while (num_bits >= 8){
+        num_bits -= 8;
+        output.push_back((char)(unsigned char)(buffer >> num_bits));
+      }
+    }
+
+    /// writes the remaining bits (padded with zeros), needs to be called once after the last bits
+    void flush(){
+      if (num_bits > 0)
+        writeBits(0, 8 - num_bits);
+    }
+
+    /// @return the written bytes
+    const std::string& data() const { return output; }
+
+  private:
+    uint64_t buffer;
+    unsigned int num_bits;
+    std::string output;
+  };
+
+  /// Reads bit strings written by a BitWriter from a memory block
+  class BitReader {
+  public:
+    BitReader(const char* data, size_t size)
+      : pos((const unsigned char*) data), end((const unsigned char*) data + size),
+        buffer(0), num_bits(0), num_padding_bits(0) {}
+
+    /// @return the next length bits (length <= 32) without consuming them
+    inline uint32_t peekBits(unsigned int length){
+      // the buffer holds the next bits in its highest bits, past the end of
+      // the data it is filled with zeros:
+      if (num_bits < length){
+        if (end - pos >= 8){
+          // whole bytes up to 56 bits with a single 8 byte load:
+          uint64_t bytes = 0;
+          for (unsigned int i = 0; i < 8; ++i)
+            bytes = (bytes << 8) | pos[i];
+          buffer |= bytes >> num_bits;
+          pos += (63 - num_bits) >> 3;
+          num_bits |= 56;
+        }
+        else {
+          while (num_bits <= 56){
+            if (pos < end)
+              buffer |= uint64_t(*pos++) << (56 - num_bits);
+            else
+              num_padding_bits += 8;
+            num_bits += 8;
+          }
+        }
+      }
+      return uint32_t(buffer >> (64 - length));
+    }
+
+    inline void skipBits(unsigned int length){
+      buffer <<= length;
+      num_bits -= length;
+    }
+
+    inline uint32_t readBits(unsigned int length){
+      const uint32_t value = peekBits(length);
+      skipBits(length);
+      return value;
+    }
+
+    /// @return true if more bits were read than available (corrupted data)
+    bool overrunData() const { return num_bits < num_padding_bits; }
+
+  private:
+    const unsigned char* pos;
+    const unsigned char* end;
+    uint64_t buffer;
+    unsigned int num_bits;
+    unsigned int num_padding_bits;
+  };
+
+  /**
+   * Static prefix code (canonical Huffman code) for 16 bit symbols, used for
+   * the compressed binary file format. The encoder computes the code from the
+   * number of occurrences of each symbol and stores it with the data, so that
+   * the decoder needs only a single table lookup per symbol. Rare symbols are
+   * coded as an escape code followed by the 16 bits of the symbol.
+   */
+  class PrefixCode {
+  public:
+    static const unsigned int SYMBOL_BITS = 16;
+    static const unsigned int NUM_SYMBOLS = 1 << SYMBOL_BITS;
+    /// maximum length of a code, the decoder uses a table with 2^MAX_CODE_LENGTH entries
+    static const unsigned int MAX_CODE_LENGTH = 12;
+
+    /// computes the code from the number of occurrences of each symbol (NUM_SYMBOLS entries)
+    void build(const std::vector<uint32_t>& counts);
+
+    /// writes the code lengths, see readTable()
+    void writeTable(BitWriter& writer) const;
+
+    /// reads the code written by writeTable(), @return false if it is invalid
+    bool readTable(BitReader& reader);
+
+    /// writes the code of symbol, needs build()
+    inline void encode(BitWriter& writer, unsigned int symbol) const {
+      if (lengths[symbol] > 0)
+        writer.writeBits(codes[symbol], lengths[symbol]);
+      else {
+        writer.writeBits(escape_code, escape_length);
+        writer.writeBits(symbol, SYMBOL_BITS);
+      }
+    }
+
+    /// @return the next symbol of reader, needs readTable()
+    inline unsigned int decode(BitReader& reader) const {
+      // entries: symbol (or NUM_SYMBOLS for the escape code) | code length << 24
+      const uint32_t entry = decode_table[reader.peekBits(MAX_CODE_LENGTH)];
+      reader.skipBits(entry >> 24);
+      const unsigned int symbol = entry & 0xFFFFFF;
+      if (symbol == NUM_SYMBOLS)
+        return reader.readBits(SYMBOL_BITS);
+      return symbol;
+    }
+
+  private:
+    /// symbols with a code in increasing order, the others are escaped
+    std::vector<uint16_t> symbols;
+    /// code lengths of symbols
+    std::vector<uint8_t> symbol_lengths;
+    unsigned int escape_length;
+    uint32_t escape_code;
+
+    /// encoder: code and code length of each symbol (0: escaped)
+    std::vector<uint32_t> codes;
+    std::vector<uint8_t> lengths;
+    /// decoder: entry for each MAX_CODE_LENGTH bit prefix, see decode()
+    std::vector<uint32_t> decode_table;
+  };
+
+} // namespace
+
+#endif
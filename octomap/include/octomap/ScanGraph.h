@@ -40,6 +40,7 @@
 
 #include "Pointcloud.h"
 #include "octomap_types.h"
+#include "MemoryMappedFile.h"
 
 namespace octomap {
 
@@ -54,9 +55,9 @@ namespace octomap {
    public:
 
     ScanNode (Pointcloud* _scan, pose6d _pose, unsigned int _id)
-      : scan(_scan), pose(_pose), id(_id) {}
+      : scan(_scan), pose(_pose), id(_id), scan_data(NULL), scan_data_size(0) {}
     ScanNode ()
-      : scan(NULL) {}
+      : scan(NULL), scan_data(NULL), scan_data_size(0) {}
 
     ~ScanNode();
 
@@ -70,10 +71,35 @@ namespace octomap {
     std::ostream& writePoseASCII(std::ostream &s) const;
     std::istream& readPoseASCII(std::istream &s);
 
-    Pointcloud* scan;
+    /**
+     * @return the scan of this node. For nodes of a graph read lazily with
+     * ScanGraph::readBinary(filename, true), the scan is materialized from
+     * the memory-mapped graph file on first access (which is why the scan
+     * can be loaded through a const node, but not by two threads at once).
+     */
+    Pointcloud* getScan() const;
+    /// @return true if the scan is in memory (always true unless read lazily)
+    bool isScanLoaded() const { return scan != NULL; }
+    /**
+     * Releases the scan of a lazily read node, getScan() will read it again
+     * from the graph file. Changes to the scan are lost. Does nothing for
+     * nodes without file data.
+     */
+    void unloadScan();
+    /// @return number of points of the scan, without loading it
+    size_t getNumPoints() const;
+
+    mutable Pointcloud* scan; ///< NULL for lazily read nodes until getScan() is called, use getScan()
     pose6d pose; ///< 6D pose from which the scan was performed
     unsigned int id;
 
+  protected:
+    friend class ScanGraph;
+    friend class ScanGraphReader;
+    /// binary scan data in the mapped graph file (lazily read graphs only)
+    const char* scan_data;
+    size_t scan_data_size;
+
   };
 
   /**
@@ -191,7 +217,18 @@ namespace octomap {
     std::ostream& writeBinary(std::ostream &s) const;
     std::istream& readBinary(std::ifstream &s);
     bool writeBinary(const std::string& filename) const;
-    bool readBinary(const std::string& filename);
+    /**
+     * Reads a binary graph file through a memory mapping. The point clouds are
+     * decoded in bulk from the mapped memory. Files which cannot be mapped
+     * (e.g. pipes) are read as a stream instead, then lazy has no effect.
+     *
+     * @param filename binary graph file
+     * @param lazy if true, the scans are not read: the file stays mapped and
+     *   each ScanNode reads its scan on its first getScan() call, so that
+     *   poses and edges of large graphs are available immediately.
+     * @return success
+     */
+    bool readBinary(const std::string& filename, bool lazy = false);
 
 
     std::ostream& writeEdgesASCII(std::ostream &s) const;
@@ -220,9 +257,19 @@ namespace octomap {
     void readPlainASCII(const std::string& filename);
 
    protected:
+    friend class ScanGraphReader;
+
+    /**
+     * Reads nodes and edges from a binary stream. If mapped_data is given, s
+     * reads from that memory block and the scans are not read but referenced
+     * for lazy loading.
+     */
+    std::istream& readBinaryData(std::istream &s, const char* mapped_data);
 
     std::vector<ScanNode*> nodes;
     std::vector<ScanEdge*> edges;
+    /// graph file mapped by readBinary(filename), kept open for lazily read scans
+    MemoryMappedFile mapped_file;
   };
 
 }
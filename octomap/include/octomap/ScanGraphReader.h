@@ -0,0 +1,118 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCTOMAP_SCANGRAPH_READER_H
+#define OCTOMAP_SCANGRAPH_READER_H
+
+#include <string>
+#include <cstddef>
+
+#include "ScanGraph.h"
+
+namespace octomap {
+
+  /**
+   * Streaming reader for binary scan graph files: returns the ScanNodes of a
+   * graph one after the other, with only a bounded window of scans in memory.
+   *
+   * The graph file is memory-mapped and read lazily (see ScanGraph::readBinary),
+   * so poses, ids and edges of all nodes are available right away. Each call to
+   * next() releases the scan of the previously returned node. With C++11, the
+   * scans of the following window_size nodes are decoded ahead on a background
+   * thread while the current one is processed. At most window_size + 1 scans are
+   * held in memory, and the file pages of released scans are dropped again.
+   *
+   * Usage:
+   * \code
+   * ScanGraphReader reader;
+   * if (reader.open("log.graph", 4)) {
+   *   while (ScanNode* node = reader.next())
+   *     tree.insertPointCloud(*node, maxrange);
+   * }
+   * \endcode
+   */
+  class ScanGraphReader {
+  public:
+    ScanGraphReader();
+    ~ScanGraphReader();
+
+    /**
+     * Opens a binary graph file for streaming, a previously opened file is closed first.
+     * @param filename binary graph file
+     * @param window_size number of scans to read ahead on a background thread
+     *   (0: read each scan in next(), only supported value without C++11)
+     * @return success
+     */
+    bool open(const std::string& filename, unsigned int window_size = 1);
+    void close();
+
+    /**
+     * @return the next node of the graph with its scan loaded, NULL after the last node.
+     * The scan of the node returned before is released, do not access it any longer.
+     */
+    ScanNode* next();
+    /// restarts with the first node, e.g. for a second pass over the graph
+    void rewind();
+
+    /// all nodes and edges of the graph, scans only available through next()
+    const ScanGraph& getGraph() const { return graph; }
+    /// number of nodes in the graph
+    size_t size() const { return graph.size(); }
+    /// number of points of all scans (up to max_id) in the file, without loading them
+    size_t getNumPoints(unsigned int max_id = -1) const;
+    unsigned int getWindowSize() const { return window_size; }
+
+  protected:
+    void startPrefetch();
+    void stopPrefetch();
+
+    ScanGraph graph;
+    std::vector<size_t> num_points; ///< number of points of each scan in the file
+    size_t next_index; ///< index of the node returned by the next call to next()
+    unsigned int window_size;
+
+    /// state of the background thread, defined in ScanGraphReader.cpp so that
+    /// the class layout does not depend on the C++ standard of the user
+    struct Prefetcher;
+    Prefetcher* prefetcher; ///< NULL while no background thread is running
+    void prefetchLoop();
+
+  private:
+    /// readers are not copyable
+    ScanGraphReader(const ScanGraphReader&);
+    ScanGraphReader& operator=(const ScanGraphReader&);
+  };
+
+} // namespace
+
+#endif
@@ -34,5 +34,6 @@
 #include "octomap_types.h"
 #include "Pointcloud.h"
 #include "ScanGraph.h"
+#include "ScanGraphReader.h"
 #include "OcTree.h"
 
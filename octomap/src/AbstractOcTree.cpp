@@ -71,6 +71,29 @@ namespace octomap {
     return true;
   }
 
+  bool AbstractOcTree::writeBulk(const std::string& filename) const{
+    std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+
+    if (!file.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+    writeBulk(file);
+    file.close();
+    return !file.fail();
+  }
+
+  bool AbstractOcTree::writeBulk(std::ostream &s) const{
+    s << bulkFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    s << "id " << getTreeType() << std::endl;
+    s << "size "<< size() << std::endl;
+    s << "res " << getResolution() << std::endl;
+    s << "data" << std::endl;
+
+    writeDataBulk(s);
+    return s.good();
+  }
+
   AbstractOcTree* AbstractOcTree::read(const std::string& filename){
     std::ifstream file(filename.c_str(), std::ios_base::in |std::ios_base::binary);
 
@@ -89,7 +112,10 @@ namespace octomap {
     // check if first line valid:
     std::string line;
     std::getline(s, line);
-    if (line.compare(0,fileHeader.length(), fileHeader) !=0){
+    bool bulk = false;
+    if (line.compare(0,bulkFileHeader.length(), bulkFileHeader) == 0)
+      bulk = true;
+    else if (line.compare(0,fileHeader.length(), fileHeader) !=0){
       OCTOMAP_ERROR_STR("First line of OcTree file header does not start with \""<< fileHeader);
       return NULL;
     }
@@ -107,7 +133,9 @@ namespace octomap {
     AbstractOcTree* tree = createTree(id, res);
 
     if (tree){
-      if (size > 0)
+      if (size > 0 && bulk)
+        tree->readDataBulk(s);
+      else if (size > 0)
         tree->readData(s);
 
       OCTOMAP_DEBUG_STR("Done ("<< tree->size() << " nodes)");
@@ -208,4 +236,5 @@ namespace octomap {
 
 
   const std::string AbstractOcTree::fileHeader = "# Octomap OcTree file";
+  const std::string AbstractOcTree::bulkFileHeader = "# Octomap OcTree bulk file";
 }
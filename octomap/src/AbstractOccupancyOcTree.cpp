@@ -34,6 +34,11 @@
 
 #include <octomap/AbstractOccupancyOcTree.h>
 #include <octomap/octomap_types.h>
+#include <octomap/MemoryMappedFile.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
 
 
 namespace octomap {
@@ -69,6 +74,35 @@ namespace octomap {
     return true;
   }
 
+#if __cplusplus >= 201103L
+  static bool writeBinarySnapshot(const std::string& filename, const std::string& header, const std::string& data){
+    std::ofstream binary_outfile( filename.c_str(), std::ios_base::binary);
+
+    if (!binary_outfile.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+    binary_outfile << header;
+    binary_outfile.write(data.data(), data.size());
+    binary_outfile.close();
+    return binary_outfile.good();
+  }
+
+  std::future<bool> AbstractOccupancyOcTree::writeBinaryAsync(const std::string& filename) const{
+    std::string data;
+    const size_t num_nodes = writeBinarySnapshotData(data);
+
+    std::ostringstream header;
+    header << binaryFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    header << "id " << this->getTreeType() << std::endl;
+    header << "size "<< num_nodes << std::endl;
+    header << "res " << this->getResolution() << std::endl;
+    header << "data" << std::endl;
+
+    return std::async(std::launch::async, writeBinarySnapshot, filename, header.str(), std::move(data));
+  }
+#endif
+
   bool AbstractOccupancyOcTree::writeBinary(std::ostream &s){
     // convert to max likelihood first, this makes efficient pruning on binary data possible
     this->toMaxLikelihood();
@@ -124,6 +158,11 @@ namespace octomap {
   }
   
   bool AbstractOccupancyOcTree::readBinary(const std::string& filename){
+    MemoryMappedFile mapped_file;
+    if (mapped_file.open(filename))
+      return readBinary(mapped_file.data(), mapped_file.size());
+
+    // files which cannot be mapped (e.g. pipes) are read as a stream:
     std::ifstream binary_infile( filename.c_str(), std::ios_base::binary);
     if (!binary_infile.is_open()){
       OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing read.");
@@ -131,7 +170,234 @@ namespace octomap {
     }
     return readBinary(binary_infile);
   }
+
+  bool AbstractOccupancyOcTree::readBinary(const char* data, size_t size) {
+    MemoryStreamBuf buffer(data, size);
+    std::istream s(&buffer);
+
+    // check if first line valid, otherwise try to read old binary format from the stream:
+    std::string line;
+    std::getline(s, line);
+    const bool compressed = (line.compare(0, compressedFileHeader.length(), compressedFileHeader) == 0);
+    if (!compressed && line.compare(0,AbstractOccupancyOcTree::binaryFileHeader.length(), AbstractOccupancyOcTree::binaryFileHeader) !=0){
+      s.clear();
+      s.seekg(0);
+      return readBinary(s);
+    }
+
+    std::string id;
+    unsigned tree_size;
+    double res;
+    if (!AbstractOcTree::readHeader(s, id, tree_size, res))
+      return false;
+    OCTOMAP_DEBUG_STR("Reading binary octree type "<< id);
+
+    // stream is now at binary data, which is parsed directly from memory:
+    const std::streamoff offset = s.tellg();
+    if (offset < 0 || size_t(offset) > size){
+      OCTOMAP_ERROR_STR("Binary data missing after OcTree header");
+      return false;
+    }
+    this->clear();
+    this->setResolution(res);
+
+    if (tree_size > 0){
+      if (compressed)
+        this->readBinaryCompressedData(data + offset, size - size_t(offset));
+      else
+        this->readBinaryData(data + offset, size - size_t(offset));
+    }
+
+    if (tree_size != this->size()){
+      OCTOMAP_ERROR("Tree size mismatch: # read nodes (%zu) != # expected nodes (%d)\n",this->size(), tree_size);
+      return false;
+    }
+
+    return true;
+  }
   
+  bool AbstractOccupancyOcTree::writeBinaryCompressed(const std::string& filename){
+    std::ofstream binary_outfile( filename.c_str(), std::ios_base::binary);
+
+    if (!binary_outfile.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+    // convert to max likelihood first, this makes efficient pruning on binary data possible
+    this->toMaxLikelihood();
+    this->prune();
+    return writeBinaryCompressedConst(binary_outfile);
+  }
+
+  bool AbstractOccupancyOcTree::writeBinaryCompressedConst(std::ostream &s) const{
+    s << compressedFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    s << "id " << this->getTreeType() << std::endl;
+    s << "size "<< this->size() << std::endl;
+    s << "res " << this->getResolution() << std::endl;
+    s << "data" << std::endl;
+
+    writeBinaryCompressedData(s);
+
+    if (s.good()){
+      OCTOMAP_DEBUG(" done.\n");
+      return true;
+    } else {
+      OCTOMAP_WARNING_STR("Output stream not \"good\" after writing tree");
+      return false;
+    }
+  }
+
+  bool AbstractOccupancyOcTree::writeBinaryDelta(const std::string& filename, unsigned int patch_depth) const{
+    std::ofstream binary_outfile( filename.c_str(), std::ios_base::binary);
+
+    if (!binary_outfile.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+    return writeBinaryDelta(binary_outfile, patch_depth);
+  }
+
+  bool AbstractOccupancyOcTree::writeBinaryDelta(std::ostream &s, unsigned int patch_depth) const{
+    s << deltaFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    s << "id " << this->getTreeType() << std::endl;
+    s << "size "<< this->size() << std::endl;
+    s << "res " << this->getResolution() << std::endl;
+    s << "data" << std::endl;
+
+    writeBinaryDeltaData(s, patch_depth);
+
+    if (s.good()){
+      OCTOMAP_DEBUG(" done.\n");
+      return true;
+    } else {
+      OCTOMAP_WARNING_STR("Output stream not \"good\" after writing tree");
+      return false;
+    }
+  }
+
+  bool AbstractOccupancyOcTree::applyDelta(const std::string& filename){
+    std::ifstream binary_infile( filename.c_str(), std::ios_base::binary);
+    if (!binary_infile.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing read.");
+      return false;
+    }
+    return applyDelta(binary_infile);
+  }
+
+  bool AbstractOccupancyOcTree::applyDelta(std::istream &s){
+    std::string line;
+    std::getline(s, line);
+    if (line.compare(0, deltaFileHeader.length(), deltaFileHeader) != 0){
+      OCTOMAP_ERROR_STR("First line of OcTree delta header does not start with \""<< deltaFileHeader<<"\"");
+      return false;
+    }
+
+    std::string id;
+    unsigned tree_size;
+    double res;
+    if (!AbstractOcTree::readHeader(s, id, tree_size, res))
+      return false;
+
+    if (id != this->getTreeType()){
+      OCTOMAP_ERROR_STR("Delta of a " << id << " cannot be applied to a " << this->getTreeType());
+      return false;
+    }
+    if (this->size() == 0)
+      this->setResolution(res);
+    else if (fabs(res - this->getResolution()) > 1e-6){
+      OCTOMAP_ERROR_STR("Delta resolution " << res << " does not match tree resolution " << this->getResolution());
+      return false;
+    }
+
+    // the size of the source tree is only informative here, its
+    // probabilistic nodes are not necessarily pruned like the ones read
+    return readBinaryDeltaData(s);
+  }
+
+  bool AbstractOccupancyOcTree::writeBinaryChunked(const std::string& filename, unsigned int chunk_depth){
+    // convert to max likelihood first, this makes efficient pruning on binary data possible
+    this->toMaxLikelihood();
+    this->prune();
+    return writeBinaryChunkedConst(filename, chunk_depth);
+  }
+
+  bool AbstractOccupancyOcTree::writeBinaryChunkedConst(const std::string& filename, unsigned int chunk_depth) const{
+    std::ofstream s(filename.c_str(), std::ios_base::binary);
+
+    if (!s.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+
+    s << chunkedFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    s << "id " << this->getTreeType() << std::endl;
+    s << "size "<< this->size() << std::endl;
+    s << "res " << this->getResolution() << std::endl;
+    s << "data" << std::endl;
+
+    writeBinaryChunkedData(s, chunk_depth);
+
+    if (s.good()){
+      OCTOMAP_DEBUG(" done.\n");
+      return true;
+    } else {
+      OCTOMAP_WARNING_STR("Output stream not \"good\" after writing tree");
+      return false;
+    }
+  }
+
+  bool AbstractOccupancyOcTree::readBinaryChunked(const std::string& filename){
+    return readBinaryChunkedFile(filename, false, point3d(), point3d());
+  }
+
+  bool AbstractOccupancyOcTree::readRegion(const std::string& filename, const point3d& min, const point3d& max){
+    return readBinaryChunkedFile(filename, true, min, max);
+  }
+
+  bool AbstractOccupancyOcTree::readBinaryChunkedFile(const std::string& filename, bool use_bbx,
+                                                      const point3d& min, const point3d& max){
+    MemoryMappedFile file;
+    if (!file.open(filename)){
+      OCTOMAP_ERROR_STR("File "<< filename << " not mapped, nothing read.");
+      return false;
+    }
+    MemoryStreamBuf buffer(file.data(), file.size());
+    std::istream s(&buffer);
+
+    std::string line;
+    std::getline(s, line);
+    if (line.compare(0, chunkedFileHeader.length(), chunkedFileHeader) != 0){
+      OCTOMAP_ERROR_STR("First line of OcTree file header does not start with \""<< chunkedFileHeader<<"\"");
+      return false;
+    }
+
+    std::string id;
+    unsigned tree_size;
+    double res;
+    if (!AbstractOcTree::readHeader(s, id, tree_size, res))
+      return false;
+    OCTOMAP_DEBUG_STR("Reading chunked binary octree type "<< id);
+
+    const std::streamoff offset = s.tellg();
+    if (offset < 0 || size_t(offset) > file.size()){
+      OCTOMAP_ERROR_STR("Binary data missing after OcTree header");
+      return false;
+    }
+    this->clear();
+    this->setResolution(res);
+
+    const size_t data_size = file.size() - size_t(offset);
+    if (this->readBinaryChunkedData(file.data() + offset, data_size, use_bbx, min, max) != data_size)
+      return false;
+
+    if (!use_bbx && tree_size != this->size()){
+      OCTOMAP_ERROR("Tree size mismatch: # read nodes (%zu) != # expected nodes (%d)\n",this->size(), tree_size);
+      return false;
+    }
+
+    return true;
+  }
+
   bool AbstractOccupancyOcTree::readBinary(std::istream &s) {
     
     if (!s.good()){
@@ -144,7 +410,15 @@ namespace octomap {
     std::getline(s, line);
     unsigned size;
     double res;
-    if (line.compare(0,AbstractOccupancyOcTree::binaryFileHeader.length(), AbstractOccupancyOcTree::binaryFileHeader) ==0){
+    const bool compressed = (line.compare(0, compressedFileHeader.length(), compressedFileHeader) == 0);
+    if (compressed){
+      std::string id;
+      if (!AbstractOcTree::readHeader(s, id, size, res))
+        return false;
+
+      OCTOMAP_DEBUG_STR("Reading compressed binary octree type "<< id);
+    }
+    else if (line.compare(0,AbstractOccupancyOcTree::binaryFileHeader.length(), AbstractOccupancyOcTree::binaryFileHeader) ==0){
       std::string id;
       if (!AbstractOcTree::readHeader(s, id, size, res))
         return false;
@@ -166,7 +440,21 @@ namespace octomap {
     this->clear();
     this->setResolution(res);
     
-    if (size > 0)
+    if (compressed){
+      // the compressed data is read into memory as a whole:
+      uint64_t compressed_size = 0;
+      s.read((char*)&compressed_size, sizeof(compressed_size));
+      if (!s.good() || compressed_size > uint64_t(std::numeric_limits<std::streamsize>::max())){
+        OCTOMAP_ERROR_STR("Compressed binary data missing after OcTree header");
+        return false;
+      }
+      std::string data(sizeof(compressed_size) + size_t(compressed_size), '\0');
+      memcpy(&data[0], &compressed_size, sizeof(compressed_size));
+      s.read(&data[sizeof(compressed_size)], std::streamsize(compressed_size));
+      if (size > 0 && s.gcount() == std::streamsize(compressed_size))
+        this->readBinaryCompressedData(data.data(), data.size());
+    }
+    else if (size > 0)
       this->readBinaryData(s);
     
     if (size != this->size()){
@@ -178,4 +466,7 @@ namespace octomap {
   }
 
   const std::string AbstractOccupancyOcTree::binaryFileHeader = "# Octomap OcTree binary file";
+  const std::string AbstractOccupancyOcTree::compressedFileHeader = "# Octomap compressed OcTree binary file";
+  const std::string AbstractOccupancyOcTree::deltaFileHeader = "# Octomap OcTree delta file";
+  const std::string AbstractOccupancyOcTree::chunkedFileHeader = "# Octomap chunked OcTree binary file";
 }
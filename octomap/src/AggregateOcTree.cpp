@@ -0,0 +1,207 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <octomap/AggregateOcTree.h>
+
+namespace octomap {
+
+  // node implementation  --------------------------------------
+  AbstractOcTreeNode** AggregateOcTreeNode::newChildrenArray() {
+    ChildrenArray* array = new ChildrenArray(); // value-initialized: no children, zero counts
+    return array->children;
+  }
+
+  void AggregateOcTreeNode::deleteChildrenArray(AbstractOcTreeNode** children) {
+    delete reinterpret_cast<ChildrenArray*>(children);
+  }
+
+  // tree implementation  --------------------------------------
+  AggregateOcTree::AggregateOcTree(double resolution)
+  : OccupancyOcTreeBase<AggregateOcTreeNode>(resolution) {
+    aggregateOcTreeMemberInit.ensureLinking();
+  }
+
+  AggregateOcTree::AggregateOcTree(const AggregateOcTree& rhs)
+  : OccupancyOcTreeBase<AggregateOcTreeNode>(rhs) {
+    updateAggregateData();
+  }
+
+  AggregateOcTreeNode* AggregateOcTree::updateNode(const OcTreeKey& key, float log_odds_update, bool lazy_eval) {
+    AggregateOcTreeNode* node = OccupancyOcTreeBase<AggregateOcTreeNode>::updateNode(key, log_odds_update, lazy_eval);
+    if (!lazy_eval)
+      updateCountsOnPath(key);
+    return node;
+  }
+
+  AggregateOcTreeNode* AggregateOcTree::setNodeValue(const OcTreeKey& key, float log_odds_value, bool lazy_eval) {
+    AggregateOcTreeNode* node = OccupancyOcTreeBase<AggregateOcTreeNode>::setNodeValue(key, log_odds_value, lazy_eval);
+    if (!lazy_eval)
+      updateCountsOnPath(key);
+    return node;
+  }
+
+  void AggregateOcTree::expand() {
+    OccupancyOcTreeBase<AggregateOcTreeNode>::expand();
+    updateAggregateData();
+  }
+
+  void AggregateOcTree::updateAggregateData() {
+    if (root)
+      updateCountsRecurs(root, 0);
+  }
+
+  void AggregateOcTree::restorePagedSubtree(AggregateOcTreeNode* node) {
+    OccupancyOcTreeBase<AggregateOcTreeNode>::restorePagedSubtree(node);
+    // the counts of node are stored with its new children, the ones of
+    // its ancestors are still valid
+    updateCountsRecurs(node, page_depth);
+  }
+
+  void AggregateOcTree::countInBBX(const OcTreeKey& min, const OcTreeKey& max,
+                                   uint64_t& num_occupied, uint64_t& num_free, uint64_t& num_unknown) const {
+    num_occupied = num_free = num_unknown = 0;
+    uint64_t num_total = 1;
+    for (unsigned int i = 0; i < 3; ++i){
+      if (min[i] > max[i])
+        return;
+      num_total *= uint64_t(max[i]) - min[i] + 1;
+    }
+
+    if (root){
+      OcTreeKey root_key(tree_max_val, tree_max_val, tree_max_val);
+      countInBBXRecurs(root, root_key, 0, min, max, num_occupied, num_free);
+    }
+    num_unknown = num_total - num_occupied - num_free;
+  }
+
+  bool AggregateOcTree::countInBBX(const point3d& min, const point3d& max,
+                                   uint64_t& num_occupied, uint64_t& num_free, uint64_t& num_unknown) const {
+    OcTreeKey min_key, max_key;
+    if (!coordToKeyChecked(min, min_key) || !coordToKeyChecked(max, max_key)){
+      OCTOMAP_ERROR_STR("Error in countInBBX: bounding box out of tree bounds");
+      num_occupied = num_free = num_unknown = 0;
+      return false;
+    }
+    countInBBX(min_key, max_key, num_occupied, num_free, num_unknown);
+    return true;
+  }
+
+  void AggregateOcTree::updateNodeCounts(AggregateOcTreeNode* node, unsigned int depth) {
+    // number of voxels in a child leaf:
+    const uint64_t child_voxels = uint64_t(1) << (3 * (tree_depth - depth - 1));
+    uint64_t& num_occupied = node->counts()->num_occupied;
+    uint64_t& num_free = node->counts()->num_free;
+    num_occupied = num_free = 0;
+    for (unsigned int i=0; i<8; i++) {
+      if (!nodeChildExists(node, i))
+        continue;
+
+      const AggregateOcTreeNode* child = getNodeChild(node, i);
+      if (nodeHasChildren(child)){
+        num_occupied += child->getNumOccupied();
+        num_free += child->getNumFree();
+      } else if (isNodeOccupied(child))
+        num_occupied += child_voxels;
+      else
+        num_free += child_voxels;
+    }
+  }
+
+  void AggregateOcTree::updateCountsOnPath(const OcTreeKey& key) {
+    assert(tree_depth < 32);
+    AggregateOcTreeNode* path[32];
+    unsigned int num_inner = 0;
+    for (AggregateOcTreeNode* node = root; node && nodeHasChildren(node); ++num_inner){
+      path[num_inner] = node;
+      unsigned int pos = computeChildIdx(key, tree_depth - 1 - num_inner);
+      node = nodeChildExists(node, pos) ? getNodeChild(node, pos) : NULL;
+    }
+
+    // bottom up:
+    for (unsigned int depth = num_inner; depth > 0; --depth)
+      updateNodeCounts(path[depth-1], depth-1);
+  }
+
+  void AggregateOcTree::updateCountsRecurs(AggregateOcTreeNode* node, unsigned int depth) {
+    // only recurse and update for inner nodes:
+    if (nodeHasChildren(node)){
+      for (unsigned int i=0; i<8; i++) {
+        if (nodeChildExists(node, i))
+          updateCountsRecurs(getNodeChild(node, i), depth+1);
+      }
+      updateNodeCounts(node, depth);
+    }
+  }
+
+  void AggregateOcTree::countInBBXRecurs(const AggregateOcTreeNode* node, const OcTreeKey& key, unsigned int depth,
+                                         const OcTreeKey& min, const OcTreeKey& max,
+                                         uint64_t& num_occupied, uint64_t& num_free) const {
+    // overlap of the node's key range with the box:
+    const int half_size = tree_max_val >> depth;
+    uint64_t num_overlap = 1;
+    bool inside = true;
+    for (unsigned int i = 0; i < 3; ++i){
+      const int node_min = int(key[i]) - half_size;
+      const int node_max = half_size ? int(key[i]) + half_size - 1 : int(key[i]);
+      const int overlap_min = std::max(node_min, int(min[i]));
+      const int overlap_max = std::min(node_max, int(max[i]));
+      if (overlap_max < overlap_min)
+        return;
+      num_overlap *= uint64_t(overlap_max - overlap_min + 1);
+      if (overlap_min != node_min || overlap_max != node_max)
+        inside = false;
+    }
+
+    if (!nodeHasChildren(node)){
+      if (isNodeOccupied(node))
+        num_occupied += num_overlap;
+      else
+        num_free += num_overlap;
+    } else if (inside){
+      num_occupied += node->getNumOccupied();
+      num_free += node->getNumFree();
+    } else {
+      OcTreeKey child_key;
+      key_type center_offset_key = tree_max_val >> (depth + 1);
+      for (unsigned int i=0; i<8; i++) {
+        if (nodeChildExists(node, i)){
+          computeChildKey(i, center_offset_key, key, child_key);
+          countInBBXRecurs(getNodeChild(node, i), child_key, depth+1, min, max, num_occupied, num_free);
+        }
+      }
+    }
+  }
+
+  AggregateOcTree::StaticMemberInitializer AggregateOcTree::aggregateOcTreeMemberInit;
+
+} // end namespace
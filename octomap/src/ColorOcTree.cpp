@@ -118,7 +118,7 @@ namespace octomap {
     for (unsigned int i=0;i<8;i++) {
       deleteNodeChild(node, i);
     }
-    delete[] node->children;
+    ColorOcTreeNode::deleteChildrenArray(node->children);
     node->children = NULL;
 
     return true;
@@ -127,7 +127,7 @@ namespace octomap {
   bool ColorOcTree::isNodeCollapsible(const ColorOcTreeNode* node) const{
     // all children must exist, must not have children of
     // their own and have the same occupancy probability
-    if (!nodeChildExists(node, 0))
+    if (!nodeChildExists(node, 0) || nodeHasPagedChild(node))
       return false;
     
     const ColorOcTreeNode* firstChild = getNodeChild(node, 0);
@@ -0,0 +1,296 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <octomap/FrozenOcTree.h>
+#include <octomap/AbstractOcTree.h>
+#include <octomap/AbstractOccupancyOcTree.h>
+#include <cmath>
+#include <fstream>
+
+namespace octomap {
+
+  /// number of set bits in the lower 16 bits of x
+  static inline unsigned int countBits16(unsigned int x){
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0F0F;
+    return (x + (x >> 8)) & 0x1F;
+  }
+
+  /// one bit (at 2*i) for every inner child i in child_codes
+  static inline unsigned int innerChildBits(unsigned int child_codes){
+    return child_codes & (child_codes >> 1) & 0x5555;
+  }
+
+  FrozenOcTree::FrozenOcTree()
+    : nodes(NULL), num_nodes(0), resolution(0.1), resolution_factor(10.0), tree_size(0)
+  {
+  }
+
+  void FrozenOcTree::clear(){
+    nodes = NULL;
+    num_nodes = 0;
+    tree_size = 0;
+    std::vector<Node>().swap(built_nodes);
+    file.close();
+  }
+
+  bool FrozenOcTree::readBinary(const std::string& filename){
+    MemoryMappedFile binary_infile;
+    if (!binary_infile.open(filename)){
+      OCTOMAP_ERROR_STR("File "<< filename << " not mapped, nothing read.");
+      return false;
+    }
+    return readBinary(binary_infile.data(), binary_infile.size());
+  }
+
+  bool FrozenOcTree::readBinary(const char* data, size_t size){
+    clear();
+
+    MemoryStreamBuf buffer(data, size);
+    std::istream s(&buffer);
+    std::string line;
+    std::getline(s, line);
+    if (line.compare(0, AbstractOccupancyOcTree::binaryFileHeader.length(), AbstractOccupancyOcTree::binaryFileHeader) != 0){
+      OCTOMAP_ERROR_STR("First line of OcTree file header does not start with \""<< AbstractOccupancyOcTree::binaryFileHeader<<"\"");
+      return false;
+    }
+
+    unsigned header_size;
+    double res;
+    if (!AbstractOcTree::readHeader(s, tree_type, header_size, res) || res <= 0.0)
+      return false;
+    const std::streamoff offset = s.tellg();
+    if (offset < 0 || size_t(offset) > size){
+      OCTOMAP_ERROR_STR("Binary data missing after OcTree header");
+      return false;
+    }
+    resolution = res;
+    resolution_factor = 1.0 / res;
+    if (header_size == 0)
+      return true;
+
+    // every node of the binary format has 2 bytes, which bounds the number of inner nodes:
+    built_nodes.reserve((size - size_t(offset)) / 2);
+    built_nodes.resize(1);
+    const char* pos = data + offset;
+    if (!buildRecurs(pos, data + size, 0, 0)){
+      OCTOMAP_ERROR_STR("Binary data ended unexpectedly after " << (pos - data - offset) << " bytes.");
+      clear();
+      return false;
+    }
+    nodes = &built_nodes[0];
+    num_nodes = built_nodes.size();
+
+    // inner nodes and their leafs:
+    tree_size = 1;
+    for (size_t i = 0; i < num_nodes; ++i){
+      const unsigned int codes = nodes[i].child_codes;
+      tree_size += countBits16((codes | (codes >> 1)) & 0x5555);
+    }
+    if (tree_size != header_size){
+      OCTOMAP_ERROR("Tree size mismatch: # read nodes (%zu) != # expected nodes (%d)\n", tree_size, header_size);
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool FrozenOcTree::buildRecurs(const char*& data, const char* end, size_t index, unsigned int depth){
+    if (end - data < 2 || depth >= tree_depth)
+      return false;
+
+    const unsigned int child_codes = (unsigned int)(unsigned char) data[0]
+                                   | ((unsigned int)(unsigned char) data[1] << 8);
+    data += 2;
+
+    // reserve the inner children first, so that they are consecutive:
+    const size_t first_child = built_nodes.size();
+    built_nodes.resize(first_child + countBits16(innerChildBits(child_codes)));
+    if (built_nodes.size() > size_t(0xFFFFFFFF)){
+      OCTOMAP_ERROR_STR("Too many inner nodes for a FrozenOcTree");
+      return false;
+    }
+
+    unsigned int flags = 0;
+    size_t child_index = first_child;
+    for (unsigned int i = 0; i < 8; ++i){
+      const unsigned int code = (child_codes >> (2*i)) & 3;
+      if (code == 0)
+        flags |= HAS_UNKNOWN;
+      else if (code == 2)
+        flags |= HAS_OCCUPIED;
+      else if (code == 3){
+        if (!buildRecurs(data, end, child_index, depth + 1))
+          return false;
+        flags |= built_nodes[child_index].flags;
+        ++child_index;
+      }
+    }
+
+    Node& node = built_nodes[index];
+    node.first_child = uint32_t(first_child);
+    node.child_codes = uint16_t(child_codes);
+    node.flags = uint16_t(flags);
+    return true;
+  }
+
+  bool FrozenOcTree::write(const std::string& filename) const{
+    std::ofstream s(filename.c_str(), std::ios_base::binary);
+    if (!s.is_open()){
+      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+      return false;
+    }
+
+    s << binaryFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+    s << "id " << tree_type << std::endl;
+    s << "size "<< tree_size << std::endl;
+    s << "res " << resolution << std::endl;
+    s << "data" << std::endl;
+
+    // align the node array for direct access after mapping:
+    const char padding[sizeof(Node)] = {0};
+    s.write(padding, (sizeof(Node) - size_t(s.tellp()) % sizeof(Node)) % sizeof(Node));
+    Node mark;
+    mark.first_child = byteOrderMark;
+    mark.child_codes = mark.flags = 0;
+    s.write(reinterpret_cast<const char*>(&mark), sizeof(Node));
+    if (num_nodes > 0)
+      s.write(reinterpret_cast<const char*>(nodes), std::streamsize(num_nodes * sizeof(Node)));
+
+    if (!s.good()){
+      OCTOMAP_WARNING_STR("Output stream not \"good\" after writing tree");
+      return false;
+    }
+    return true;
+  }
+
+  bool FrozenOcTree::read(const std::string& filename){
+    clear();
+    if (!file.open(filename)){
+      OCTOMAP_ERROR_STR("File "<< filename << " not mapped, nothing read.");
+      return false;
+    }
+
+    MemoryStreamBuf buffer(file.data(), file.size());
+    std::istream s(&buffer);
+    std::string line;
+    std::getline(s, line);
+    if (line.compare(0, binaryFileHeader.length(), binaryFileHeader) != 0){
+      OCTOMAP_ERROR_STR("First line of file header does not start with \""<< binaryFileHeader<<"\"");
+      clear();
+      return false;
+    }
+
+    unsigned header_size;
+    double res;
+    if (!AbstractOcTree::readHeader(s, tree_type, header_size, res) || res <= 0.0){
+      clear();
+      return false;
+    }
+    std::streamoff offset = s.tellg();
+    if (offset < 0)
+      offset = std::streamoff(file.size());
+    offset += (sizeof(Node) - size_t(offset) % sizeof(Node)) % sizeof(Node);
+    if (size_t(offset) + sizeof(Node) > file.size() || (file.size() - size_t(offset)) % sizeof(Node) != 0){
+      OCTOMAP_ERROR_STR("Invalid node data in " << filename);
+      clear();
+      return false;
+    }
+    const uint32_t mark = reinterpret_cast<const Node*>(file.data() + offset)->first_child;
+    if (mark != byteOrderMark){
+      if (mark == 0x04030201)
+        OCTOMAP_ERROR_STR(filename << " was written on a machine with a different byte order");
+      else
+        OCTOMAP_ERROR_STR("Invalid byte order mark in " << filename);
+      clear();
+      return false;
+    }
+    offset += sizeof(Node);
+    if (header_size > 0 && size_t(offset) == file.size()){
+      OCTOMAP_ERROR_STR("Invalid node data in " << filename);
+      clear();
+      return false;
+    }
+
+    resolution = res;
+    resolution_factor = 1.0 / res;
+    tree_size = header_size;
+    num_nodes = (file.size() - size_t(offset)) / sizeof(Node);
+    nodes = (num_nodes > 0) ? reinterpret_cast<const Node*>(file.data() + offset) : NULL;
+    return true;
+  }
+
+  FrozenOcTree::State FrozenOcTree::search(const OcTreeKey& key, unsigned int depth) const{
+    if (num_nodes == 0)
+      return UNKNOWN;
+    if (depth == 0 || depth > tree_depth)
+      depth = tree_depth;
+
+    size_t index = 0;
+    for (unsigned int d = 0; d < depth; ++d){
+      const Node& node = nodes[index];
+      const unsigned int pos = computeChildIdx(key, int(tree_depth - 1 - d));
+      const unsigned int code = (node.child_codes >> (2*pos)) & 3;
+      if (code != 3)
+        return State(code);
+
+      // skip the inner children before pos:
+      index = node.first_child + countBits16(innerChildBits(node.child_codes) & ((1u << (2*pos)) - 1));
+      if (index >= num_nodes) // corrupt file
+        return UNKNOWN;
+    }
+
+    return (nodes[index].flags & HAS_OCCUPIED) ? OCCUPIED : FREE;
+  }
+
+  FrozenOcTree::State FrozenOcTree::search(const point3d& coord, unsigned int depth) const{
+    OcTreeKey key;
+    if (!coordToKeyChecked(coord, key))
+      return UNKNOWN;
+    return search(key, depth);
+  }
+
+  bool FrozenOcTree::coordToKeyChecked(const point3d& coord, OcTreeKey& key) const{
+    for (unsigned int i = 0; i < 3; ++i){
+      const int scaled_coord = ((int) floor(resolution_factor * coord(i))) + int(tree_max_val);
+      if (scaled_coord < 0 || scaled_coord >= int(2*tree_max_val))
+        return false;
+      key[i] = key_type(scaled_coord);
+    }
+    return true;
+  }
+
+  const std::string FrozenOcTree::binaryFileHeader = "# Octomap FrozenOcTree file";
+
+} // namespace
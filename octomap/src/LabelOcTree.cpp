@@ -139,7 +139,7 @@ bool LabelOcTree::pruneNode(LabelOcTreeNode* node) {
     for (unsigned int i=0;i<8;i++) {
         deleteNodeChild(node, i);
     }
-    delete[] node->children;
+    LabelOcTreeNode::deleteChildrenArray(node->children);
     node->children = NULL;
 
     return true;
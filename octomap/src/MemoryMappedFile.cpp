@@ -0,0 +1,194 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <octomap/MemoryMappedFile.h>
+#include <octomap/octomap_types.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace octomap {
+
+  MemoryMappedFile::MemoryMappedFile()
+    : file_data(NULL), file_size(0)
+#ifdef _WIN32
+    , file_handle(INVALID_HANDLE_VALUE), mapping_handle(NULL)
+#endif
+  {
+  }
+
+  MemoryMappedFile::~MemoryMappedFile(){
+    close();
+  }
+
+#ifdef _WIN32
+  bool MemoryMappedFile::open(const std::string& filename){
+    close();
+
+    file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE){
+      OCTOMAP_DEBUG_STR("Could not open file " << filename);
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_handle, &size) || size.QuadPart == 0){
+      OCTOMAP_DEBUG_STR("Could not map empty file " << filename);
+      close();
+      return false;
+    }
+
+    mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_handle != NULL)
+      file_data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (file_data == NULL){
+      OCTOMAP_DEBUG_STR("Could not map file " << filename);
+      close();
+      return false;
+    }
+    file_size = size_t(size.QuadPart);
+    return true;
+  }
+
+  void MemoryMappedFile::close(){
+    if (file_data)
+      UnmapViewOfFile(file_data);
+    if (mapping_handle)
+      CloseHandle(mapping_handle);
+    if (file_handle != INVALID_HANDLE_VALUE)
+      CloseHandle(file_handle);
+
+    file_data = NULL;
+    file_size = 0;
+    mapping_handle = NULL;
+    file_handle = INVALID_HANDLE_VALUE;
+  }
+
+  void MemoryMappedFile::release(const char* /*begin*/, size_t /*size*/){
+    // views of files cannot be discarded selectively, the working set is trimmed by the OS
+  }
+
+#else
+  bool MemoryMappedFile::open(const std::string& filename){
+    close();
+
+    // pipes and devices are not opened, so that they can still be read as a stream:
+    struct stat path_stat;
+    if (stat(filename.c_str(), &path_stat) == 0 && !S_ISREG(path_stat.st_mode)){
+      OCTOMAP_DEBUG_STR("Could not map special file " << filename);
+      return false;
+    }
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+      OCTOMAP_DEBUG_STR("Could not open file " << filename);
+      return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0){
+      OCTOMAP_DEBUG_STR("Could not map empty file " << filename);
+      ::close(fd);
+      return false;
+    }
+
+    // the mapping stays valid after closing the file descriptor:
+    void* mapping = mmap(NULL, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED){
+      OCTOMAP_DEBUG_STR("Could not map file " << filename);
+      return false;
+    }
+    file_data = static_cast<const char*>(mapping);
+    file_size = size_t(file_stat.st_size);
+    return true;
+  }
+
+  void MemoryMappedFile::close(){
+    if (file_data)
+      munmap(const_cast<char*>(file_data), file_size);
+
+    file_data = NULL;
+    file_size = 0;
+  }
+
+  void MemoryMappedFile::release(const char* begin, size_t size){
+    if (!file_data || begin < file_data || begin + size > file_data + file_size)
+      return;
+
+    const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+    size_t first = (size_t(begin - file_data) + page_size - 1) / page_size * page_size;
+    size_t last = size_t(begin + size - file_data) / page_size * page_size;
+    if (first < last)
+      madvise(const_cast<char*>(file_data) + first, last - first, MADV_DONTNEED);
+  }
+#endif
+
+
+  MemoryStreamBuf::MemoryStreamBuf(const char* data, size_t size){
+    char* begin = const_cast<char*>(data); // the get area is never written
+    setg(begin, begin, begin + size);
+  }
+
+  MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                     std::ios_base::openmode which){
+    if (!(which & std::ios_base::in))
+      return pos_type(off_type(-1));
+
+    char* target;
+    if (dir == std::ios_base::beg)
+      target = eback() + off;
+    else if (dir == std::ios_base::cur)
+      target = gptr() + off;
+    else
+      target = egptr() + off;
+
+    if (target < eback() || target > egptr())
+      return pos_type(off_type(-1));
+
+    setg(eback(), target, egptr());
+    return pos_type(off_type(target - eback()));
+  }
+
+  MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which){
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+
+} // namespace
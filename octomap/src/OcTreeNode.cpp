@@ -43,7 +43,7 @@
 namespace octomap {
 
   OcTreeNode::OcTreeNode()
-    : OcTreeDataNode<float>(0.0)
+    : OcTreeDataNode<float>(0.0), flags(0)
   {
   }
 
@@ -88,6 +88,19 @@ namespace octomap {
     return max;
   }
 
+  void OcTreeNode::updateHasUnknown(){
+    flags &= ~HAS_UNKNOWN;
+    if (children == NULL)
+      return;
+
+    for (unsigned int i=0; i<8; i++) {
+      if (children[i] == NULL || static_cast<OcTreeNode*>(children[i])->hasUnknown()) {
+        flags |= HAS_UNKNOWN;
+        return;
+      }
+    }
+  }
+
   void OcTreeNode::addValue(const float& logOdds) {
     value += logOdds;
   }
@@ -67,6 +67,19 @@ namespace octomap {
     OccupancyOcTreeBase<OcTreeNodeStamped>::updateNodeLogOdds(node, prob_miss_log);
   }
 
+  void OcTreeStamped::writePagedNode(const OcTreeNodeStamped* node, std::ostream& s) const{
+    node->writeData(s);
+    unsigned int timestamp = node->getTimestamp();
+    s.write((const char*) &timestamp, sizeof(timestamp));
+  }
+
+  void OcTreeStamped::readPagedNode(OcTreeNodeStamped* node, std::istream& s) const{
+    node->readData(s);
+    unsigned int timestamp = 0;
+    s.read((char*) &timestamp, sizeof(timestamp));
+    node->setTimestamp(timestamp);
+  }
+
   OcTreeStamped::StaticMemberInitializer OcTreeStamped::ocTreeStampedMemberInit;
 
 } // end namespace
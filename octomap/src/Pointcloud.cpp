@@ -41,6 +41,8 @@
 #else
   #include <ext/algorithm>
 #endif
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <math.h>
 #include <assert.h>
@@ -284,33 +286,93 @@ namespace octomap {
     return s;
   }
 
+  // Binary point format (as in Vector3::readBinary / writeBinary): int32 3, followed
+  // by the 3 coordinates as doubles, in host byte order like the rest of the graph
+  // file. The points are converted in blocks instead of with separate stream calls
+  // per coordinate.
+  static const size_t BINARY_POINT_SIZE = sizeof(int32_t) + 3*sizeof(double);
+  static const size_t BINARY_POINT_BLOCK = 16384; // points converted per block
+
+  static void decodeBinaryPoints(const char* data, size_t num_points, point3d_collection& points) {
+    double coords[3];
+    for (size_t i = 0; i < num_points; ++i, data += BINARY_POINT_SIZE) {
+      memcpy(coords, data + sizeof(int32_t), sizeof(coords));
+      points.push_back(point3d((float) coords[0], (float) coords[1], (float) coords[2]));
+    }
+  }
+
+  static void encodeBinaryPoints(const point3d* points, size_t num_points, char* data) {
+    int32_t dim = 3;
+    double coords[3];
+    for (size_t i = 0; i < num_points; ++i, data += BINARY_POINT_SIZE) {
+      for (unsigned int c = 0; c < 3; ++c)
+        coords[c] = points[i](c);
+      memcpy(data, &dim, sizeof(dim));
+      memcpy(data + sizeof(dim), coords, sizeof(coords));
+    }
+  }
+
+  static uint32_t decodeBinaryPointcloudSize(const char* data) {
+    uint32_t pc_size;
+    memcpy(&pc_size, data, sizeof(pc_size));
+    return pc_size;
+  }
+
   std::istream& Pointcloud::readBinary(std::istream &s) {
 
-    uint32_t pc_size = 0;
-    s.read((char*)&pc_size, sizeof(pc_size));
+    char size_data[sizeof(uint32_t)];
+    s.read(size_data, sizeof(size_data));
+    if (s.fail()) {
+      OCTOMAP_ERROR("Pointcloud::readBinary: ERROR.\n" );
+      return s;
+    }
+    uint32_t pc_size = decodeBinaryPointcloudSize(size_data);
     OCTOMAP_DEBUG("Reading %d points from binary file...", pc_size);
 
     if (pc_size > 0) {
-      this->points.reserve(pc_size);
-      point3d p;
-      for (uint32_t i=0; i<pc_size; i++) {
-        p.readBinary(s);
-        if (!s.fail()) {
-          this->push_back(p);
-        }
-        else {
+      this->points.reserve(this->points.size() + pc_size);
+      std::vector<char> buffer(std::min((size_t) pc_size, BINARY_POINT_BLOCK) * BINARY_POINT_SIZE);
+      for (size_t done = 0; done < pc_size; ) {
+        size_t num_block = std::min((size_t) pc_size - done, BINARY_POINT_BLOCK);
+        s.read(&buffer[0], num_block * BINARY_POINT_SIZE);
+        if (s.fail()) {
           OCTOMAP_ERROR("Pointcloud::readBinary: ERROR.\n" );
           break;
         }
+        decodeBinaryPoints(&buffer[0], num_block, this->points);
+        done += num_block;
       }
     }
-    assert(pc_size == this->size());
-    
+
     OCTOMAP_DEBUG("done.\n");
 
     return s;
   }
 
+  size_t Pointcloud::readBinary(const char* data, size_t size) {
+    if (size < sizeof(uint32_t)) {
+      OCTOMAP_ERROR("Pointcloud::readBinary: data too short.\n");
+      return 0;
+    }
+    uint32_t pc_size = decodeBinaryPointcloudSize(data);
+    size_t data_size = sizeof(uint32_t) + (size_t) pc_size * BINARY_POINT_SIZE;
+    if (data_size > size) {
+      OCTOMAP_ERROR("Pointcloud::readBinary: data too short for %u points.\n", pc_size);
+      return 0;
+    }
+
+    this->points.reserve(this->points.size() + pc_size);
+    decodeBinaryPoints(data + sizeof(uint32_t), pc_size, this->points);
+    return data_size;
+  }
+
+  size_t Pointcloud::binaryDataSize(const char* data, size_t size) {
+    if (size < sizeof(uint32_t))
+      return 0;
+    size_t data_size = sizeof(uint32_t) + (size_t) decodeBinaryPointcloudSize(data) * BINARY_POINT_SIZE;
+    return (data_size <= size) ? data_size : 0;
+  }
+
 
   std::ostream& Pointcloud::writeBinary(std::ostream &s) const {
 
@@ -325,8 +387,14 @@ namespace octomap {
     OCTOMAP_DEBUG("Writing %u points to binary file...", pc_size);
     s.write((char*)&pc_size, sizeof(pc_size));
 
-    for (Pointcloud::const_iterator it = this->begin(); it != this->end(); it++) {
-      it->writeBinary(s);
+    if (orig_size > 0) {
+      std::vector<char> buffer(std::min(orig_size, BINARY_POINT_BLOCK) * BINARY_POINT_SIZE);
+      for (size_t done = 0; done < orig_size; ) {
+        size_t num_block = std::min(orig_size - done, BINARY_POINT_BLOCK);
+        encodeBinaryPoints(&this->points[done], num_block, &buffer[0]);
+        s.write(&buffer[0], num_block * BINARY_POINT_SIZE);
+        done += num_block;
+      }
     }
     OCTOMAP_DEBUG("done.\n");
 
@@ -0,0 +1,228 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <octomap/PrefixCoder.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace octomap {
+
+  const unsigned int PrefixCode::SYMBOL_BITS;
+  const unsigned int PrefixCode::NUM_SYMBOLS;
+  const unsigned int PrefixCode::MAX_CODE_LENGTH;
+
+  namespace {
+    /// symbols occurring less often are escaped (a table entry costs 20 bits)
+    const uint32_t MIN_SYMBOL_COUNT = 4;
+
+    /// @return the code length of each weight in a Huffman code
+    std::vector<unsigned int> huffmanLengths(const std::vector<uint64_t>& weights){
+      const size_t n = weights.size();
+      std::vector<unsigned int> lengths(n, 1);
+      if (n < 2)
+        return lengths;
+
+      // nodes 0..n-1 are the leafs, the parents are appended (the root last):
+      typedef std::pair<uint64_t, size_t> WeightedNode;
+      std::priority_queue<WeightedNode, std::vector<WeightedNode>, std::greater<WeightedNode> > queue;
+      for (size_t i = 0; i < n; ++i)
+        queue.push(WeightedNode(weights[i], i));
+      std::vector<size_t> parents(2*n - 1, 0);
+      size_t next = n;
+      while (queue.size() > 1){
+        const WeightedNode a = queue.top();
+        queue.pop();
+        const WeightedNode b = queue.top();
+        queue.pop();
+        parents[a.second] = next;
+        parents[b.second] = next;
+        queue.push(WeightedNode(a.first + b.first, next++));
+      }
+
+      std::vector<unsigned int> depths(2*n - 1, 0);
+      for (size_t i = 2*n - 2; i-- > 0;)
+        depths[i] = depths[parents[i]] + 1;
+      for (size_t i = 0; i < n; ++i)
+        lengths[i] = depths[i];
+      return lengths;
+    }
+
+    /// orders symbols by decreasing count
+    struct MoreFrequent {
+      bool operator()(const std::pair<unsigned int, uint32_t>& a, const std::pair<unsigned int, uint32_t>& b) const {
+        return a.second > b.second;
+      }
+    };
+
+    /// canonical code order: by length, then by symbol (escape code last)
+    struct CodeOrder {
+      const std::vector<unsigned int>& lengths;
+      const std::vector<unsigned int>& symbols;
+      CodeOrder(const std::vector<unsigned int>& l, const std::vector<unsigned int>& s) : lengths(l), symbols(s) {}
+      bool operator()(size_t a, size_t b) const {
+        return lengths[a] < lengths[b] || (lengths[a] == lengths[b] && symbols[a] < symbols[b]);
+      }
+    };
+
+    /// @return the canonical code of each length
+    std::vector<uint32_t> canonicalCodes(const std::vector<unsigned int>& lengths,
+                                         const std::vector<unsigned int>& symbols){
+      std::vector<size_t> order(lengths.size());
+      for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+      std::sort(order.begin(), order.end(), CodeOrder(lengths, symbols));
+
+      std::vector<uint32_t> codes(lengths.size(), 0);
+      uint32_t code = 0;
+      unsigned int length = 0;
+      for (size_t i = 0; i < order.size(); ++i){
+        code <<= lengths[order[i]] - length;
+        length = lengths[order[i]];
+        codes[order[i]] = code++;
+      }
+      return codes;
+    }
+  }
+
+  void PrefixCode::build(const std::vector<uint32_t>& counts){
+    // the most frequent symbols get a code, the others share the escape code:
+    // (symbol, count) pairs
+    std::vector<std::pair<unsigned int, uint32_t> > candidates;
+    uint64_t escape_count = 0;
+    for (unsigned int s = 0; s < NUM_SYMBOLS && s < counts.size(); ++s){
+      if (counts[s] >= MIN_SYMBOL_COUNT)
+        candidates.push_back(std::make_pair(s, counts[s]));
+      else
+        escape_count += counts[s];
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), MoreFrequent());
+    const size_t max_symbols = (size_t(1) << MAX_CODE_LENGTH) - 1;
+    for (size_t i = max_symbols; i < candidates.size(); ++i)
+      escape_count += candidates[i].second;
+    if (candidates.size() > max_symbols)
+      candidates.resize(max_symbols);
+    if (candidates.empty()) // a code needs at least two entries
+      candidates.push_back(std::make_pair(0u, 0u));
+
+    // entries: candidates, then the escape code
+    std::vector<unsigned int> entry_symbols;
+    std::vector<uint64_t> weights;
+    for (size_t i = 0; i < candidates.size(); ++i){
+      entry_symbols.push_back(candidates[i].first);
+      weights.push_back(std::max<uint64_t>(candidates[i].second, 1));
+    }
+    entry_symbols.push_back(NUM_SYMBOLS);
+    weights.push_back(std::max<uint64_t>(escape_count, 1));
+
+    // flatten the weights until the code is short enough (with all weights
+    // equal to 1, the code of at most 2^MAX_CODE_LENGTH entries is):
+    std::vector<unsigned int> entry_lengths = huffmanLengths(weights);
+    while (*std::max_element(entry_lengths.begin(), entry_lengths.end()) > MAX_CODE_LENGTH){
+      for (size_t i = 0; i < weights.size(); ++i)
+        weights[i] = (weights[i] + 1) / 2;
+      entry_lengths = huffmanLengths(weights);
+    }
+    const std::vector<uint32_t> entry_codes = canonicalCodes(entry_lengths, entry_symbols);
+
+    symbols.clear();
+    symbol_lengths.clear();
+    codes.assign(NUM_SYMBOLS, 0);
+    lengths.assign(NUM_SYMBOLS, 0);
+    for (size_t i = 0; i + 1 < entry_symbols.size(); ++i){
+      codes[entry_symbols[i]] = entry_codes[i];
+      lengths[entry_symbols[i]] = (uint8_t) entry_lengths[i];
+    }
+    for (unsigned int s = 0; s < NUM_SYMBOLS; ++s){
+      if (lengths[s] > 0){
+        symbols.push_back((uint16_t) s);
+        symbol_lengths.push_back(lengths[s]);
+      }
+    }
+    escape_length = entry_lengths.back();
+    escape_code = entry_codes.back();
+  }
+
+  void PrefixCode::writeTable(BitWriter& writer) const{
+    writer.writeBits(escape_length, 4);
+    writer.writeBits((uint32_t) symbols.size(), MAX_CODE_LENGTH);
+    for (size_t i = 0; i < symbols.size(); ++i){
+      writer.writeBits(symbols[i], SYMBOL_BITS);
+      writer.writeBits(symbol_lengths[i], 4);
+    }
+  }
+
+  bool PrefixCode::readTable(BitReader& reader){
+    escape_length = reader.readBits(4);
+    const size_t num_symbols = reader.readBits(MAX_CODE_LENGTH);
+    symbols.resize(num_symbols);
+    symbol_lengths.resize(num_symbols);
+    for (size_t i = 0; i < num_symbols; ++i){
+      symbols[i] = (uint16_t) reader.readBits(SYMBOL_BITS);
+      symbol_lengths[i] = (uint8_t) reader.readBits(4);
+    }
+    if (reader.overrunData())
+      return false;
+
+    // symbols need to be unique and the code complete, so that every
+    // MAX_CODE_LENGTH bit prefix decodes to an entry:
+    std::vector<unsigned int> entry_symbols(symbols.begin(), symbols.end());
+    std::vector<unsigned int> entry_lengths(symbol_lengths.begin(), symbol_lengths.end());
+    entry_symbols.push_back(NUM_SYMBOLS);
+    entry_lengths.push_back(escape_length);
+    uint32_t code_space = 0;
+    for (size_t i = 0; i < entry_symbols.size(); ++i){
+      if (entry_lengths[i] < 1 || entry_lengths[i] > MAX_CODE_LENGTH
+          || (i > 0 && entry_symbols[i] <= entry_symbols[i - 1]))
+        return false;
+      code_space += uint32_t(1) << (MAX_CODE_LENGTH - entry_lengths[i]);
+    }
+    if (code_space != (uint32_t(1) << MAX_CODE_LENGTH))
+      return false;
+
+    const std::vector<uint32_t> entry_codes = canonicalCodes(entry_lengths, entry_symbols);
+    decode_table.resize(size_t(1) << MAX_CODE_LENGTH);
+    for (size_t i = 0; i < entry_symbols.size(); ++i){
+      const unsigned int shift = MAX_CODE_LENGTH - entry_lengths[i];
+      const uint32_t entry = entry_symbols[i] | (entry_lengths[i] << 24);
+      for (uint32_t prefix = entry_codes[i] << shift; prefix < ((entry_codes[i] + 1) << shift); ++prefix)
+        decode_table[prefix] = entry;
+    }
+    escape_code = entry_codes.back();
+    return true;
+  }
+
+} // namespace
@@ -38,6 +38,7 @@
 
 #include <octomap/math/Pose6D.h>
 #include <octomap/ScanGraph.h>
+#include <octomap/MemoryMappedFile.h>
 
 namespace octomap {
 
@@ -53,7 +54,12 @@ namespace octomap {
 
     // file structure:    pointcloud | pose | id
 
-    scan->writeBinary(s);
+    if (scan != NULL)
+      scan->writeBinary(s);
+    else if (scan_data != NULL) // not loaded, copy from the graph file
+      s.write(scan_data, scan_data_size);
+    else
+      Pointcloud().writeBinary(s);
     pose.writeBinary(s);
 
     uint32_t uintId = static_cast<uint32_t>(id);
@@ -64,8 +70,12 @@ namespace octomap {
 
   std::istream& ScanNode::readBinary(std::istream &s) {
 
+    if (this->scan != NULL)
+      delete this->scan;
     this->scan = new Pointcloud();
     this->scan->readBinary(s);
+    this->scan_data = NULL;
+    this->scan_data_size = 0;
 
     this->pose.readBinary(s);
 
@@ -77,6 +87,33 @@ namespace octomap {
   }
 
 
+  Pointcloud* ScanNode::getScan() const {
+    if (scan == NULL && scan_data != NULL) {
+      Pointcloud* pc = new Pointcloud();
+      if (pc->readBinary(scan_data, scan_data_size) == 0)
+        OCTOMAP_ERROR("ScanNode::getScan: could not read scan %u from graph file.\n", id);
+      scan = pc;
+    }
+    return scan;
+  }
+
+  void ScanNode::unloadScan() {
+    if (scan != NULL && scan_data != NULL) {
+      delete scan;
+      scan = NULL;
+    }
+  }
+
+  size_t ScanNode::getNumPoints() const {
+    if (scan != NULL)
+      return scan->size();
+    else if (scan_data != NULL)
+      return (scan_data_size - sizeof(uint32_t)) / (sizeof(int32_t) + 3*sizeof(double));
+    else
+      return 0;
+  }
+
+
   std::ostream& ScanNode::writePoseASCII(std::ostream &s) const {
     s << " " << this->id;  // export pose for human editor
     s << " ";
@@ -173,6 +210,7 @@ namespace octomap {
       delete edges[i];
     }
     edges.clear();
+    mapped_file.close();
   }
 
 
@@ -310,7 +348,7 @@ namespace octomap {
 
   void ScanGraph::transformScans() {
     for(ScanGraph::iterator it=this->begin(); it != this->end(); it++) {
-      ((*it)->scan)->transformAbsolute((*it)->pose);
+      (*it)->getScan()->transformAbsolute((*it)->pose);
     }
   }
 
@@ -355,15 +393,32 @@ namespace octomap {
     return s;
   }
 
-  bool ScanGraph::readBinary(const std::string& filename) {
-    std::ifstream binary_infile(filename.c_str(), std::ios_base::binary);
-    if (!binary_infile.is_open()){
-      OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing read.");
-      return false;
+  bool ScanGraph::readBinary(const std::string& filename, bool lazy) {
+    this->clear();
+    if (!mapped_file.open(filename)){
+      // files which cannot be mapped (e.g. pipes) are read completely as a stream:
+      std::ifstream binary_infile(filename.c_str(), std::ios_base::binary);
+      if (!binary_infile.is_open()){
+        OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing read.");
+        return false;
+      }
+      bool success = !readBinary(binary_infile).fail();
+      if (!success)
+        this->clear();
+      return success;
     }
-    readBinary(binary_infile);
-    binary_infile.close();
-    return true;
+
+    MemoryStreamBuf buffer(mapped_file.data(), mapped_file.size());
+    std::istream s(&buffer);
+    readBinaryData(s, lazy ? mapped_file.data() : NULL);
+    bool success = !s.fail();
+
+    // keep the file mapped only while scans refer to it
+    if (!lazy || !success)
+      mapped_file.close();
+    if (!success)
+      this->clear();
+    return success;
   }
 
   std::istream& ScanGraph::readBinary(std::ifstream &s) {
@@ -374,7 +429,10 @@ namespace octomap {
       OCTOMAP_WARNING_STR("Input filestream not \"good\" in ScanGraph::readBinary");
     }
     this->clear();
+    return readBinaryData(s, NULL);
+  }
 
+  std::istream& ScanGraph::readBinaryData(std::istream &s, const char* mapped_data) {
     // read nodes  ---------------------------------
     unsigned int graph_size = 0;
     s.read((char*)&graph_size, sizeof(graph_size));
@@ -386,12 +444,30 @@ namespace octomap {
       for (unsigned int i=0; i<graph_size; i++) {
 
         ScanNode* node = new ScanNode();
-        node->readBinary(s);
+        if (mapped_data != NULL) {
+          // only reference the scan, it is read on first access
+          std::streamoff pos = s.tellg();
+          size_t available = mapped_file.size() - (size_t) pos;
+          node->scan_data = mapped_data + pos;
+          node->scan_data_size = Pointcloud::binaryDataSize(node->scan_data, available);
+          if (node->scan_data_size == 0)
+            s.setstate(std::ios_base::failbit);
+          else {
+            s.seekg(node->scan_data_size, std::ios_base::cur);
+            node->pose.readBinary(s);
+            uint32_t uintId;
+            s.read((char*)&uintId, sizeof(uintId));
+            node->id = uintId;
+          }
+        }
+        else
+          node->readBinary(s);
         if (!s.fail()) {
           this->nodes.push_back(node);
         }
         else {
           OCTOMAP_ERROR("ScanGraph::readBinary: ERROR.\n" );
+          delete node;
           break;
         }
       }
@@ -588,7 +664,7 @@ namespace octomap {
   void ScanGraph::cropEachScan(point3d lowerBound, point3d upperBound) {
 
     for (ScanGraph::iterator it = this->begin(); it != this->end(); it++) {
-      ((*it)->scan)->crop(lowerBound, upperBound);
+      (*it)->getScan()->crop(lowerBound, upperBound);
     }
   }
 
@@ -599,7 +675,7 @@ namespace octomap {
     // for all node in graph...
     for (ScanGraph::iterator it = this->begin(); it != this->end(); it++) {
       pose6d scan_pose = (*it)->pose;
-      Pointcloud* pc = new Pointcloud((*it)->scan);
+      Pointcloud* pc = new Pointcloud((*it)->getScan());
       pc->transformAbsolute(scan_pose);
       pc->crop(lowerBound, upperBound);
       pc->transform(scan_pose.inv());
@@ -612,7 +688,7 @@ namespace octomap {
     size_t retval = 0;
     
     for (ScanGraph::const_iterator it = this->begin(); it != this->end(); it++) {
-      retval += (*it)->scan->size();
+      retval += (*it)->getNumPoints();
       if ((max_id > 0) && ((*it)->id == max_id)) break;
     }
     return retval;
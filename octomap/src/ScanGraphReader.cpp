@@ -0,0 +1,183 @@
+/*
+ * OctoMap - An Efficient Probabilistic 3D Mapping Framework Based on Octrees
+ * http://octomap.github.com/
+ *
+ * Copyright (c) 2009-2013, K.M. Wurm and A. Hornung, University of Freiburg
+ * All rights reserved.
+ * License: New BSD
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the University of Freiburg nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <octomap/ScanGraphReader.h>
+#if __cplusplus >= 201103L
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace octomap {
+
+#if __cplusplus >= 201103L
+  struct ScanGraphReader::Prefetcher {
+    Prefetcher() : index(0), stop(false) {}
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t index; ///< scans of the nodes before this index are loaded
+    bool stop;
+  };
+#else
+  struct ScanGraphReader::Prefetcher {};
+#endif
+
+  ScanGraphReader::ScanGraphReader()
+    : next_index(0), window_size(0), prefetcher(NULL)
+  {
+  }
+
+  ScanGraphReader::~ScanGraphReader() {
+    close();
+  }
+
+  bool ScanGraphReader::open(const std::string& filename, unsigned int window_size) {
+    close();
+    if (!graph.readBinary(filename, true))
+      return false;
+
+    // counted here, scans change while streaming
+    num_points.reserve(graph.size());
+    for (ScanGraph::const_iterator it = graph.begin(); it != graph.end(); ++it)
+      num_points.push_back((*it)->getNumPoints());
+
+#if __cplusplus >= 201103L
+    this->window_size = window_size;
+#else
+    this->window_size = 0;
+    if (window_size > 0)
+      OCTOMAP_WARNING("ScanGraphReader: prefetching requires C++11, scans are read on demand.\n");
+#endif
+    next_index = 0;
+    startPrefetch();
+    return true;
+  }
+
+  void ScanGraphReader::close() {
+    stopPrefetch();
+    graph.clear();
+    num_points.clear();
+    next_index = 0;
+  }
+
+  size_t ScanGraphReader::getNumPoints(unsigned int max_id) const {
+    size_t retval = 0;
+    for (size_t i = 0; i < num_points.size(); ++i) {
+      retval += num_points[i];
+      if ((max_id > 0) && ((*(graph.begin() + i))->id == max_id)) break;
+    }
+    return retval;
+  }
+
+  ScanNode* ScanGraphReader::next() {
+    // release the scan returned before, also its pages of the mapped file
+    if (next_index > 0) {
+      ScanNode* previous = *(graph.begin() + (next_index - 1));
+      previous->unloadScan();
+      graph.mapped_file.release(previous->scan_data, previous->scan_data_size);
+    }
+
+    if (next_index >= graph.size())
+      return NULL;
+
+    ScanNode* node = *(graph.begin() + next_index);
+#if __cplusplus >= 201103L
+    if (prefetcher) {
+      std::unique_lock<std::mutex> lock(prefetcher->mutex);
+      ++next_index;
+      prefetcher->cond.notify_all();
+      while (prefetcher->index < next_index)
+        prefetcher->cond.wait(lock);
+      return node;
+    }
+#endif
+    ++next_index;
+    node->getScan();
+    return node;
+  }
+
+  void ScanGraphReader::rewind() {
+    stopPrefetch();
+    for (ScanGraph::iterator it = graph.begin(); it != graph.end(); ++it)
+      (*it)->unloadScan();
+    next_index = 0;
+    startPrefetch();
+  }
+
+  void ScanGraphReader::startPrefetch() {
+#if __cplusplus >= 201103L
+    if (window_size == 0 || graph.size() == 0)
+      return;
+    prefetcher = new Prefetcher();
+    prefetcher->index = next_index;
+    prefetcher->thread = std::thread(&ScanGraphReader::prefetchLoop, this);
+#endif
+  }
+
+  void ScanGraphReader::stopPrefetch() {
+#if __cplusplus >= 201103L
+    if (!prefetcher)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(prefetcher->mutex);
+      prefetcher->stop = true;
+    }
+    prefetcher->cond.notify_all();
+    prefetcher->thread.join();
+#endif
+    delete prefetcher;
+    prefetcher = NULL;
+  }
+
+  void ScanGraphReader::prefetchLoop() {
+#if __cplusplus >= 201103L
+    std::unique_lock<std::mutex> lock(prefetcher->mutex);
+    while (!prefetcher->stop) {
+      // keep the scans of the current node and the following window loaded
+      if (prefetcher->index < graph.size() && prefetcher->index < next_index + window_size) {
+        ScanNode* node = *(graph.begin() + prefetcher->index);
+        lock.unlock();
+        node->getScan();
+        lock.lock();
+        ++prefetcher->index;
+        prefetcher->cond.notify_all();
+      }
+      else
+        prefetcher->cond.wait(lock);
+    }
+#endif
+  }
+
+} // namespace
@@ -227,8 +227,8 @@ int main(int argc, char **argv)
         cout.flush();
             
         // read voxel data
-        byte value;
-        byte count;
+        ::byte value;
+        ::byte count;
         int index = 0;
         int end_index = 0;
         unsigned nr_voxels = 0;
@@ -44,11 +44,12 @@ using namespace std;
 using namespace octomap;
 
 void printUsage(char* self){
-  std::cerr << "\nUSAGE: " << self << " input.(ot|bt|cot) [output.ot]\n\n";
+  std::cerr << "\nUSAGE: " << self << " [-bulk] input.(ot|bt|cbt|cot) [output.ot]\n\n";
 
   std::cerr << "This tool converts between OctoMap octree file formats, \n"
       "e.g. to convert old legacy files to the new .ot format or to convert \n"
-      "between .bt and .ot files. The default output format is .ot.\n\n";
+      "between .bt, .cbt (chunked .bt) and .ot files. The default output format is .ot.\n"
+      "With -bulk, .ot files are written with bulk node payloads (faster I/O).\n\n";
 
   exit(0);
 }
@@ -56,14 +57,21 @@ void printUsage(char* self){
 int main(int argc, char** argv) {
   string inputFilename = "";
   string outputFilename = "";
+  bool bulk = false;
 
-  if (argc < 2 || argc > 3 || (argc > 1 && strcmp(argv[1], "-h") == 0)){
+  int arg = 1;
+  if (argc > 1 && strcmp(argv[1], "-bulk") == 0){
+    bulk = true;
+    arg++;
+  }
+
+  if (argc - arg < 1 || argc - arg > 2 || strcmp(argv[arg], "-h") == 0){
     printUsage(argv[0]);
   }
 
-  inputFilename = std::string(argv[1]);
-  if (argc == 3)
-    outputFilename = std::string(argv[2]);
+  inputFilename = std::string(argv[arg]);
+  if (argc - arg == 2)
+    outputFilename = std::string(argv[arg+1]);
   else{
     outputFilename = inputFilename + ".ot";
   }
@@ -81,7 +89,16 @@ int main(int argc, char** argv) {
   AbstractOcTree* tree;
 
   // reading binary:
-  if (inputFilename.length() > 3 && (inputFilename.compare(inputFilename.length()-3, 3, ".bt") == 0)){
+  if (inputFilename.length() > 4 && (inputFilename.compare(inputFilename.length()-4, 4, ".cbt") == 0)){
+    OcTree* chunkedTree = new OcTree(0.1);
+
+    if (chunkedTree->readBinaryChunked(inputFilename) && chunkedTree->size() > 1)
+      tree = chunkedTree;
+    else {
+      OCTOMAP_ERROR_STR("Could not detect chunked binary OcTree format in file.");
+      exit(-1);
+    }
+  } else if (inputFilename.length() > 3 && (inputFilename.compare(inputFilename.length()-3, 3, ".bt") == 0)){
     OcTree* binaryTree = new OcTree(0.1);
 
     if (binaryTree->readBinary(file) && binaryTree->size() > 1)
@@ -118,7 +135,19 @@ int main(int argc, char** argv) {
   file.close();
 
 
-  if (outputFilename.length() > 3 && (outputFilename.compare(outputFilename.length()-3, 3, ".bt") == 0)){
+  if (outputFilename.length() > 4 && (outputFilename.compare(outputFilename.length()-4, 4, ".cbt") == 0)){
+    std::cerr << "Writing chunked binary file" << std::endl;
+    AbstractOccupancyOcTree* octree = dynamic_cast<AbstractOccupancyOcTree*>(tree);
+    if (octree){
+      if (!octree->writeBinaryChunked(outputFilename)){
+        std::cerr << "Error writing to " << outputFilename << std::endl;
+        exit(-2);
+      }
+    } else {
+      std::cerr << "Error: Writing to .cbt is not supported for this tree type: " << tree->getTreeType() << std::endl;
+      exit(-2);
+    }
+  } else if (outputFilename.length() > 3 && (outputFilename.compare(outputFilename.length()-3, 3, ".bt") == 0)){
     std::cerr << "Writing binary (BonsaiTree) file" << std::endl;
     AbstractOccupancyOcTree* octree = dynamic_cast<AbstractOccupancyOcTree*>(tree);
     if (octree){
@@ -130,6 +159,12 @@ int main(int argc, char** argv) {
       std::cerr << "Error: Writing to .bt is not supported for this tree type: " << tree->getTreeType() << std::endl;
       exit(-2);
     }
+  } else if (bulk){
+    std::cerr << "Writing general OcTree file with bulk node payloads" << std::endl;
+    if (!tree->writeBulk(outputFilename)){
+      std::cerr << "Error writing to " << outputFilename << std::endl;
+      exit(-2);
+    }
   } else{
     std::cerr << "Writing general OcTree file" << std::endl;
     if (!tree->write(outputFilename)){
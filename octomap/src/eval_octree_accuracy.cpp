@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include <octomap/octomap.h>
 #include <octomap/octomap_timing.h>
@@ -51,6 +52,8 @@ void printUsage(char* self){
             "  -res <resolution> (default: 0.1 m)\n"
             "  -m <maxrange> (optional) \n"
             "  -n <max scan no.> (optional) \n"
+            "  -stream <window> (read scans one at a time instead of loading the whole graph,\n"
+            "     decoding <window> scans ahead in the background; for graphs larger than memory) \n"
   "\n";
 
   exit(0);
@@ -68,6 +71,7 @@ int main(int argc, char** argv) {
 
   double maxrange = -1;
   int max_scan_no = -1;
+  int stream_window = -1;
   int skip_scan_eval = 5;
 
   int arg = 1;
@@ -80,37 +84,50 @@ int main(int argc, char** argv) {
       maxrange = atof(argv[++arg]);
     else if (! strcmp(argv[arg], "-n"))
       max_scan_no = atoi(argv[++arg]);
+    else if (! strcmp(argv[arg], "-stream") && argc-arg < 2)
+      printUsage(argv[0]);
+    else if (! strcmp(argv[arg], "-stream"))
+      stream_window = std::max(0, atoi(argv[++arg]));
     else {
       printUsage(argv[0]);
     }
   }
 
   cout << "\nReading Graph file\n===========================\n";
-  ScanGraph* graph = new ScanGraph();
-  if (!graph->readBinary(graphFilename))
-    exit(2);
-  
+  ScanGraph* graph = NULL;
+  ScanGraphReader* graphReader = NULL;
   size_t num_points_in_graph = 0;
-  if (max_scan_no > 0) {
-    num_points_in_graph = graph->getNumPoints(max_scan_no-1);
-    cout << "\n Data points in graph up to scan " << max_scan_no << ": " << num_points_in_graph << endl;
+  unsigned int max_id = (max_scan_no > 0) ? max_scan_no-1 : -1;
+  if (stream_window >= 0) {
+    graphReader = new ScanGraphReader();
+    if (!graphReader->open(graphFilename, stream_window))
+      exit(2);
+    num_points_in_graph = graphReader->getNumPoints(max_id);
   }
   else {
-    num_points_in_graph = graph->getNumPoints();
-    cout << "\n Data points in graph: " << num_points_in_graph << endl;
+    graph = new ScanGraph();
+    if (!graph->readBinary(graphFilename))
+      exit(2);
+    num_points_in_graph = graph->getNumPoints(max_id);
   }
 
+  if (max_scan_no > 0)
+    cout << "\n Data points in graph up to scan " << max_scan_no << ": " << num_points_in_graph << endl;
+  else
+    cout << "\n Data points in graph: " << num_points_in_graph << endl;
+
   cout << "\nCreating tree\n===========================\n";
   OcTree* tree = new OcTree(res);
 
-  size_t numScans = graph->size();
+  size_t numScans = graph ? graph->size() : graphReader->size();
   unsigned int currentScan = 1;
-  for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++) {
+  for (size_t i = 0; i < numScans; i++) {
+    ScanNode* node = graphReader ? graphReader->next() : *(graph->begin() + i);
 
     if (currentScan % skip_scan_eval != 0){
       if (max_scan_no > 0) cout << "("<<currentScan << "/" << max_scan_no << ") " << flush;
       else cout << "("<<currentScan << "/" << numScans << ") " << flush;
-      tree->insertPointCloud(**scan_it, maxrange);
+      tree->insertPointCloud(*node, maxrange);
     } else
       cout << "(SKIP) " << flush;
 
@@ -131,18 +148,21 @@ int main(int argc, char** argv) {
   size_t num_voxels_unknown = 0;
 
 
-  for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++) {
+  if (graphReader)
+    graphReader->rewind();
+  for (size_t i = 0; i < numScans; i++) {
+    ScanNode* node = graphReader ? graphReader->next() : *(graph->begin() + i);
 
     if (currentScan % skip_scan_eval == 0){
       if (max_scan_no > 0) cout << "("<<currentScan << "/" << max_scan_no << ") " << flush;
       else cout << "("<<currentScan << "/" << numScans << ") " << flush;
 
 
-      pose6d frame_origin = (*scan_it)->pose;
-      point3d sensor_origin = frame_origin.inv().transform((*scan_it)->pose.trans());
+      pose6d frame_origin = node->pose;
+      point3d sensor_origin = frame_origin.inv().transform(node->pose.trans());
 
       // transform pointcloud:
-      Pointcloud scan (*(*scan_it)->scan);
+      Pointcloud scan (*node->getScan());
       scan.transform(frame_origin);
       point3d origin = frame_origin.transform(sensor_origin);
 
@@ -190,6 +210,7 @@ int main(int argc, char** argv) {
 
 
   delete graph;
+  delete graphReader;
   delete tree;
   
   return 0;
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include <octomap/octomap.h>
 #include <octomap/octomap_timing.h>
@@ -56,6 +57,8 @@ void printUsage(char* self){
             "  -res <resolution> (optional, default: 0.1 m)\n"
             "  -m <maxrange> (optional) \n"
             "  -n <max scan no.> (optional) \n"
+            "  -stream <window> (read scans one at a time instead of loading the whole graph,\n"
+            "     decoding <window> scans ahead in the background; for graphs larger than memory) \n"
             "  -log (enable a detailed log file with statistics) \n"
             "  -g (nodes are already in global coordinates and no transformation is required) \n"
             "  -compressML (enable maximum-likelihood compression (lossy) after every scan)\n"
@@ -86,6 +89,15 @@ void calcThresholdedNodes(const OcTree* tree,
   }
 }
 
+void transformToGlobal(ScanNode* node){
+  pose6d frame_origin = node->pose;
+  point3d sensor_origin = frame_origin.inv().transform(node->pose.trans());
+
+  node->getScan()->transform(frame_origin);
+  point3d transformed_sensor_origin = frame_origin.transform(sensor_origin);
+  node->pose = pose6d(transformed_sensor_origin, octomath::Quaternion());
+}
+
 void outputStatistics(const OcTree* tree){
   unsigned int numThresholded, numOther;
   calcThresholdedNodes(tree, numThresholded, numOther);
@@ -110,6 +122,7 @@ int main(int argc, char** argv) {
   string treeFilename = "";
   double maxrange = -1;
   int max_scan_no = -1;
+  int stream_window = -1;
   bool detailedLog = false;
   bool simpleUpdate = false;
   bool discretize = false;
@@ -153,6 +166,10 @@ int main(int argc, char** argv) {
       maxrange = atof(argv[++arg]);
     else if (! strcmp(argv[arg], "-n"))
       max_scan_no = atoi(argv[++arg]);
+    else if (! strcmp(argv[arg], "-stream") && argc-arg < 2)
+      printUsage(argv[0]);
+    else if (! strcmp(argv[arg], "-stream"))
+      stream_window = std::max(0, atoi(argv[++arg]));
     else if (! strcmp(argv[arg], "-clamping") && (argc-arg < 3))
       printUsage(argv[0]);
     else if (! strcmp(argv[arg], "-clamping")){
@@ -194,32 +211,33 @@ int main(int argc, char** argv) {
   std::string treeFilenameMLOT = treeFilename + "_ml.ot";
 
   cout << "\nReading Graph file\n===========================\n";
-  ScanGraph* graph = new ScanGraph();
-  if (!graph->readBinary(graphFilename))
-    exit(2);
-
+  ScanGraph* graph = NULL;
+  ScanGraphReader* graphReader = NULL;
   size_t num_points_in_graph = 0;
-  if (max_scan_no > 0) {
-    num_points_in_graph = graph->getNumPoints(max_scan_no-1);
-    cout << "\n Data points in graph up to scan " << max_scan_no << ": " << num_points_in_graph << endl;
+  unsigned int max_id = (max_scan_no > 0) ? max_scan_no-1 : -1;
+  if (stream_window >= 0) {
+    graphReader = new ScanGraphReader();
+    if (!graphReader->open(graphFilename, stream_window))
+      exit(2);
+    num_points_in_graph = graphReader->getNumPoints(max_id);
   }
   else {
-    num_points_in_graph = graph->getNumPoints();
-    cout << "\n Data points in graph: " << num_points_in_graph << endl;
+    graph = new ScanGraph();
+    if (!graph->readBinary(graphFilename))
+      exit(2);
+    num_points_in_graph = graph->getNumPoints(max_id);
   }
 
-  // transform pointclouds first, so we can directly operate on them later
-  if (!dontTransformNodes) {
-    for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++) {
-
-      pose6d frame_origin = (*scan_it)->pose;
-      point3d sensor_origin = frame_origin.inv().transform((*scan_it)->pose.trans());
-
-      (*scan_it)->scan->transform(frame_origin);
-      point3d transformed_sensor_origin = frame_origin.transform(sensor_origin);
-      (*scan_it)->pose = pose6d(transformed_sensor_origin, octomath::Quaternion());
+  if (max_scan_no > 0)
+    cout << "\n Data points in graph up to scan " << max_scan_no << ": " << num_points_in_graph << endl;
+  else
+    cout << "\n Data points in graph: " << num_points_in_graph << endl;
 
-    }
+  // transform pointclouds first, so we can directly operate on them later
+  // (streamed scans are transformed as they are read)
+  if (!dontTransformNodes && graph) {
+    for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++)
+      transformToGlobal(*scan_it);
   }
 
 
@@ -243,16 +261,25 @@ int main(int argc, char** argv) {
 
 
   gettimeofday(&start, NULL);  // start timer
-  size_t numScans = graph->size();
+  size_t numScans = graph ? graph->size() : graphReader->size();
   size_t currentScan = 1;
-  for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++) {
+  for (size_t i = 0; i < numScans; i++) {
+    ScanNode* node;
+    if (graphReader) {
+      node = graphReader->next();
+      if (!dontTransformNodes)
+        transformToGlobal(node);
+    }
+    else
+      node = *(graph->begin() + i);
+
     if (max_scan_no > 0) cout << "("<<currentScan << "/" << max_scan_no << ") " << flush;
     else cout << "("<<currentScan << "/" << numScans << ") " << flush;
 
     if (simpleUpdate)
-      tree->insertPointCloudRays((*scan_it)->scan, (*scan_it)->pose.trans(), maxrange);
+      tree->insertPointCloudRays(*node->getScan(), node->pose.trans(), maxrange);
     else
-      tree->insertPointCloud((*scan_it)->scan, (*scan_it)->pose.trans(), maxrange, false, discretize);
+      tree->insertPointCloud(*node->getScan(), node->pose.trans(), maxrange, false, discretize);
 
     if (compression == 2){
       tree->toMaxLikelihood();
@@ -273,6 +300,7 @@ int main(int argc, char** argv) {
 
   // get rid of graph in mem before doing anything fancy with tree (=> memory)
   delete graph;
+  delete graphReader;
   if (logfile.is_open())
     logfile.close();
 
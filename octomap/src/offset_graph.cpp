@@ -54,7 +54,7 @@ int main(int argc, char** argv) {
   Pose6D trans(0,0,-offset,0,0,0);
 
   for (ScanGraph::iterator scan_it = graph->begin(); scan_it != graph->end(); scan_it++) {
-    (*scan_it)->scan->transform(trans);
+    (*scan_it)->getScan()->transform(trans);
     (*scan_it)->pose *= trans.inv();
   }
 
@@ -1,9 +1,19 @@
 #include <stdio.h>
 #include <string>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <octomap/OcTree.h>
 #include <octomap/ColorOcTree.h>
 #include <octomap/OcTreeStamped.h>
+#include <octomap/LabelOcTree.h>
+#include <octomap/FrozenOcTree.h>
 #include <octomap/math/Utils.h>
 #include "testing.h"
  
@@ -117,6 +127,316 @@ int main(int argc, char** argv) {
     EXPECT_FALSE(tree == *readTreeOt);
     
     delete readTreeOt;
+
+    std::cout <<"    Write to bulk .ot / read through AbstractOcTree\n";
+    EXPECT_TRUE(tree.writeBulk("test_io_bulk_file.ot"));
+    readTreeAbstract = AbstractOcTree::read("test_io_bulk_file.ot");
+    EXPECT_TRUE(readTreeAbstract);
+    readTreeOt = dynamic_cast<OcTree*>(readTreeAbstract);
+    EXPECT_TRUE(readTreeOt);
+    EXPECT_TRUE(tree == *readTreeOt);
+    delete readTreeOt;
+  }
+
+  // memory-mapped and in-memory binary data, frozen trees
+  {
+    std::cout << "Testing binary data from memory / FrozenOcTree...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    std::ifstream binaryFile(filename.c_str(), std::ios_base::binary);
+    OcTree streamTree(0.1);
+    EXPECT_TRUE(streamTree.readBinary(binaryFile));
+    EXPECT_TRUE(tree == streamTree);
+
+    std::stringstream binaryStream;
+    EXPECT_TRUE(tree.writeBinaryConst(binaryStream));
+    const std::string binaryData = binaryStream.str();
+    OcTree memoryTree(0.1);
+    EXPECT_TRUE(memoryTree.readBinary(binaryData.data(), binaryData.size()));
+    EXPECT_TRUE(tree == memoryTree);
+    OcTree truncatedTree(0.1);
+    EXPECT_FALSE(truncatedTree.readBinary(binaryData.data(), binaryData.size() - 10));
+
+    FrozenOcTree frozen;
+    EXPECT_TRUE(frozen.readBinary(filename));
+    EXPECT_FALSE(frozen.isMapped());
+    EXPECT_EQ(frozen.size(), tree.size());
+    EXPECT_EQ(frozen.getResolution(), tree.getResolution());
+    EXPECT_EQ(frozen.getTreeType(), "OcTree");
+    EXPECT_TRUE(frozen.write("test_io_file.frozen"));
+    FrozenOcTree mappedFrozen;
+    EXPECT_TRUE(mappedFrozen.read("test_io_file.frozen"));
+    EXPECT_TRUE(mappedFrozen.isMapped());
+    EXPECT_EQ(mappedFrozen.size(), tree.size());
+    EXPECT_EQ(mappedFrozen.getNumInnerNodes(), frozen.getNumInnerNodes());
+    FrozenOcTree truncatedFrozen;
+    EXPECT_FALSE(truncatedFrozen.readBinary(binaryData.data(), binaryData.size() - 10));
+
+    // the node array is in host byte order, files from other machines are rejected:
+    std::ifstream frozenFile("test_io_file.frozen", std::ios_base::binary);
+    std::string frozenData((std::istreambuf_iterator<char>(frozenFile)), std::istreambuf_iterator<char>());
+    const uint32_t mark = FrozenOcTree::byteOrderMark;
+    std::string markBytes(reinterpret_cast<const char*>(&mark), sizeof(mark));
+    const size_t markPos = frozenData.find(markBytes);
+    EXPECT_TRUE(markPos != std::string::npos);
+    frozenData.replace(markPos, markBytes.size(), std::string(markBytes.rbegin(), markBytes.rend()));
+    std::ofstream swappedFile("test_io_swapped.frozen", std::ios_base::binary);
+    swappedFile << frozenData;
+    swappedFile.close();
+    FrozenOcTree swappedFrozen;
+    EXPECT_FALSE(swappedFrozen.read("test_io_swapped.frozen"));
+
+    // all nodes, at their depth:
+    for (OcTree::tree_iterator it = tree.begin_tree(), end = tree.end_tree(); it != end; ++it){
+      if (it.getDepth() == 0)
+        continue;
+      const FrozenOcTree::State expected = tree.isNodeOccupied(*it) ? FrozenOcTree::OCCUPIED : FrozenOcTree::FREE;
+      EXPECT_EQ(frozen.search(it.getKey(), it.getDepth()), expected);
+      EXPECT_EQ(mappedFrozen.search(it.getKey(), it.getDepth()), expected);
+    }
+    // random points, including unknown space:
+    double minX, minY, minZ, maxX, maxY, maxZ;
+    tree.getMetricMin(minX, minY, minZ);
+    tree.getMetricMax(maxX, maxY, maxZ);
+    unsigned int numUnknown = 0;
+    for (unsigned int i = 0; i < 10000; ++i){
+      point3d p(float(minX + (maxX - minX) * rand() / RAND_MAX), float(minY + (maxY - minY) * rand() / RAND_MAX),
+                float(minZ + (maxZ - minZ) * rand() / RAND_MAX));
+      OcTreeNode* node = tree.search(p);
+      FrozenOcTree::State expected = FrozenOcTree::UNKNOWN;
+      if (node)
+        expected = tree.isNodeOccupied(node) ? FrozenOcTree::OCCUPIED : FrozenOcTree::FREE;
+      else
+        ++numUnknown;
+      EXPECT_EQ(frozen.search(p), expected);
+      EXPECT_EQ(mappedFrozen.search(p), expected);
+    }
+    EXPECT_TRUE(numUnknown > 0);
+
+    FrozenOcTree emptyFrozen;
+    EXPECT_TRUE(emptyFrozen.readBinary("empty.bt"));
+    EXPECT_EQ(emptyFrozen.size(), 0);
+    EXPECT_EQ(emptyFrozen.search(point3d(0.0f, 0.0f, 0.0f)), FrozenOcTree::UNKNOWN);
+    EXPECT_TRUE(emptyFrozen.write("test_io_empty.frozen"));
+    EXPECT_TRUE(emptyFrozen.read("test_io_empty.frozen"));
+    EXPECT_EQ(emptyFrozen.getNumInnerNodes(), 0);
+  }
+
+  // compressed binary files
+  {
+    std::cout << "Testing compressed binary files...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    std::stringstream binaryStream;
+    EXPECT_TRUE(tree.writeBinaryConst(binaryStream));
+    std::stringstream compressedStream;
+    EXPECT_TRUE(tree.writeBinaryCompressedConst(compressedStream));
+    const std::string compressedData = compressedStream.str();
+    EXPECT_TRUE(compressedData.size() < binaryStream.str().size() * 2 / 3);
+
+    OcTree streamTree(0.2);
+    EXPECT_TRUE(streamTree.readBinary(compressedStream));
+    EXPECT_EQ(streamTree.getResolution(), tree.getResolution());
+    EXPECT_TRUE(tree == streamTree);
+    OcTree memoryTree(0.1);
+    EXPECT_TRUE(memoryTree.readBinary(compressedData.data(), compressedData.size()));
+    EXPECT_TRUE(tree == memoryTree);
+    OcTree truncatedTree(0.1);
+    EXPECT_FALSE(truncatedTree.readBinary(compressedData.data(), compressedData.size() - 10));
+
+    std::string filenameCompressed = "test_io_compressed.bt";
+    EXPECT_TRUE(tree.writeBinaryCompressed(filenameCompressed));
+    OcTree fileTree(0.1);
+    EXPECT_TRUE(fileTree.readBinary(filenameCompressed));
+    EXPECT_TRUE(tree == fileTree);
+
+    // a few nodes only: all child codes are escaped
+    OcTree smallTree(0.1);
+    smallTree.updateNode(point3d(1.0f, 2.0f, 3.0f), true);
+    smallTree.updateNode(point3d(-1.0f, 2.0f, 3.0f), false);
+    smallTree.toMaxLikelihood();
+    std::stringstream smallStream;
+    EXPECT_TRUE(smallTree.writeBinaryCompressedConst(smallStream));
+    OcTree smallReadTree(0.1);
+    EXPECT_TRUE(smallReadTree.readBinary(smallStream));
+    EXPECT_TRUE(smallTree == smallReadTree);
+
+    OcTree emptyTree(0.1);
+    EXPECT_TRUE(emptyTree.writeBinaryCompressed("test_io_empty_compressed.bt"));
+    OcTree emptyReadTree(0.1);
+    EXPECT_TRUE(emptyReadTree.readBinary("test_io_empty_compressed.bt"));
+    EXPECT_EQ(emptyReadTree.size(), 0);
+  }
+
+#if __cplusplus >= 201103L
+  // background writes of a snapshot
+  {
+    std::cout << "Testing asynchronous binary writes...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    tree.updateNode(point3d(1.0f, 2.0f, 3.0f), true);
+    OcTree expected(tree);
+    expected.toMaxLikelihood();
+    expected.prune();
+
+    std::string filenameAsync = "test_io_async.bt";
+    std::future<bool> result = tree.writeBinaryAsync(filenameAsync);
+    // the tree can be changed while the snapshot is written:
+    for (unsigned int i = 0; i < 1000; ++i)
+      tree.updateNode(point3d(float(rand() % 100) * 0.1f, 0.0f, 0.0f), true);
+    EXPECT_TRUE(result.get());
+
+    OcTree readTree(0.1);
+    EXPECT_TRUE(readTree.readBinary(filenameAsync));
+    EXPECT_TRUE(readTree == expected);
+    EXPECT_FALSE(readTree == tree);
+
+    std::future<bool> failed = tree.writeBinaryAsync("/nonexistent_directory/test_io_async.bt");
+    EXPECT_FALSE(failed.get());
+  }
+#endif
+
+#if __cplusplus >= 201103L && !defined(_WIN32)
+  // files which cannot be memory-mapped are read as a stream
+  {
+    std::cout << "Testing binary reads from a pipe...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    std::stringstream binaryStream;
+    EXPECT_TRUE(tree.writeBinaryConst(binaryStream));
+    const std::string binaryData = binaryStream.str();
+
+    const std::string filenamePipe = "test_io_pipe.bt";
+    unlink(filenamePipe.c_str());
+    EXPECT_EQ(mkfifo(filenamePipe.c_str(), 0600), 0);
+    std::future<void> writer = std::async(std::launch::async, [&](){
+      std::ofstream pipe(filenamePipe.c_str(), std::ios_base::binary);
+      pipe.write(binaryData.data(), binaryData.size());
+    });
+    OcTree pipeTree(0.1);
+    EXPECT_TRUE(pipeTree.readBinary(filenamePipe));
+    writer.get();
+    unlink(filenamePipe.c_str());
+    EXPECT_TRUE(pipeTree == tree);
+  }
+#endif
+
+  // delta files of changed subtrees
+  {
+    std::cout << "Testing delta files...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    OcTree receiver(0.1);
+    EXPECT_TRUE(receiver.readBinary(filename));
+    tree.enableChangeDetection(true);
+    std::stringstream binaryStream;
+    EXPECT_TRUE(tree.writeBinaryConst(binaryStream));
+
+    double minX, minY, minZ, maxX, maxY, maxZ;
+    tree.getMetricMin(minX, minY, minZ);
+    tree.getMetricMax(maxX, maxY, maxZ);
+    for (unsigned int round = 0; round < 2; ++round){
+      // changes in a small part of the map and some new space:
+      for (unsigned int i = 0; i < 500; ++i){
+        point3d p(float(minX + (maxX - minX) / 10.0 * rand() / RAND_MAX), float(minY + (maxY - minY) * rand() / RAND_MAX),
+                  float(minZ + (maxZ - minZ) * rand() / RAND_MAX));
+        tree.updateNode(p, rand() % 2 == 0);
+        tree.updateNode(p + point3d(float(maxX - minX), 0.0f, 0.0f), true);
+      }
+      EXPECT_TRUE(tree.numChangesDetected() > 0);
+
+      std::stringstream deltaStream;
+      EXPECT_TRUE(tree.writeBinaryDelta(deltaStream));
+      tree.resetChangeDetection();
+      EXPECT_TRUE(deltaStream.str().size() < binaryStream.str().size() / 2);
+      EXPECT_TRUE(receiver.applyDelta(deltaStream));
+
+      OcTree expected(tree);
+      expected.toMaxLikelihood();
+      expected.prune();
+      receiver.prune();
+      EXPECT_EQ(receiver.size(), expected.size());
+      EXPECT_TRUE(receiver == expected);
+    }
+
+    // nothing changed, nothing to apply:
+    std::stringstream emptyDelta;
+    EXPECT_TRUE(tree.writeBinaryDelta(emptyDelta));
+    size_t receiverSize = receiver.size();
+    EXPECT_TRUE(receiver.applyDelta(emptyDelta));
+    EXPECT_EQ(receiver.size(), receiverSize);
+
+    // deltas only apply to the same tree type:
+    ColorOcTree colorTree(0.1);
+    std::stringstream typeDelta;
+    EXPECT_TRUE(tree.writeBinaryDelta(typeDelta));
+    EXPECT_FALSE(colorTree.applyDelta(typeDelta));
+  }
+
+  // chunked binary files, partial reading
+  {
+    std::cout << "Testing chunked binary files...\n";
+    OcTree tree(0.1);
+    EXPECT_TRUE(tree.readBinary(filename));
+    std::string filenameChunked = "test_io_file.cbt";
+    for (unsigned int chunkDepth = 0; chunkDepth <= 5; chunkDepth += 5){
+      EXPECT_TRUE(tree.writeBinaryChunkedConst(filenameChunked, chunkDepth));
+      OcTree chunkedTree(0.2);
+      EXPECT_TRUE(chunkedTree.readBinaryChunked(filenameChunked));
+      EXPECT_EQ(chunkedTree.getResolution(), tree.getResolution());
+      EXPECT_TRUE(tree == chunkedTree);
+    }
+    EXPECT_TRUE(tree.writeBinaryChunkedConst(filenameChunked));
+    OcTree binaryTree(0.1);
+    EXPECT_FALSE(binaryTree.readBinaryChunked(filename));
+
+    // only the chunks overlapping the box are read:
+    double minX, minY, minZ, maxX, maxY, maxZ;
+    tree.getMetricMin(minX, minY, minZ);
+    tree.getMetricMax(maxX, maxY, maxZ);
+    point3d regionMin((float) minX, (float) minY, (float) minZ);
+    point3d regionMax(float(minX + (maxX - minX) / 3.0), float(minY + (maxY - minY) / 3.0), float(maxZ));
+    OcTree regionTree(0.1);
+    EXPECT_TRUE(regionTree.readRegion(filenameChunked, regionMin, regionMax));
+    EXPECT_TRUE(regionTree.size() > 1);
+    EXPECT_TRUE(regionTree.size() < tree.size());
+    for (OcTree::leaf_bbx_iterator it = tree.begin_leafs_bbx(regionMin, regionMax), end = tree.end_leafs_bbx(); it != end; ++it){
+      OcTreeNode* regionNode = regionTree.search(it.getKey(), it.getDepth());
+      EXPECT_TRUE(regionNode);
+      EXPECT_EQ(regionTree.isNodeOccupied(regionNode), tree.isNodeOccupied(*it));
+      EXPECT_FALSE(regionTree.nodeHasChildren(regionNode));
+    }
+    OcTree outsideTree(0.1);
+    EXPECT_TRUE(outsideTree.readRegion(filenameChunked, point3d(1000.0f, 1000.0f, 1000.0f), point3d(1001.0f, 1001.0f, 1001.0f)));
+    EXPECT_EQ(outsideTree.size(), 0);
+
+    // truncated files are rejected:
+    std::ifstream chunkedFile(filenameChunked.c_str(), std::ios_base::binary);
+    std::stringstream chunkedData;
+    chunkedData << chunkedFile.rdbuf();
+    const std::string chunkedString = chunkedData.str();
+    std::ofstream truncatedFile("test_io_truncated.cbt", std::ios_base::binary);
+    truncatedFile.write(chunkedString.data(), chunkedString.size() - 10);
+    truncatedFile.close();
+    OcTree truncatedTree(0.1);
+    EXPECT_FALSE(truncatedTree.readBinaryChunked("test_io_truncated.cbt"));
+    // as are corrupted chunks, also for regions (without a check of the tree size):
+    std::string corruptedString = chunkedString;
+    std::fill(corruptedString.end() - 100, corruptedString.end(), char(0xFF));
+    std::ofstream corruptedFile("test_io_corrupted.cbt", std::ios_base::binary);
+    corruptedFile.write(corruptedString.data(), corruptedString.size());
+    corruptedFile.close();
+    OcTree corruptedTree(0.1);
+    EXPECT_FALSE(corruptedTree.readBinaryChunked("test_io_corrupted.cbt"));
+    OcTree corruptedRegion(0.1);
+    EXPECT_FALSE(corruptedRegion.readRegion("test_io_corrupted.cbt", point3d((float) minX, (float) minY, (float) minZ),
+                                            point3d((float) maxX, (float) maxY, (float) maxZ)));
+
+    OcTree emptyTree(0.1);
+    EXPECT_TRUE(emptyTree.writeBinaryChunkedConst("test_io_empty.cbt"));
+    OcTree emptyReadTree(0.2);
+    EXPECT_TRUE(emptyReadTree.readBinaryChunked("test_io_empty.cbt"));
+    EXPECT_EQ(emptyReadTree.size(), 0);
   }
 
   // Test for tree headers and IO factory registry (color)
@@ -145,6 +465,48 @@ int main(int argc, char** argv) {
     EXPECT_TRUE(colorNode);
     EXPECT_EQ(colorNode->getColor(), color_red);
     delete readColorTree;
+
+    // bulk payloads
+    EXPECT_TRUE(colorTree.writeBulk("test_io_color_bulk_file.ot"));
+    readTreeAbstract = AbstractOcTree::read("test_io_color_bulk_file.ot");
+    readColorTree = dynamic_cast<ColorOcTree*>(readTreeAbstract);
+    EXPECT_TRUE(readColorTree);
+    EXPECT_TRUE(colorTree == *readColorTree);
+    colorNode = readColorTree->search(0.1f, 0.1f, 0.1f);
+    EXPECT_TRUE(colorNode);
+    EXPECT_EQ(colorNode->getColor(), ColorOcTreeNode::Color(0, 0, 255));
+    delete readColorTree;
+
+    // truncated bulk data
+    std::ostringstream bulkStream;
+    EXPECT_TRUE(colorTree.writeBulk(bulkStream));
+    std::istringstream truncatedStream(bulkStream.str().substr(0, bulkStream.str().size() - 10));
+    readTreeAbstract = AbstractOcTree::read(truncatedStream);
+    EXPECT_TRUE(readTreeAbstract);
+    EXPECT_TRUE(truncatedStream.fail());
+    delete readTreeAbstract;
+  }
+
+  // bulk payloads (label)
+  {
+    std::cout << "Testing LabelOcTree bulk I/O...\n";
+    LabelOcTree labelTree(0.05);
+    for (int i = 0; i < 20; ++i){
+      point3d p(0.05f * (float) i, 0.1f, -0.05f * (float) i);
+      labelTree.updateNode(p, (i % 3) != 0);
+      labelTree.setNodeLabel(p.x(), p.y(), p.z(), i, 255 - i, 0.5 * i, 0.1 * i, i);
+    }
+    labelTree.updateInnerOccupancy();
+
+    EXPECT_TRUE(labelTree.writeBulk("test_io_label_bulk_file.ot"));
+    AbstractOcTree* readTreeAbstract = AbstractOcTree::read("test_io_label_bulk_file.ot");
+    LabelOcTree* readLabelTree = dynamic_cast<LabelOcTree*>(readTreeAbstract);
+    EXPECT_TRUE(readLabelTree);
+    EXPECT_TRUE(labelTree == *readLabelTree);
+    LabelOcTreeNode* labelNode = readLabelTree->search(point3d(0.05f * 7, 0.1f, -0.05f * 7));
+    EXPECT_TRUE(labelNode);
+    EXPECT_EQ(labelNode->getLabel().num_of_vis, 7);
+    delete readLabelTree;
   }
 
   // Test for tree headers and IO factory registry (stamped)
@@ -174,6 +536,20 @@ int main(int argc, char** argv) {
     //EXPECT_EQ(colorNode->getColor(), color_red);    
     
     delete readStampedTree;    
+
+    // bulk payloads, timestamps are not stored in .ot files
+    stampedTree.updateNode(point3d(0.0f, 0.0f, 0.0f), true);
+    stampedTree.updateNode(point3d(0.1f, 0.1f, 0.1f), false);
+    stampedTree.updateNode(point3d(-0.5f, 0.2f, 0.3f), true);
+    for (OcTreeStamped::tree_iterator it = stampedTree.begin_tree(), end = stampedTree.end_tree(); it != end; ++it)
+      it->setTimestamp(0);
+    EXPECT_TRUE(stampedTree.writeBulk("test_io_stamped_bulk_file.ot"));
+    readTreeAbstract = AbstractOcTree::read("test_io_stamped_bulk_file.ot");
+    readStampedTree = dynamic_cast<OcTreeStamped*>(readTreeAbstract);
+    EXPECT_TRUE(readStampedTree);
+    EXPECT_TRUE(stampedTree.size() > 1);
+    EXPECT_TRUE(stampedTree == *readStampedTree);
+    delete readStampedTree;
   }
 
 
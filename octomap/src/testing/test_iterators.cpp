@@ -209,6 +209,212 @@ void boundingBoxTest(OcTree* tree){
   }
 }
 
+/// brute force frustum check of a node's bounding box, mirrors leaf_frustum_iterator
+bool boxInFrustum(const point3d& center, double size, const pose6d& pose,
+                  double fov_h, double fov_v, double min_range, double max_range){
+  point3d normals[6] = {
+    point3d(1, 0, 0), point3d(-1, 0, 0),
+    point3d(float(sin(fov_h/2)), float(-cos(fov_h/2)), 0), point3d(float(sin(fov_h/2)), float(cos(fov_h/2)), 0),
+    point3d(float(sin(fov_v/2)), 0, float(-cos(fov_v/2))), point3d(float(sin(fov_v/2)), 0, float(cos(fov_v/2)))
+  };
+  for (unsigned i = 0; i < 6; ++i){
+    point3d n = pose.rot().rotate(normals[i]);
+    double d = -n.dot(pose.trans());
+    if (i == 0) d -= min_range;
+    if (i == 1) d += max_range;
+    double radius = 0.5 * size * (fabs(n.x()) + fabs(n.y()) + fabs(n.z()));
+    if (n.dot(center) + d < -radius)
+      return false;
+  }
+  return true;
+}
+
+void frustumTest(OcTree* tree){
+  double temp_x,temp_y,temp_z;
+  tree->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  tree->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  const double fov_h = DEG2RAD(70.0);
+  const double fov_v = DEG2RAD(50.0);
+  const double min_range = 0.2;
+  const double max_range = 5.0;
+  pose6d pose((mapMin + mapMax) * 0.5, octomath::Quaternion(0.0, DEG2RAD(10.0), DEG2RAD(30.0)));
+
+  typedef unordered_ns::unordered_map<OcTreeKey, double, OcTreeKey::KeyHash> KeyVolumeMap;
+  KeyVolumeMap frustumVoxels;
+  size_t count = 0;
+  for(OcTree::leaf_frustum_iterator it = tree->begin_leafs_frustum(pose, fov_h, fov_v, min_range, max_range),
+      end=tree->end_leafs_frustum(); it!= end; ++it)
+  {
+    count++;
+    EXPECT_FALSE(tree->nodeHasChildren(&(*it)));
+    EXPECT_TRUE(boxInFrustum(it.getCoordinate(), it.getSize(), pose, fov_h, fov_v, min_range, max_range));
+    frustumVoxels.insert(std::pair<OcTreeKey,double>(it.getKey(), it.getSize()));
+  }
+  EXPECT_EQ(frustumVoxels.size(), count);
+  std::cout << "Frustum traversed ("<< count << " leaf nodes)\n\n";
+
+  // compare with manual frustum check on all leafs:
+  size_t bruteForceCount = 0;
+  for(OcTree::leaf_iterator it = tree->begin(), end=tree->end(); it!= end; ++it) {
+    if (boxInFrustum(it.getCoordinate(), it.getSize(), pose, fov_h, fov_v, min_range, max_range)){
+      bruteForceCount++;
+      KeyVolumeMap::iterator fIt = frustumVoxels.find(it.getKey());
+      EXPECT_FALSE(fIt == frustumVoxels.end());
+      EXPECT_EQ(it.getSize(), fIt->second);
+    }
+  }
+  EXPECT_EQ(bruteForceCount, count);
+
+  // limited depth: leafs are reported at most at that depth
+  for(OcTree::leaf_frustum_iterator it = tree->begin_leafs_frustum(pose, fov_h, fov_v, min_range, max_range, 12),
+      end=tree->end_leafs_frustum(); it!= end; ++it)
+  {
+    EXPECT_TRUE(it.getDepth() <= 12);
+  }
+
+  // frustum looking away from the map
+  pose6d outside(mapMax + point3d(10, 10, 10), octomath::Quaternion());
+  EXPECT_TRUE(tree->begin_leafs_frustum(outside, fov_h, fov_v, min_range, max_range) == tree->end_leafs_frustum());
+}
+
+void unknownSpaceTest(OcTree* tree){
+  // unknown cubes and known leafs together cover the complete tree volume
+  // (counted in cells at the finest resolution):
+  const OcTreeKey minKey(0, 0, 0);
+  const OcTreeKey maxKey(65535, 65535, 65535);
+  unsigned long long volume = 0;
+  size_t count = 0;
+  for(OcTree::unknown_bbx_iterator it = tree->begin_unknown_bbx(minKey, maxKey), end=tree->end_unknown_bbx();
+      it!= end; ++it)
+  {
+    count++;
+    EXPECT_TRUE(&(*it) == NULL);
+    volume += 1ULL << (3 * (16 - it.getDepth()));
+    // unknown cube does not exist in the tree, but its parent does
+    EXPECT_FALSE(tree->search(it.getKey(), it.getDepth()));
+    if (it.getDepth() > 0)
+      EXPECT_TRUE(tree->search(it.getKey(), it.getDepth() - 1));
+  }
+  std::cout << "Unknown space traversed ("<< count << " cubes)\n\n";
+  for(OcTree::leaf_iterator it = tree->begin_leafs(), end=tree->end_leafs(); it!= end; ++it)
+    volume += 1ULL << (3 * (16 - it.getDepth()));
+  EXPECT_EQ(volume, 1ULL << 48);
+
+  // compare unknown cells at a fixed depth with searching each cell
+  const unsigned int depth = 14;
+  point3d bbxMin(-1, -1, -1);
+  point3d bbxMax(3, 2, 1);
+  point3d_list unknownCenters;
+  tree->getUnknownLeafCenters(unknownCenters, bbxMin, bbxMax, depth);
+  OcTreeKey bbxMinKey = tree->coordToKey(bbxMin, depth);
+  OcTreeKey bbxMaxKey = tree->coordToKey(bbxMax, depth);
+  const unsigned int step = 1 << (16 - depth);
+  size_t numUnknown = 0;
+  OcTreeKey k;
+  for (unsigned int x = bbxMinKey[0]; x <= bbxMaxKey[0]; x += step){
+    for (unsigned int y = bbxMinKey[1]; y <= bbxMaxKey[1]; y += step){
+      for (unsigned int z = bbxMinKey[2]; z <= bbxMaxKey[2]; z += step){
+        k = OcTreeKey(x, y, z);
+        if (!tree->search(k, depth))
+          numUnknown++;
+      }
+    }
+  }
+  EXPECT_EQ(unknownCenters.size(), numUnknown);
+  for (point3d_list::iterator it = unknownCenters.begin(); it != unknownCenters.end(); ++it){
+    EXPECT_FALSE(tree->search(*it, depth));
+  }
+  std::cout << "Unknown cells at depth " << depth << " in bbx: " << numUnknown << "\n\n";
+
+  // at the default (maximum) depth, a single known voxel in a 3x3x3 box:
+  OcTree singleTree(0.1);
+  const point3d center(0.05f, 0.05f, 0.05f);
+  singleTree.updateNode(center, true);
+  const point3d offset(0.1f, 0.1f, 0.1f);
+  point3d_list singleUnknown;
+  singleTree.getUnknownLeafCenters(singleUnknown, center - offset, center + offset);
+  EXPECT_EQ(singleUnknown.size(), 26);
+  for (point3d_list::iterator it = singleUnknown.begin(); it != singleUnknown.end(); ++it){
+    EXPECT_FALSE(singleTree.search(*it));
+  }
+}
+
+/// counts leafs and their volume for parallelForLeafs()
+struct LeafCounter {
+  size_t* count;
+  double* volume;
+  void operator()(const OcTree::leaf_bbx_iterator& it) const {
+    const double size = it.getSize();
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
+    (*count)++;
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
+    (*volume) += size*size*size;
+  }
+};
+
+void parallelTraversalTest(OcTree* tree){
+  OcTreeKey bbxMinKey, bbxMaxKey;
+  EXPECT_TRUE(tree->coordToKeyChecked(point3d(-1, -1, -1), bbxMinKey));
+  EXPECT_TRUE(tree->coordToKeyChecked(point3d(3, 2, 1), bbxMaxKey));
+
+  typedef unordered_ns::unordered_map<OcTreeKey, double, OcTreeKey::KeyHash> KeyVolumeMap;
+  for (unsigned int maxDepth = 14; maxDepth <= 16; maxDepth += 2){
+    KeyVolumeMap bbxVoxels;
+    double volume = 0.0;
+    for(OcTree::leaf_bbx_iterator it = tree->begin_leafs_bbx(bbxMinKey, bbxMaxKey, maxDepth), end=tree->end_leafs_bbx();
+        it!= end; ++it)
+    {
+      bbxVoxels.insert(std::pair<OcTreeKey,double>(it.getKey(), it.getSize()));
+      volume += it.getSize() * it.getSize() * it.getSize();
+    }
+
+    // ranges of disjoint subtrees cover the same leafs:
+    std::vector<OcTree::leaf_bbx_iterator> ranges;
+    tree->splitLeafsBBX(bbxMinKey, bbxMaxKey, ranges, 64, maxDepth);
+    EXPECT_TRUE(bbxVoxels.empty() || ranges.size() >= 64);
+    KeyVolumeMap rangeVoxels;
+    size_t count = 0;
+    const OcTree::leaf_bbx_iterator end = tree->end_leafs_bbx();
+    for (size_t i = 0; i < ranges.size(); ++i){
+      for (OcTree::leaf_bbx_iterator it = ranges[i]; it != end; ++it){
+        count++;
+        EXPECT_TRUE(it.getDepth() <= maxDepth);
+        EXPECT_TRUE(rangeVoxels.insert(std::pair<OcTreeKey,double>(it.getKey(), it.getSize())).second);
+      }
+    }
+    EXPECT_EQ(count, bbxVoxels.size());
+    for (KeyVolumeMap::iterator it = bbxVoxels.begin(); it != bbxVoxels.end(); ++it){
+      KeyVolumeMap::iterator rangeIt = rangeVoxels.find(it->first);
+      EXPECT_FALSE(rangeIt == rangeVoxels.end());
+      EXPECT_EQ(it->second, rangeIt->second);
+    }
+
+    size_t parallelCount = 0;
+    double parallelVolume = 0.0;
+    LeafCounter counter = {&parallelCount, &parallelVolume};
+    tree->parallelForLeafs(bbxMinKey, bbxMaxKey, counter, maxDepth);
+    EXPECT_EQ(parallelCount, bbxVoxels.size());
+    EXPECT_NEAR(parallelVolume, volume, 1e-6);
+  }
+
+  // whole tree:
+  size_t count = 0, parallelCount = 0;
+  double parallelVolume = 0.0;
+  for(OcTree::leaf_iterator it = tree->begin_leafs(), end=tree->end_leafs(); it!= end; ++it)
+    count++;
+  LeafCounter counter = {&parallelCount, &parallelVolume};
+  tree->parallelForLeafs(counter);
+  EXPECT_EQ(parallelCount, count);
+  std::cout << "Parallel traversal of " << parallelCount << " leafs\n\n";
+}
+
 int main(int argc, char** argv) {
 
 
@@ -407,6 +613,17 @@ int main(int argc, char** argv) {
 
     std::cout << "Time to traverse all leafs at max depth " <<(unsigned int)maxDepth <<" ("<<count<<" nodes): "<< time_it << " s\n\n";
 
+    // same with postfix increments, which copy the iterator:
+    gettimeofday(&start, NULL);  // start timers
+    count = 0;
+    for(OcTree::iterator it = tree->begin(maxDepth), end=tree->end();
+        it!= end; it++){
+      count++;
+    }
+    gettimeofday(&stop, NULL);  // stop timer
+    time_it = timediff(start, stop);
+    std::cout << "Time to traverse all leafs with iterator copies ("<<count<<" nodes): "<< time_it << " s\n\n";
+
 
 
 
@@ -416,6 +633,24 @@ int main(int argc, char** argv) {
     boundingBoxTest(tree);
     boundingBoxTest(&emptyTree);
 
+  /**
+   * frustum tests
+   */
+    frustumTest(tree);
+    frustumTest(&emptyTree);
+
+  /**
+   * unknown space tests
+   */
+    unknownSpaceTest(tree);
+    unknownSpaceTest(&emptyTree);
+
+  /**
+   * parallel traversal tests
+   */
+    parallelTraversalTest(tree);
+    parallelTraversalTest(&emptyTree);
+
 
   
   // test tree with one node:
@@ -1,5 +1,7 @@
 
 #include <stdio.h>
+#include <fstream>
+#include <string>
 #include <octomap/MapCollection.h>
 #include <octomap/math/Utils.h>
 #include "testing.h"
@@ -83,6 +85,84 @@ int main(int argc, char** argv) {
     printf("in fact, it has an occupancy probability of %0.2f\n", collection.getOccupancy(q));
   }
 
+  // lazily read collection (with bounding boxes) must answer the same
+  {
+    // bounding boxes are comments for readers which do not know them
+    std::ifstream collectionFile("writeout.txt");
+    std::string line;
+    size_t numBBX = 0;
+    while (std::getline(collectionFile, line)) {
+      EXPECT_FALSE(line.compare(0, 10, "MAPNODEBBX") == 0);
+      numBBX += (line.compare(0, 11, "#MAPNODEBBX") == 0) ? 1 : 0;
+    }
+    EXPECT_EQ(numBBX, collection.size());
+
+    MapCollection<MapNode<OcTree> > lazyCollection("writeout.txt");
+    EXPECT_EQ(lazyCollection.size(), collection.size());
+    for (MapCollection<MapNode<OcTree> >::const_iterator it = lazyCollection.begin(); it != lazyCollection.end(); ++it) {
+      EXPECT_TRUE((*it)->hasBBX());
+      EXPECT_FALSE((*it)->isMapLoaded());
+    }
+    for (std::vector<point3d>::iterator it = query.begin(); it != query.end(); ++it) {
+      EXPECT_EQ(lazyCollection.isOccupied(*it), collection.isOccupied(*it));
+      EXPECT_FLOAT_EQ(lazyCollection.getOccupancy(*it), collection.getOccupancy(*it));
+    }
+
+    // at most one map stays loaded with a tiny budget
+    lazyCollection.setMemoryBudget(1);
+    for (std::vector<point3d>::iterator it = query.begin(); it != query.end(); ++it) {
+      EXPECT_FLOAT_EQ(lazyCollection.getOccupancy(*it), collection.getOccupancy(*it));
+      size_t numLoaded = 0;
+      for (MapCollection<MapNode<OcTree> >::const_iterator n = lazyCollection.begin(); n != lazyCollection.end(); ++n)
+        numLoaded += (*n)->isMapLoaded() ? 1 : 0;
+      EXPECT_TRUE(numLoaded <= 1);
+    }
+
+    // a map handed out by getMap() is not unloaded, so its changes are kept
+    MapNode<OcTree>* modified = *lazyCollection.begin();
+    EXPECT_FALSE(modified->isMapInUse());
+    OcTree* modifiedMap = modified->getMap();
+    EXPECT_TRUE(modifiedMap);
+    EXPECT_TRUE(modified->isMapInUse());
+    point3d changed(0.05f, 0.05f, 0.05f);
+    modifiedMap->updateNode(changed, true);
+    for (std::vector<point3d>::iterator it = query.begin(); it != query.end(); ++it)
+      lazyCollection.getOccupancy(*it);
+    EXPECT_TRUE(modified->isMapLoaded());
+    EXPECT_TRUE(modified->getMap() == modifiedMap);
+    EXPECT_TRUE(modifiedMap->search(changed));
+  }
+
+  // a map file which cannot be read is unknown space
+  {
+    std::ofstream missingFile("missing.txt");
+    missingFile << "MAPNODEID missing\n"
+                << "MAPNODEFILENAME does_not_exist.bt\n"
+                << "MAPNODEPOSE 0 0 0 0 0 0\n"
+                << "#MAPNODEBBX -1 -1 -1 1 1 1\n";
+    missingFile.close();
+    MapCollection<MapNode<OcTree> > missingCollection("missing.txt");
+    EXPECT_EQ(missingCollection.size(), (size_t) 1);
+    point3d inside(0.f, 0.f, 0.f);
+    EXPECT_FALSE(missingCollection.queryNode(inside));
+    EXPECT_FALSE(missingCollection.isOccupied(inside));
+    EXPECT_FLOAT_EQ(missingCollection.getOccupancy(inside), 0.5);
+    point3d end;
+    EXPECT_FALSE(missingCollection.castRay(point3d(0.f, 0.f, -0.5f), point3d(0.f, 0.f, 1.f), end, true, 1.0));
+    EXPECT_FALSE((*missingCollection.begin())->isMapLoaded());
+
+    // only the commented bounding box is a tag
+    std::ofstream uncommentedFile("uncommented.txt");
+    uncommentedFile << "MAPNODEID missing\n"
+                    << "MAPNODEFILENAME does_not_exist.bt\n"
+                    << "MAPNODEPOSE 0 0 0 0 0 0\n"
+                    << "MAPNODEBBX -1 -1 -1 1 1 1\n";
+    uncommentedFile.close();
+    MapCollection<MapNode<OcTree> > uncommentedCollection("uncommented.txt");
+    EXPECT_EQ(uncommentedCollection.size(), (size_t) 1);
+    EXPECT_FALSE((*uncommentedCollection.begin())->hasBBX());
+  }
+
   point3d ray_origin (0,0,10);
   point3d ray_direction (0,0,-10);
   point3d ray_end (100,100,100);
@@ -257,6 +257,50 @@ int main(int argc, char** argv) {
       EXPECT_EQ(tree.size(), 0);      
     }
 
+    {
+      std::cout << "\nExpanding / pruning / max. likelihood of a random map\n===============================\n";
+      OcTree randomTree(0.05);
+      srand(42);
+      for (unsigned int i = 0; i < 20000; ++i){
+        point3d p(float(rand() % 100) * 0.02f, float(rand() % 100) * 0.02f, float(rand() % 50) * 0.02f);
+        randomTree.updateNode(p, (rand() % 3) == 0);
+      }
+      for (float x=-0.795f; x < 0.0f; x+=0.05f){
+        for (float y=-0.795f; y < 0.0f; y+=0.05f){
+          for (float z=-0.795f; z < 0.0f; z+=0.05f){
+            // different occupied values: only prunable in the max. likelihood map
+            randomTree.updateNode(point3d(x,y,z), true);
+            if (rand() % 2)
+              randomTree.updateNode(point3d(x,y,z), true);
+          }
+        }
+      }
+      EXPECT_EQ(randomTree.size(), randomTree.calcNumNodes());
+
+      OcTree expandedTree(randomTree);
+      expandedTree.expand();
+      EXPECT_EQ(expandedTree.size(), expandedTree.calcNumNodes());
+      EXPECT_TRUE(expandedTree.size() > randomTree.size());
+      expandedTree.prune();
+      EXPECT_EQ(expandedTree.size(), expandedTree.calcNumNodes());
+      EXPECT_TRUE(expandedTree == randomTree);
+
+      OcTree mlTree(randomTree);
+      mlTree.toMaxLikelihood();
+      EXPECT_EQ(mlTree.size(), randomTree.size());
+      for (OcTree::tree_iterator it = randomTree.begin_tree(), end = randomTree.end_tree(); it != end; ++it){
+        // (depth 0 in search() means full depth)
+        OcTreeNode* node = (it.getDepth() == 0) ? mlTree.getRoot() : mlTree.search(it.getKey(), it.getDepth());
+        EXPECT_TRUE(node);
+        const float expected = randomTree.isNodeOccupied(*it) ? mlTree.getClampingThresMaxLog()
+                                                               : mlTree.getClampingThresMinLog();
+        EXPECT_EQ(node->getLogOdds(), expected);
+      }
+      mlTree.prune();
+      EXPECT_EQ(mlTree.size(), mlTree.calcNumNodes());
+      EXPECT_TRUE(mlTree.size() < randomTree.size());
+    }
+
     tree.write("pruning_test_out.ot");
     std::cerr << "Test successful.\n";
     return 0;
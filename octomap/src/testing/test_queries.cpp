@@ -0,0 +1,1108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+
+#include <octomap/octomap_timing.h>
+#include <octomap/octomap.h>
+#include <octomap/MCTables.h>
+#include <octomap/AggregateOcTree.h>
+#include <octomap/OcTreeStamped.h>
+#include <octomap/math/Utils.h>
+#include "testing.h"
+
+using namespace std;
+using namespace octomap;
+
+void printUsage(char* self){
+  std::cerr << "\nUSAGE: " << self << " inputfile.bt\n\n";
+  exit(1);
+}
+
+double timediff(const timeval& start, const timeval& stop){
+  return (stop.tv_sec - start.tv_sec) + 1.0e-6 *(stop.tv_usec - start.tv_usec);
+}
+
+/// brute force distance from a point to a node's volume
+double distanceToBox(const point3d& p, const point3d& center, double size){
+  double sqr_dist = 0.0;
+  for (unsigned i = 0; i < 3; ++i){
+    double d = fabs(p(i) - center(i)) - 0.5*size;
+    if (d > 0.0)
+      sqr_dist += d*d;
+  }
+  return sqrt(sqr_dist);
+}
+
+void nearestNeighborTest(OcTree* tree){
+  double temp_x,temp_y,temp_z;
+  tree->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  tree->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  const unsigned int k = 10;
+  const double radius = 0.5;
+  timeval start, stop;
+  double time_knn = 0.0, time_radius = 0.0, time_brute = 0.0;
+
+  srand(42);
+  for (unsigned int q = 0; q < 20; ++q){
+    point3d query;
+    for (unsigned int i = 0; i < 3; ++i)
+      query(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+
+    std::vector<OcTree::OccupiedNeighbor> neighbors;
+    gettimeofday(&start, NULL);
+    tree->getKNearestOccupied(query, k, neighbors);
+    gettimeofday(&stop, NULL);
+    time_knn += timediff(start, stop);
+
+    std::vector<OcTree::OccupiedNeighbor> inRadius;
+    gettimeofday(&start, NULL);
+    tree->getOccupiedInRadius(query, radius, inRadius);
+    gettimeofday(&stop, NULL);
+    time_radius += timediff(start, stop);
+
+    // brute force over all occupied leafs:
+    gettimeofday(&start, NULL);
+    std::vector<double> distances;
+    for(OcTree::leaf_iterator it = tree->begin_leafs(), end=tree->end_leafs(); it!= end; ++it){
+      if (tree->isNodeOccupied(*it))
+        distances.push_back(distanceToBox(query, it.getCoordinate(), it.getSize()));
+    }
+    std::sort(distances.begin(), distances.end());
+    gettimeofday(&stop, NULL);
+    time_brute += timediff(start, stop);
+
+    EXPECT_EQ(neighbors.size(), std::min(size_t(k), distances.size()));
+    for (size_t i = 0; i < neighbors.size(); ++i){
+      EXPECT_NEAR(neighbors[i].distance, distances[i], 1e-4);
+      EXPECT_TRUE(tree->isNodeOccupied(neighbors[i].node));
+      EXPECT_FALSE(tree->nodeHasChildren(neighbors[i].node));
+      if (i > 0)
+        EXPECT_TRUE(neighbors[i-1].distance <= neighbors[i].distance);
+    }
+
+    size_t bruteInRadius = 0;
+    for (size_t i = 0; i < distances.size() && distances[i] <= radius; ++i)
+      bruteInRadius++;
+    EXPECT_EQ(inRadius.size(), bruteInRadius);
+    for (size_t i = 0; i < inRadius.size(); ++i){
+      EXPECT_TRUE(inRadius[i].distance <= radius);
+      EXPECT_NEAR(inRadius[i].distance, distanceToBox(query, inRadius[i].center, inRadius[i].size), 1e-4);
+    }
+
+    // maximum distance limits the result:
+    std::vector<OcTree::OccupiedNeighbor> limited;
+    tree->getKNearestOccupied(query, k, limited, radius);
+    EXPECT_EQ(limited.size(), std::min(size_t(k), bruteInRadius));
+  }
+
+  std::cout << "Nearest neighbor queries: kNN " << time_knn << " s, radius " << time_radius
+            << " s, brute force " << time_brute << " s\n\n";
+
+  // empty tree:
+  OcTree emptyTree(0.1);
+  std::vector<OcTree::OccupiedNeighbor> neighbors;
+  EXPECT_EQ(emptyTree.getKNearestOccupied(point3d(0, 0, 0), k, neighbors), 0);
+  EXPECT_EQ(emptyTree.getOccupiedInRadius(point3d(0, 0, 0), radius, neighbors), 0);
+}
+
+/// brute force marching cubes triangle count over all cubes with a minimum corner in [min, max]
+size_t countSurfaceTriangles(const OcTree& tree, const OcTreeKey& min, const OcTreeKey& max, bool unknownStatus){
+  static const int x_offset[8] = {1, 1, 0, 0, 1, 1, 0, 0};
+  static const int y_offset[8] = {1, 0, 0, 1, 1, 0, 0, 1};
+  static const int z_offset[8] = {0, 0, 0, 0, 1, 1, 1, 1};
+  size_t numTriangles = 0;
+  OcTreeKey cube, corner;
+  for (unsigned x = min[0]; x <= max[0]; ++x){
+    for (unsigned y = min[1]; y <= max[1]; ++y){
+      for (unsigned z = min[2]; z <= max[2]; ++z){
+        int cubeIndex = 0;
+        for (unsigned v = 0; v < 8; ++v){
+          corner = OcTreeKey(x + x_offset[v], y + y_offset[v], z + z_offset[v]);
+          OcTreeNode* node = tree.search(corner);
+          if (node ? tree.isNodeOccupied(node) : unknownStatus)
+            cubeIndex |= (1 << v);
+        }
+        for (int i = 0; triTable[cubeIndex][i] != -1; i += 3)
+          numTriangles++;
+      }
+    }
+  }
+  return numTriangles;
+}
+
+void surfaceMeshTest(OcTree* map){
+  // occupied ball inside of a free ball:
+  OcTree tree(0.1);
+  for (float x = -1.0f; x <= 1.0f; x += 0.1f){
+    for (float y = -1.0f; y <= 1.0f; y += 0.1f){
+      for (float z = -1.0f; z <= 1.0f; z += 0.1f){
+        point3d p(x, y, z);
+        if (p.norm() < 0.5)
+          tree.updateNode(p, true);
+        else if (p.norm() < 1.0)
+          tree.updateNode(p, false);
+      }
+    }
+  }
+  OcTreeKey minKey = tree.coordToKey(-1.3, -1.3, -1.3);
+  OcTreeKey maxKey = tree.coordToKey(1.3, 1.3, 1.3);
+
+  for (unsigned int unknownStatus = 0; unknownStatus < 2; ++unknownStatus){
+    std::vector<point3d> vertices, normals;
+    std::vector<unsigned int> triangles;
+    tree.extractSurfaceMesh(vertices, normals, triangles, unknownStatus);
+    EXPECT_EQ(triangles.size() % 3, 0);
+    EXPECT_EQ(vertices.size(), normals.size());
+    EXPECT_EQ(triangles.size() / 3, countSurfaceTriangles(tree, minKey, maxKey, unknownStatus));
+    std::cout << "Surface mesh (unknownStatus=" << unknownStatus << "): "
+              << vertices.size() << " vertices, " << triangles.size() / 3 << " triangles\n";
+
+    // vertices are shared:
+    EXPECT_TRUE(vertices.size() < triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+      EXPECT_TRUE(triangles[i] < vertices.size());
+
+    if (!unknownStatus){
+      // only the ball surface, normals point away from the occupied ball:
+      for (size_t i = 0; i < triangles.size(); i += 3){
+        const point3d& p1 = vertices[triangles[i]];
+        point3d faceNormal = (vertices[triangles[i+1]] - p1).cross(vertices[triangles[i+2]] - p1);
+        EXPECT_TRUE(faceNormal.dot(p1) > 0.0);
+        EXPECT_TRUE(p1.norm() < 0.7);
+      }
+      for (size_t i = 0; i < vertices.size(); ++i)
+        EXPECT_TRUE(normals[i].dot(vertices[i]) > 0.0);
+    }
+
+    // bounding box with the upper half only:
+    std::vector<point3d> bbxVertices, bbxNormals;
+    std::vector<unsigned int> bbxTriangles;
+    EXPECT_TRUE(tree.extractSurfaceMesh(point3d(-1.3f, -1.3f, 0.0f), point3d(1.3f, 1.3f, 1.3f),
+                                        bbxVertices, bbxNormals, bbxTriangles, unknownStatus));
+    OcTreeKey bbxMinKey = tree.coordToKey(-1.3, -1.3, 0.0);
+    EXPECT_EQ(bbxTriangles.size() / 3, countSurfaceTriangles(tree, bbxMinKey, maxKey, unknownStatus));
+  }
+
+  // large pruned leafs, free around an occupied box:
+  OcTree boxTree(0.1);
+  const key_type c = boxTree.coordToKey(0.0);
+  boxTree.setAABB(OcTreeKey(c - 16, c - 16, c - 16), OcTreeKey(c + 15, c + 15, c + 15), boxTree.getClampingThresMinLog());
+  boxTree.setAABB(OcTreeKey(c + 3, c + 3, c + 3), OcTreeKey(c + 9, c + 5, c + 5), boxTree.getClampingThresMaxLog());
+  EXPECT_TRUE(boxTree.getNumLeafNodes() < 1000);
+  minKey = OcTreeKey(c - 18, c - 18, c - 18);
+  maxKey = OcTreeKey(c + 17, c + 17, c + 17);
+  OcTreeKey bbxMinKey(c - 7, c - 18, c - 18);
+  OcTreeKey bbxMaxKey(c + 17, c + 17, c + 4);
+  for (unsigned int unknownStatus = 0; unknownStatus < 2; ++unknownStatus){
+    std::vector<point3d> vertices, normals;
+    std::vector<unsigned int> triangles;
+    boxTree.extractSurfaceMesh(vertices, normals, triangles, unknownStatus);
+    EXPECT_EQ(triangles.size() / 3, countSurfaceTriangles(boxTree, minKey, maxKey, unknownStatus));
+    boxTree.extractSurfaceMesh(bbxMinKey, bbxMaxKey, vertices, normals, triangles, unknownStatus);
+    EXPECT_EQ(triangles.size() / 3, countSurfaceTriangles(boxTree, bbxMinKey, bbxMaxKey, unknownStatus));
+  }
+
+  // timing on the full map:
+  timeval start, stop;
+  std::vector<point3d> vertices, normals;
+  std::vector<unsigned int> triangles;
+  gettimeofday(&start, NULL);
+  map->extractSurfaceMesh(vertices, normals, triangles, false);
+  gettimeofday(&stop, NULL);
+  std::cout << "Surface mesh of map: " << vertices.size() << " vertices, " << triangles.size() / 3
+            << " triangles in " << timediff(start, stop) << " s\n\n";
+}
+
+/// brute force region predicates over all finest-resolution voxels between min and max
+void bruteForceBBX(const OcTree& tree, const OcTreeKey& min, const OcTreeKey& max, bool& occupied, bool& unknown){
+  occupied = unknown = false;
+  for (unsigned x = min[0]; x <= max[0]; ++x){
+    for (unsigned y = min[1]; y <= max[1]; ++y){
+      for (unsigned z = min[2]; z <= max[2]; ++z){
+        OcTreeNode* node = tree.search(OcTreeKey(x, y, z));
+        if (!node)
+          unknown = true;
+        else if (tree.isNodeOccupied(node))
+          occupied = true;
+      }
+    }
+  }
+}
+
+void regionPredicateTest(OcTree* map){
+  double temp_x,temp_y,temp_z;
+  map->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  map->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  // summary flags need to survive copies and I/O:
+  OcTree copy(*map);
+  std::stringstream binaryStream, fullStream;
+  map->writeBinaryConst(binaryStream);
+  OcTree binaryTree(0.1);
+  binaryTree.readBinary(binaryStream);
+  map->write(fullStream);
+  OcTree* fullTree = dynamic_cast<OcTree*>(AbstractOcTree::read(fullStream));
+  EXPECT_TRUE(fullTree);
+
+  timeval start, stop;
+  double time_predicates = 0.0, time_brute = 0.0;
+  unsigned int numFree = 0, numOccupied = 0, numUnknown = 0;
+  srand(42);
+  for (unsigned int q = 0; q < 100; ++q){
+    point3d center, halfSize;
+    for (unsigned int i = 0; i < 3; ++i){
+      center(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+      halfSize(i) = 0.05f + float(rand()) / float(RAND_MAX) * 0.7f;
+    }
+    point3d min = center - halfSize;
+    point3d max = center + halfSize;
+    OcTreeKey minKey = map->coordToKey(min);
+    OcTreeKey maxKey = map->coordToKey(max);
+
+    gettimeofday(&start, NULL);
+    bool occupied = map->hasOccupiedInBBX(min, max);
+    bool unknown = map->hasUnknownInBBX(min, max);
+    bool free = map->isBBXFree(min, max);
+    gettimeofday(&stop, NULL);
+    time_predicates += timediff(start, stop);
+
+    bool bruteOccupied, bruteUnknown;
+    gettimeofday(&start, NULL);
+    bruteForceBBX(*map, minKey, maxKey, bruteOccupied, bruteUnknown);
+    gettimeofday(&stop, NULL);
+    time_brute += timediff(start, stop);
+
+    EXPECT_EQ(occupied, bruteOccupied);
+    EXPECT_EQ(unknown, bruteUnknown);
+    EXPECT_EQ(free, (!bruteOccupied && !bruteUnknown));
+    numFree += free;
+    numOccupied += occupied;
+    numUnknown += unknown;
+
+    EXPECT_EQ(copy.hasOccupiedInBBX(minKey, maxKey), occupied);
+    EXPECT_EQ(copy.hasUnknownInBBX(minKey, maxKey), unknown);
+    EXPECT_EQ(binaryTree.hasOccupiedInBBX(minKey, maxKey), occupied);
+    EXPECT_EQ(binaryTree.hasUnknownInBBX(minKey, maxKey), unknown);
+    EXPECT_EQ(fullTree->hasOccupiedInBBX(minKey, maxKey), occupied);
+    EXPECT_EQ(fullTree->hasUnknownInBBX(minKey, maxKey), unknown);
+  }
+  delete fullTree;
+  std::cout << "Region predicates (" << numFree << " free, " << numOccupied << " occupied, "
+            << numUnknown << " unknown): " << time_predicates << " s, brute force " << time_brute << " s\n";
+
+  // lazy updates, summary restored by updateInnerOccupancy():
+  OcTree tree(0.1);
+  for (float x = 0.05f; x < 1.0f; x += 0.1f){
+    for (float y = 0.05f; y < 1.0f; y += 0.1f){
+      for (float z = 0.05f; z < 1.0f; z += 0.1f)
+        tree.updateNode(point3d(x, y, z), false, true);
+    }
+  }
+  tree.updateInnerOccupancy();
+  EXPECT_TRUE(tree.isBBXFree(point3d(0.01f, 0.01f, 0.01f), point3d(0.99f, 0.99f, 0.99f)));
+  EXPECT_FALSE(tree.hasOccupiedInBBX(point3d(0.01f, 0.01f, 0.01f), point3d(0.99f, 0.99f, 0.99f)));
+  EXPECT_TRUE(tree.hasUnknownInBBX(point3d(0.01f, 0.01f, 0.01f), point3d(1.09f, 0.99f, 0.99f)));
+  tree.updateNode(point3d(0.55f, 0.55f, 0.55f), true);
+  EXPECT_TRUE(tree.hasOccupiedInBBX(point3d(0.51f, 0.51f, 0.51f), point3d(0.59f, 0.59f, 0.59f)));
+  EXPECT_FALSE(tree.isBBXFree(point3d(0.01f, 0.01f, 0.01f), point3d(0.99f, 0.99f, 0.99f)));
+  EXPECT_TRUE(tree.isBBXFree(point3d(0.01f, 0.01f, 0.01f), point3d(0.49f, 0.99f, 0.99f)));
+  tree.deleteNode(point3d(0.15f, 0.15f, 0.15f));
+  EXPECT_TRUE(tree.hasUnknownInBBX(point3d(0.01f, 0.01f, 0.01f), point3d(0.49f, 0.99f, 0.99f)));
+
+  // empty tree and boxes outside of the map are unknown:
+  OcTree emptyTree(0.1);
+  EXPECT_TRUE(emptyTree.hasUnknownInBBX(point3d(-1, -1, -1), point3d(1, 1, 1)));
+  EXPECT_FALSE(emptyTree.hasOccupiedInBBX(point3d(-1, -1, -1), point3d(1, 1, 1)));
+  EXPECT_FALSE(emptyTree.isBBXFree(point3d(-1, -1, -1), point3d(1, 1, 1)));
+  EXPECT_TRUE(tree.hasUnknownInBBX(point3d(0.01f, 0.01f, 0.01f), point3d(1e5f, 0.99f, 0.99f)));
+  EXPECT_FALSE(tree.isBBXFree(point3d(0.01f, 0.01f, 0.01f), point3d(1e5f, 0.99f, 0.99f)));
+  std::cout << "\n";
+}
+
+void collisionTest(OcTree* tree){
+  double temp_x,temp_y,temp_z;
+  tree->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  tree->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  timeval start, stop;
+  double time_sphere = 0.0, time_brute = 0.0;
+  unsigned int numCollisions = 0;
+  srand(42);
+  for (unsigned int q = 0; q < 30; ++q){
+    point3d center, other;
+    for (unsigned int i = 0; i < 3; ++i){
+      center(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+      other(i) = center(i) + (float(rand()) / float(RAND_MAX) - 0.5f) * 4.0f;
+    }
+    double radius = 0.05 + double(rand()) / double(RAND_MAX) * 0.5;
+
+    // sphere against all occupied leafs:
+    gettimeofday(&start, NULL);
+    bool collision = tree->collidesWithSphere(center, radius);
+    gettimeofday(&stop, NULL);
+    time_sphere += timediff(start, stop);
+
+    gettimeofday(&start, NULL);
+    bool bruteCollision = false;
+    for(OcTree::leaf_iterator it = tree->begin_leafs(), end=tree->end_leafs(); it!= end && !bruteCollision; ++it){
+      if (tree->isNodeOccupied(*it) && distanceToBox(center, it.getCoordinate(), it.getSize()) <= radius)
+        bruteCollision = true;
+    }
+    gettimeofday(&stop, NULL);
+    time_brute += timediff(start, stop);
+    EXPECT_EQ(collision, bruteCollision);
+    numCollisions += collision;
+    if (collision)
+      EXPECT_TRUE(tree->collidesWithSphere(center, radius, true));
+
+    // capsule between spheres along the segment (inner) and spheres covering it (outer):
+    const unsigned int numSamples = 100;
+    const double spacing = (other - center).norm() / (numSamples - 1);
+    bool innerCollision = false, outerCollision = false;
+    for (unsigned int i = 0; i < numSamples; ++i){
+      point3d p = center + (other - center) * (float(i) / float(numSamples - 1));
+      innerCollision |= tree->collidesWithSphere(p, radius);
+      outerCollision |= tree->collidesWithSphere(p, radius + 0.5*spacing);
+    }
+    bool capsuleCollision = tree->collidesWithCapsule(center, other, radius);
+    if (innerCollision)
+      EXPECT_TRUE(capsuleCollision);
+    if (capsuleCollision)
+      EXPECT_TRUE(outerCollision);
+
+    // axis-aligned box as bounding box, rotated box between inscribed and circumscribed sphere:
+    point3d halfExtents(float(radius), float(2.0*radius), float(0.5*radius));
+    EXPECT_EQ(tree->collidesWithOBB(center, octomath::Quaternion(), halfExtents),
+              tree->hasOccupiedInBBX(center - halfExtents, center + halfExtents));
+    octomath::Quaternion rotation(0.3, -0.5, 1.2);
+    bool obbCollision = tree->collidesWithOBB(center, rotation, halfExtents);
+    if (tree->collidesWithSphere(center, 0.5*radius))
+      EXPECT_TRUE(obbCollision);
+    if (obbCollision)
+      EXPECT_TRUE(tree->collidesWithSphere(center, halfExtents.norm()));
+  }
+  std::cout << "Sphere collisions (" << numCollisions << " of 30): " << time_sphere
+            << " s, brute force " << time_brute << " s\n";
+
+  // trajectory:
+  std::vector<point3d> waypoints;
+  for (float x = mapMin(0); x < mapMax(0); x += 0.5f)
+    waypoints.push_back(point3d(x, 0.5f*(mapMin(1) + mapMax(1)), 0.5f*(mapMin(2) + mapMax(2))));
+  int firstCollision = -1;
+  for (size_t i = 0; i + 1 < waypoints.size() && firstCollision < 0; ++i){
+    if (tree->collidesWithCapsule(waypoints[i], waypoints[i+1], 0.2))
+      firstCollision = int(i);
+  }
+  EXPECT_EQ(tree->checkTrajectory(waypoints, 0.2), firstCollision);
+
+  // unknown space:
+  OcTree emptyTree(0.1);
+  EXPECT_FALSE(emptyTree.collidesWithSphere(point3d(0, 0, 0), 1.0));
+  EXPECT_TRUE(emptyTree.collidesWithSphere(point3d(0, 0, 0), 1.0, true));
+  emptyTree.updateNode(point3d(0.05f, 0.05f, 0.05f), false);
+  EXPECT_FALSE(emptyTree.collidesWithSphere(point3d(0.05f, 0.05f, 0.05f), 0.01, true));
+  EXPECT_TRUE(emptyTree.collidesWithSphere(point3d(0.05f, 0.05f, 0.05f), 0.1, true));
+  EXPECT_EQ(emptyTree.checkTrajectory(std::vector<point3d>(1, point3d(0.05f, 0.05f, 0.05f)), 0.01, true), -1);
+  std::cout << "\n";
+}
+
+void lineOfSightTest(OcTree* tree){
+  double temp_x,temp_y,temp_z;
+  tree->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  tree->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  std::vector<std::pair<point3d, point3d> > pairs;
+  srand(42);
+  for (unsigned int q = 0; q < 500; ++q){
+    point3d a, b;
+    for (unsigned int i = 0; i < 3; ++i){
+      a(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+      b(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+    }
+    pairs.push_back(std::make_pair(a, b));
+  }
+
+  timeval start, stop;
+  KeyRay ray;
+  for (unsigned int unknownBlocked = 0; unknownBlocked < 2; ++unknownBlocked){
+    double time_los = 0.0, time_ray = 0.0;
+    std::vector<bool> bruteVisible(pairs.size());
+    unsigned int numVisible = 0;
+    for (size_t q = 0; q < pairs.size(); ++q){
+      gettimeofday(&start, NULL);
+      bool visible = tree->isLineOfSight(pairs[q].first, pairs[q].second, unknownBlocked);
+      gettimeofday(&stop, NULL);
+      time_los += timediff(start, stop);
+
+      // all voxels of the ray except the origin:
+      gettimeofday(&start, NULL);
+      EXPECT_TRUE(tree->computeRayKeys(pairs[q].first, pairs[q].second, ray));
+      bruteVisible[q] = true;
+      for (KeyRay::const_iterator it = ray.begin(); it != ray.end(); ++it){
+        if (it == ray.begin())
+          continue;
+        OcTreeNode* node = tree->search(*it);
+        if (node ? tree->isNodeOccupied(node) : unknownBlocked){
+          bruteVisible[q] = false;
+          break;
+        }
+      }
+      gettimeofday(&stop, NULL);
+      time_ray += timediff(start, stop);
+
+      EXPECT_EQ(visible, bruteVisible[q]);
+      numVisible += visible;
+    }
+
+    std::vector<bool> batchVisible;
+    gettimeofday(&start, NULL);
+    tree->isLineOfSight(pairs, batchVisible, unknownBlocked);
+    gettimeofday(&stop, NULL);
+    EXPECT_TRUE(batchVisible == bruteVisible);
+    std::cout << "Line of sight (unknownBlocked=" << unknownBlocked << ", " << numVisible << " of "
+              << pairs.size() << " visible): " << time_los << " s, batch " << timediff(start, stop)
+              << " s, computeRayKeys " << time_ray << " s\n";
+  }
+
+  // same voxel and empty tree:
+  EXPECT_TRUE(tree->isLineOfSight(pairs[0].first, pairs[0].first, true));
+  OcTree emptyTree(0.1);
+  EXPECT_TRUE(emptyTree.isLineOfSight(point3d(0, 0, 0), point3d(1, 2, 3)));
+  EXPECT_FALSE(emptyTree.isLineOfSight(point3d(0, 0, 0), point3d(1, 2, 3), true));
+  emptyTree.updateNode(point3d(0.55f, 0.05f, 0.05f), true);
+  EXPECT_FALSE(emptyTree.isLineOfSight(point3d(0.05f, 0.05f, 0.05f), point3d(1.05f, 0.05f, 0.05f)));
+  EXPECT_TRUE(emptyTree.isLineOfSight(point3d(0.05f, 0.05f, 0.05f), point3d(0.55f, 0.05f, 0.05f)));
+  std::cout << "\n";
+}
+
+/// equality of projected cells, including NaN
+bool sameCells(const std::vector<float>& a, const std::vector<float>& b){
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i){
+    if (a[i] != b[i] && !(a[i] != a[i] && b[i] != b[i]))
+      return false;
+  }
+  return true;
+}
+
+void projectionTest(OcTree* map){
+  double temp_x,temp_y,temp_z;
+  map->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  map->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  OcTree tree(*map);
+  point3d center = (mapMin + mapMax) * 0.5f;
+  OcTreeKey minKey = tree.coordToKey(center - point3d(4.0f, 4.0f, 0.0f));
+  OcTreeKey maxKey = tree.coordToKey(center + point3d(4.0f, 4.0f, 0.0f));
+  minKey[2] = tree.coordToKey(mapMin(2));
+  maxKey[2] = tree.coordToKey(mapMin(2) + 1.5);
+  const unsigned int width = maxKey[0] - minKey[0] + 1;
+  const unsigned int height = maxKey[1] - minKey[1] + 1;
+  const OcTree::ProjectionMode modes[3] = {OcTree::PROJECT_OCCUPANCY, OcTree::PROJECT_MIN_HEIGHT,
+                                           OcTree::PROJECT_MAX_HEIGHT};
+
+  timeval start, stop;
+  tree.enableChangeDetection(true);
+  std::vector<float> grids[3];
+  for (unsigned int m = 0; m < 3; ++m){
+    grids[m].resize(width * height);
+    gettimeofday(&start, NULL);
+    tree.projectTo2D(minKey, maxKey, modes[m], &grids[m][0]);
+    gettimeofday(&stop, NULL);
+    double time_projection = timediff(start, stop);
+
+    // brute force over all voxels of each column:
+    gettimeofday(&start, NULL);
+    std::vector<float> brute(width * height, modes[m] == OcTree::PROJECT_OCCUPANCY ? -1.0f : NAN);
+    for (unsigned y = minKey[1]; y <= maxKey[1]; ++y){
+      for (unsigned x = minKey[0]; x <= maxKey[0]; ++x){
+        float& cell = brute[(y - minKey[1]) * width + (x - minKey[0])];
+        for (unsigned z = minKey[2]; z <= maxKey[2]; ++z){
+          OcTreeNode* node = tree.search(OcTreeKey(x, y, z));
+          if (!node)
+            continue;
+          if (modes[m] == OcTree::PROJECT_OCCUPANCY)
+            cell = std::max(cell, float(node->getOccupancy()));
+          else if (tree.isNodeOccupied(node)){
+            if (modes[m] == OcTree::PROJECT_MIN_HEIGHT && cell != cell)
+              cell = float(tree.keyToCoord(z) - 0.5 * tree.getResolution());
+            else if (modes[m] == OcTree::PROJECT_MAX_HEIGHT)
+              cell = float(tree.keyToCoord(z) + 0.5 * tree.getResolution());
+          }
+        }
+      }
+    }
+    gettimeofday(&stop, NULL);
+    EXPECT_TRUE(sameCells(grids[m], brute));
+    std::cout << "Projection (mode " << m << ", " << width << "x" << height << "): " << time_projection
+              << " s, brute force " << timediff(start, stop) << " s\n";
+  }
+
+  // incremental update:
+  tree.resetChangeDetection();
+  const float z = mapMin(2) + 0.5f;
+  for (float x = -0.5f; x < 0.5f; x += 0.05f){
+    // flip the occupancy of voxels inside and outside of the grid:
+    point3d points[3] = {point3d(center(0) + x, center(1) + 1.0f, z), point3d(center(0) + 1.0f, center(1) + x, z + 0.3f),
+                         point3d(center(0) + x, center(1) + 20.0f, z)};
+    for (unsigned int i = 0; i < 3; ++i){
+      OcTreeNode* node = tree.search(points[i]);
+      bool occupied = node && tree.isNodeOccupied(node);
+      tree.setNodeValue(points[i], occupied ? tree.getClampingThresMinLog() : tree.getClampingThresMaxLog());
+    }
+  }
+  EXPECT_TRUE(tree.numChangesDetected() > 0);
+  bool changed = false;
+  for (unsigned int m = 0; m < 3; ++m){
+    std::vector<float> before = grids[m];
+    gettimeofday(&start, NULL);
+    tree.updateProjection2D(minKey, maxKey, modes[m], &grids[m][0]);
+    gettimeofday(&stop, NULL);
+    std::vector<float> full(width * height);
+    tree.projectTo2D(minKey, maxKey, modes[m], &full[0]);
+    EXPECT_TRUE(sameCells(grids[m], full));
+    changed |= !sameCells(grids[m], before);
+    std::cout << "Incremental projection (mode " << m << ", " << tree.numChangesDetected()
+              << " changes): " << timediff(start, stop) << " s\n";
+  }
+  EXPECT_TRUE(changed);
+
+  // an update which does not flip the occupancy is not a detected change:
+  // (in a column without other known voxels, so that its value is the maximum)
+  size_t unknownCell = 0;
+  while (unknownCell < grids[0].size() && grids[0][unknownCell] != -1.0f)
+    ++unknownCell;
+  EXPECT_TRUE(unknownCell < grids[0].size());
+  const OcTreeKey hit(minKey[0] + unknownCell % width, minKey[1] + unknownCell / width, minKey[2]);
+  tree.setNodeValue(hit, tree.getProbHitLog());
+  for (unsigned int m = 0; m < 3; ++m)
+    tree.projectTo2D(minKey, maxKey, modes[m], &grids[m][0]);
+  tree.resetChangeDetection();
+  tree.updateNode(hit, true);
+  EXPECT_EQ(tree.numChangesDetected(), 0);
+  for (unsigned int m = 0; m < 3; ++m){
+    tree.updateProjection2D(minKey, maxKey, modes[m], &grids[m][0]);
+    std::vector<float> full(width * height);
+    tree.projectTo2D(minKey, maxKey, modes[m], &full[0]);
+    EXPECT_TRUE(sameCells(grids[m], full));
+  }
+  std::cout << "\n";
+}
+
+/// brute force voxel counts between min and max
+void bruteForceCounts(const AggregateOcTree& tree, const OcTreeKey& min, const OcTreeKey& max,
+                      uint64_t& occupied, uint64_t& free, uint64_t& unknown){
+  occupied = free = unknown = 0;
+  for (unsigned x = min[0]; x <= max[0]; ++x){
+    for (unsigned y = min[1]; y <= max[1]; ++y){
+      for (unsigned z = min[2]; z <= max[2]; ++z){
+        AggregateOcTreeNode* node = tree.search(OcTreeKey(x, y, z));
+        if (!node)
+          unknown++;
+        else if (tree.isNodeOccupied(node))
+          occupied++;
+        else
+          free++;
+      }
+    }
+  }
+}
+
+/// compares countInBBX() to brute force on random boxes
+void compareCounts(const AggregateOcTree& tree, unsigned int numBoxes, double& time_count, double& time_brute){
+  double temp_x,temp_y,temp_z;
+  tree.getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  tree.getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+
+  timeval start, stop;
+  for (unsigned int q = 0; q < numBoxes; ++q){
+    point3d center, halfSize;
+    for (unsigned int i = 0; i < 3; ++i){
+      center(i) = mapMin(i) + float(rand()) / float(RAND_MAX) * (mapMax(i) - mapMin(i));
+      halfSize(i) = 0.05f + float(rand()) / float(RAND_MAX) * 0.7f;
+    }
+    uint64_t occupied, free, unknown;
+    gettimeofday(&start, NULL);
+    EXPECT_TRUE(tree.countInBBX(center - halfSize, center + halfSize, occupied, free, unknown));
+    gettimeofday(&stop, NULL);
+    time_count += timediff(start, stop);
+
+    uint64_t bruteOccupied, bruteFree, bruteUnknown;
+    gettimeofday(&start, NULL);
+    bruteForceCounts(tree, tree.coordToKey(center - halfSize), tree.coordToKey(center + halfSize),
+                     bruteOccupied, bruteFree, bruteUnknown);
+    gettimeofday(&stop, NULL);
+    time_brute += timediff(start, stop);
+
+    EXPECT_EQ(occupied, bruteOccupied);
+    EXPECT_EQ(free, bruteFree);
+    EXPECT_EQ(unknown, bruteUnknown);
+  }
+}
+
+void aabbEditTest(OcTree* map){
+  double temp_x,temp_y,temp_z;
+  map->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  map->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+  const point3d center = (mapMin + mapMax) * 0.5f;
+  const OcTreeKey minKey = map->coordToKey(center - point3d(3.03f, 2.47f, 0.71f));
+  const OcTreeKey maxKey = map->coordToKey(center + point3d(1.11f, 2.93f, 0.64f));
+  const int margin = 3;
+
+  timeval start, stop;
+  OcTree deleted(*map);
+  gettimeofday(&start, NULL);
+  deleted.deleteAABB(minKey, maxKey);
+  gettimeofday(&stop, NULL);
+  double time_aabb = timediff(start, stop);
+
+  // per leaf (deletes boundary leafs completely):
+  OcTree deletedLeafs(*map);
+  gettimeofday(&start, NULL);
+  std::vector<std::pair<OcTreeKey, unsigned int> > leafs;
+  for (OcTree::leaf_bbx_iterator it = deletedLeafs.begin_leafs_bbx(minKey, maxKey), end = deletedLeafs.end_leafs_bbx();
+       it != end; ++it)
+    leafs.push_back(std::make_pair(it.getKey(), it.getDepth()));
+  for (size_t i = 0; i < leafs.size(); ++i)
+    deletedLeafs.deleteNode(leafs[i].first, leafs[i].second);
+  gettimeofday(&stop, NULL);
+  std::cout << "deleteAABB: " << time_aabb << " s, per leaf " << timediff(start, stop) << " s\n";
+
+  const float value = deleted.getClampingThresMaxLog();
+  OcTree set(*map);
+  set.setAABB(minKey, maxKey, value + 1.0f); // clamped
+  EXPECT_EQ(deleted.size(), deleted.calcNumNodes());
+  EXPECT_EQ(set.size(), set.calcNumNodes());
+  EXPECT_FALSE(deleted.hasOccupiedInBBX(minKey, maxKey));
+  EXPECT_TRUE(deleted.hasUnknownInBBX(minKey, maxKey));
+  EXPECT_FALSE(set.hasUnknownInBBX(minKey, maxKey));
+
+  OcTreeKey k;
+  for (k[0] = minKey[0] - margin; k[0] <= maxKey[0] + margin; ++k[0]){
+    for (k[1] = minKey[1] - margin; k[1] <= maxKey[1] + margin; ++k[1]){
+      for (k[2] = minKey[2] - margin; k[2] <= maxKey[2] + margin; ++k[2]){
+        const bool inside = k[0] >= minKey[0] && k[0] <= maxKey[0] && k[1] >= minKey[1] && k[1] <= maxKey[1]
+            && k[2] >= minKey[2] && k[2] <= maxKey[2];
+        OcTreeNode* original = map->search(k);
+        OcTreeNode* deletedNode = deleted.search(k);
+        OcTreeNode* setNode = set.search(k);
+        if (inside){
+          EXPECT_FALSE(deletedNode);
+          EXPECT_TRUE(setNode);
+          EXPECT_EQ(setNode->getLogOdds(), value);
+        } else {
+          EXPECT_EQ((deletedNode != NULL), (original != NULL));
+          EXPECT_EQ((setNode != NULL), (original != NULL));
+          if (original){
+            EXPECT_EQ(deletedNode->getLogOdds(), original->getLogOdds());
+            EXPECT_EQ(setNode->getLogOdds(), original->getLogOdds());
+          }
+        }
+      }
+    }
+  }
+
+  // inner nodes are up to date:
+  for (OcTree::tree_iterator it = set.begin_tree(), end = set.end_tree(); it != end; ++it){
+    if (set.nodeHasChildren(&(*it))){
+      float maxChild = -std::numeric_limits<float>::max();
+      bool unknown = false;
+      for (unsigned int i = 0; i < 8; ++i){
+        if (set.nodeChildExists(&(*it), i)){
+          const OcTreeNode* child = set.getNodeChild(&(*it), i);
+          maxChild = std::max(maxChild, child->getLogOdds());
+          unknown |= child->hasUnknown();
+        } else
+          unknown = true;
+      }
+      EXPECT_EQ(maxChild, it->getLogOdds());
+      EXPECT_EQ(unknown, it->hasUnknown());
+    }
+  }
+
+  // everything:
+  deleted.deleteAABB(OcTreeKey(0, 0, 0), OcTreeKey(65535, 65535, 65535));
+  EXPECT_EQ(deleted.size(), 0);
+  EXPECT_FALSE(deleted.getRoot());
+  std::cout << "\n";
+}
+
+void aggregateCountTest(const std::string& filename){
+  AggregateOcTree tree(0.1);
+  EXPECT_TRUE(tree.readBinary(filename));
+  EXPECT_EQ(tree.getTreeType(), "AggregateOcTree");
+  // the counts are stored with the children, not in the nodes:
+  EXPECT_EQ(sizeof(AggregateOcTreeNode), sizeof(OcTreeNode));
+
+  // whole map against all leafs:
+  uint64_t leafOccupied = 0, leafFree = 0;
+  for(AggregateOcTree::leaf_iterator it = tree.begin_leafs(), end=tree.end_leafs(); it!= end; ++it){
+    uint64_t voxels = uint64_t(1) << (3 * (tree.getTreeDepth() - it.getDepth()));
+    if (tree.isNodeOccupied(*it))
+      leafOccupied += voxels;
+    else
+      leafFree += voxels;
+  }
+  uint64_t occupied, free, unknown;
+  OcTreeKey minKey(0, 0, 0), maxKey(65535, 65535, 65535);
+  tree.countInBBX(minKey, maxKey, occupied, free, unknown);
+  EXPECT_EQ(occupied, leafOccupied);
+  EXPECT_EQ(free, leafFree);
+  EXPECT_EQ(occupied + free + unknown, uint64_t(1) << 48);
+
+  srand(42);
+  double time_count = 0.0, time_brute = 0.0;
+  compareCounts(tree, 50, time_count, time_brute);
+  std::cout << "Voxel counts in BBX: " << time_count << " s, brute force " << time_brute << " s\n";
+
+  // incremental updates, including pruning and expansion:
+  for (float x = -2.0f; x < 2.0f; x += 0.1f){
+    for (float y = -2.0f; y < 2.0f; y += 0.1f){
+      tree.updateNode(point3d(x, y, 0.05f), true);
+      tree.updateNode(point3d(x, y, 0.15f), false);
+    }
+  }
+  tree.setNodeValue(point3d(0.55f, 0.55f, 0.05f), tree.getClampingThresMinLog());
+  tree.deleteNode(point3d(0.25f, 0.35f, 0.15f));
+  tree.deleteNode(point3d(1.0f, 1.0f, 1.0f), 12);
+  compareCounts(tree, 50, time_count, time_brute);
+  // through pointers to the base classes:
+  OccupancyOcTreeBase<AggregateOcTreeNode>* baseTree = &tree;
+  baseTree->deleteNode(point3d(-0.55f, 0.25f, 0.05f));
+  baseTree->deleteNode(tree.coordToKey(point3d(0.35f, -0.25f, 0.15f)));
+  baseTree->updateInnerOccupancy();
+  compareCounts(tree, 50, time_count, time_brute);
+  tree.deleteAABB(point3d(-1.0f, -0.5f, 0.0f), point3d(0.3f, 0.4f, 0.1f));
+  tree.setAABB(point3d(-0.2f, -2.5f, -0.3f), point3d(1.5f, -0.5f, 0.1f), tree.getClampingThresMaxLog());
+  compareCounts(tree, 50, time_count, time_brute);
+
+  // lazy updates are counted by updateInnerOccupancy():
+  for (float x = -2.0f; x < 2.0f; x += 0.1f)
+    tree.updateNode(point3d(x, 0.05f, 0.25f), true, true);
+  tree.updateInnerOccupancy();
+  compareCounts(tree, 50, time_count, time_brute);
+
+  // copies and I/O keep the counts:
+  AggregateOcTree copy(tree);
+  compareCounts(copy, 20, time_count, time_brute);
+  std::stringstream stream;
+  tree.write(stream);
+  AggregateOcTree* readTree = dynamic_cast<AggregateOcTree*>(AbstractOcTree::read(stream));
+  EXPECT_TRUE(readTree);
+  compareCounts(*readTree, 20, time_count, time_brute);
+  delete readTree;
+
+  // subtrees read back from the page file get their counts again:
+  AggregateOcTree pagedTree(tree);
+  EXPECT_TRUE(pagedTree.enablePaging("aggregate_test.pages", 8));
+  pagedTree.setPagingMemoryBudget(1);
+  EXPECT_TRUE(pagedTree.updatePaging() > 0);
+  compareCounts(pagedTree, 20, time_count, time_brute);
+  pagedTree.disablePaging();
+
+  // collapsed inner nodes of a LOD get counts of their own level:
+  AggregateOcTree lodTree(tree.getResolution());
+  tree.extractLOD(tree.getTreeDepth() - 3, lodTree);
+  EXPECT_TRUE(lodTree.size() < tree.size());
+  compareCounts(lodTree, 20, time_count, time_brute);
+  AggregateOcTree focusLodTree(tree.getResolution());
+  tree.extractLOD(point3d(0.0f, 0.0f, 0.0f), 0.5, 10, focusLodTree);
+  compareCounts(focusLodTree, 20, time_count, time_brute);
+  AggregateOcTree checkered(0.1), checkeredLod(0.1);
+  for (key_type x = 1000; x < 1008; ++x)
+    for (key_type y = 1000; y < 1008; ++y)
+      for (key_type z = 1000; z < 1008; ++z)
+        checkered.setNodeValue(OcTreeKey(x, y, z), ((x + y + z) % 2) ? 2.0f : -2.0f);
+  checkered.extractLOD(checkered.getTreeDepth() - 1, checkeredLod);
+  checkeredLod.countInBBX(OcTreeKey(1000, 1000, 1000), OcTreeKey(1007, 1007, 1007), occupied, free, unknown);
+  EXPECT_EQ(occupied, 512);
+  EXPECT_EQ(free + unknown, 0);
+
+  tree.expand();
+  compareCounts(tree, 20, time_count, time_brute);
+
+  // empty tree:
+  AggregateOcTree emptyTree(0.1);
+  emptyTree.countInBBX(OcTreeKey(10, 10, 10), OcTreeKey(19, 19, 19), occupied, free, unknown);
+  EXPECT_EQ(occupied + free, 0);
+  EXPECT_EQ(unknown, 1000);
+  std::cout << "\n";
+}
+
+void lodTest(OcTree* map){
+  timeval start, stop;
+  OcTree lod(0.1);
+  const unsigned int depth = 12;
+  gettimeofday(&start, NULL);
+  map->extractLOD(depth, lod);
+  gettimeofday(&stop, NULL);
+  std::cout << "LOD extraction (depth " << depth << "): " << timediff(start, stop) << " s, "
+            << map->size() << " -> " << lod.size() << " nodes\n";
+  EXPECT_EQ(lod.getResolution(), map->getResolution());
+  EXPECT_EQ(lod.size(), lod.calcNumNodes());
+  EXPECT_TRUE(lod.size() < map->size());
+
+  // the leafs of the LOD are the nodes at depth of the map:
+  size_t num_leafs = 0;
+  for (OcTree::leaf_iterator it = map->begin_leafs(depth), end = map->end_leafs(); it != end; ++it){
+    OcTreeNode* node = lod.search(it.getKey(), it.getDepth());
+    EXPECT_TRUE(node);
+    EXPECT_FALSE(lod.nodeHasChildren(node));
+    EXPECT_EQ(node->getLogOdds(), it->getLogOdds());
+    ++num_leafs;
+  }
+  EXPECT_EQ(num_leafs, lod.getNumLeafNodes());
+
+  // full depth: plain copy
+  map->extractLOD(0, lod);
+  EXPECT_TRUE(lod == *map);
+
+  // variable LOD around the center of the map:
+  double temp_x,temp_y,temp_z;
+  map->getMetricMin(temp_x,temp_y,temp_z);
+  point3d mapMin = point3d(float(temp_x), float(temp_y), float(temp_z));
+  map->getMetricMax(temp_x,temp_y,temp_z);
+  point3d mapMax = point3d(float(temp_x), float(temp_y), float(temp_z));
+  const point3d focus = (mapMin + mapMax) * 0.5f;
+  const double radius = 1.0;
+  const unsigned int min_depth = 10;
+  gettimeofday(&start, NULL);
+  map->extractLOD(focus, radius, min_depth, lod);
+  gettimeofday(&stop, NULL);
+  std::cout << "LOD extraction (focus, radius " << radius << "): " << timediff(start, stop) << " s, "
+            << map->size() << " -> " << lod.size() << " nodes\n";
+  EXPECT_EQ(lod.size(), lod.calcNumNodes());
+  EXPECT_TRUE(lod.size() < map->size());
+
+  size_t num_full = 0;
+  for (OcTree::leaf_iterator it = lod.begin_leafs(), end = lod.end_leafs(); it != end; ++it){
+    OcTreeNode* node = map->search(it.getKey(), it.getDepth());
+    EXPECT_TRUE(node);
+    EXPECT_EQ(node->getLogOdds(), it->getLogOdds());
+    if (!map->nodeHasChildren(node)){
+      ++num_full;
+      continue;
+    }
+    // collapsed leafs: coarser than min_depth never, and not close to the focus
+    EXPECT_TRUE(it.getDepth() >= min_depth);
+    const double half_size = 0.5 * it.getSize();
+    double sqr_dist = 0.0;
+    for (unsigned int i = 0; i < 3; ++i){
+      double d = fabs(focus(i) - it.getCoordinate()(i)) - half_size;
+      if (d > 0.0)
+        sqr_dist += d*d;
+    }
+    EXPECT_TRUE(sqr_dist > radius*radius);
+  }
+  EXPECT_TRUE(num_full > 0);
+  std::cout << "\n";
+}
+
+void pagingTest(OcTree* map){
+  std::cout << "Testing out-of-core paging\n";
+  OcTree paged(*map);
+  const size_t full_size = paged.size();
+  const size_t full_leafs = paged.getNumLeafNodes();
+  EXPECT_FALSE(paged.enablePaging("paging_test.pages", 0));
+  EXPECT_TRUE(paged.enablePaging("paging_test.pages", 8));
+  EXPECT_TRUE(paged.isPagingEnabled());
+
+  // a tiny budget pages out all subtrees:
+  paged.setPagingMemoryBudget(1);
+  const size_t num_paged = paged.updatePaging();
+  EXPECT_TRUE(num_paged > 0);
+  EXPECT_EQ(paged.getNumPagedSubtrees(), num_paged);
+  // the paged out nodes are counted, but do not use memory:
+  EXPECT_EQ(paged.size(), full_size);
+  EXPECT_EQ(paged.size(), paged.calcNumNodes());
+  EXPECT_EQ(paged.getNumLeafNodes(), full_leafs);
+  EXPECT_TRUE(paged.memoryUsage() < map->memoryUsage());
+
+  // searches read the subtrees back, summary flags included:
+  size_t leaf_count = 0;
+  for (OcTree::leaf_iterator it = map->begin_leafs(), end = map->end_leafs(); it != end; ++it, ++leaf_count){
+    if (leaf_count % 10000 != 0)
+      continue;
+    OcTreeNode* node = paged.search(it.getKey(), it.getDepth());
+    EXPECT_TRUE(node);
+    EXPECT_EQ(node->getLogOdds(), it->getLogOdds());
+    EXPECT_FALSE(paged.nodeHasChildren(node));
+  }
+  EXPECT_TRUE(paged.getNumPagedSubtrees() < num_paged);
+  EXPECT_TRUE(paged.getNumPagedSubtrees() > 0);
+  for (OcTree::tree_iterator it = map->begin_tree(8), end = map->end_tree(); it != end; ++it){
+    if (it.getDepth() == 8)
+      EXPECT_EQ(paged.search(it.getKey(), 8)->hasUnknown(), it->hasUnknown());
+  }
+
+  // subtrees not accessed in the last period are paged out again, updates read them back:
+  paged.setPagingMemoryBudget(0);
+  paged.setPagingMaxIdle(1);
+  paged.updatePaging();
+  paged.updatePaging();
+  EXPECT_EQ(paged.getNumPagedSubtrees(), num_paged);
+  OcTree expected(*map);
+  const point3d p = map->begin_leafs().getCoordinate();
+  expected.updateNode(p, false);
+  paged.updateNode(p, false);
+  EXPECT_EQ(paged.getNumPagedSubtrees(), num_paged - 1);
+
+  // iterators and comparisons read everything back:
+  leaf_count = 0;
+  for (OcTree::leaf_iterator it = paged.begin_leafs(), end = paged.end_leafs(); it != end; ++it)
+    ++leaf_count;
+  EXPECT_EQ(leaf_count, expected.getNumLeafNodes());
+  EXPECT_EQ(paged.getNumPagedSubtrees(), 0);
+  paged.updatePaging();
+  paged.updatePaging();
+  EXPECT_TRUE(paged.getNumPagedSubtrees() > 0);
+  EXPECT_TRUE(paged == expected);
+
+  // file output and copies read the paged out subtrees only temporarily:
+  expected.enableChangeDetection(true);
+  paged.enableChangeDetection(true);
+  OcTree::leaf_iterator changed_it = map->begin_leafs();
+  for (unsigned int i = 0; i < 1000; ++i)
+    ++changed_it;
+  const point3d changed = changed_it.getCoordinate();
+  expected.updateNode(changed, true);
+  paged.updateNode(changed, true);
+  std::stringstream expected_binary, expected_ot, expected_bulk, expected_compressed, expected_delta;
+  EXPECT_TRUE(expected.writeBinaryConst(expected_binary));
+  EXPECT_TRUE(expected.write(expected_ot));
+  EXPECT_TRUE(expected.writeBulk(expected_bulk));
+  EXPECT_TRUE(expected.writeBinaryCompressedConst(expected_compressed));
+  EXPECT_TRUE(expected.writeBinaryDelta(expected_delta));
+  EXPECT_TRUE(expected.writeBinaryChunkedConst("paging_expected.cbt", 10));
+  paged.updatePaging();
+  paged.updatePaging();
+  const size_t num_paged_out = paged.getNumPagedSubtrees();
+  EXPECT_TRUE(num_paged_out > 0);
+  std::stringstream binary, ot, bulk, compressed, delta;
+  EXPECT_TRUE(paged.writeBinaryConst(binary));
+  EXPECT_TRUE(binary.str() == expected_binary.str());
+  EXPECT_TRUE(paged.write(ot));
+  EXPECT_TRUE(ot.str() == expected_ot.str());
+  EXPECT_TRUE(paged.writeBulk(bulk));
+  EXPECT_TRUE(bulk.str() == expected_bulk.str());
+  EXPECT_TRUE(paged.writeBinaryCompressedConst(compressed));
+  EXPECT_TRUE(compressed.str() == expected_compressed.str());
+  EXPECT_TRUE(paged.writeBinaryDelta(delta));
+  EXPECT_TRUE(delta.str() == expected_delta.str());
+  EXPECT_TRUE(paged.writeBinaryChunkedConst("paging_test.cbt", 10));
+  std::ifstream expected_chunked("paging_expected.cbt", std::ios_base::binary);
+  std::ifstream chunked("paging_test.cbt", std::ios_base::binary);
+  std::stringstream expected_chunked_data, chunked_data;
+  expected_chunked_data << expected_chunked.rdbuf();
+  chunked_data << chunked.rdbuf();
+  EXPECT_TRUE(chunked_data.str() == expected_chunked_data.str());
+  OcTree copy(paged);
+  EXPECT_EQ(paged.getNumPagedSubtrees(), num_paged_out);
+  EXPECT_EQ(copy.getNumPagedSubtrees(), 0);
+  EXPECT_EQ(copy.size(), expected.size());
+  EXPECT_TRUE(copy == expected);
+  OcTree read_binary(0.1);
+  EXPECT_TRUE(read_binary.readBinary(binary));
+  AbstractOcTree* read_tree = AbstractOcTree::read(ot);
+  EXPECT_TRUE(read_tree);
+  EXPECT_TRUE(expected == *dynamic_cast<OcTree*>(read_tree));
+  delete read_tree;
+
+  // parallel batch queries wait for subtrees read back by other threads:
+  paged.updatePaging();
+  paged.updatePaging();
+  EXPECT_TRUE(paged.getNumPagedSubtrees() > 0);
+  double x, y, z;
+  expected.getMetricMin(x, y, z);
+  const point3d map_min((float) x, (float) y, (float) z);
+  expected.getMetricMax(x, y, z);
+  const point3d map_max((float) x, (float) y, (float) z);
+  std::vector<std::pair<point3d, point3d> > pairs;
+  srand(42);
+  for (unsigned int q = 0; q < 500; ++q){
+    point3d a, b;
+    for (unsigned int i = 0; i < 3; ++i){
+      a(i) = map_min(i) + float(rand()) / float(RAND_MAX) * (map_max(i) - map_min(i));
+      b(i) = map_min(i) + float(rand()) / float(RAND_MAX) * (map_max(i) - map_min(i));
+    }
+    pairs.push_back(std::make_pair(a, b));
+  }
+  std::vector<bool> visible, expected_visible;
+  expected.isLineOfSight(pairs, expected_visible);
+  paged.isLineOfSight(pairs, visible);
+  EXPECT_TRUE(visible == expected_visible);
+
+  paged.disablePaging();
+  EXPECT_FALSE(paged.isPagingEnabled());
+  EXPECT_EQ(paged.size(), expected.size());
+  std::cout << "\n";
+}
+
+void stampedPagingTest(OcTree* map){
+  std::cout << "Testing out-of-core paging of OcTreeStamped\n";
+  OcTreeStamped stamped(map->getResolution());
+  for (OcTree::leaf_iterator it = map->begin_leafs(), end = map->end_leafs(); it != end; ++it)
+    stamped.setNodeValue(it.getKey(), it->getLogOdds());
+  unsigned int timestamp = 1000;
+  for (OcTreeStamped::tree_iterator it = stamped.begin_tree(), end = stamped.end_tree(); it != end; ++it)
+    it->setTimestamp(timestamp++);
+  const OcTreeStamped expected(stamped);
+
+  EXPECT_TRUE(stamped.enablePaging("stamped_test.pages", 8));
+  stamped.setPagingMemoryBudget(1);
+  const size_t num_paged = stamped.updatePaging();
+  EXPECT_TRUE(num_paged > 0);
+  EXPECT_EQ(stamped.size(), expected.size());
+
+  // the timestamps are paged out as well (compared by the node ==):
+  const OcTreeStamped copy(stamped);
+  EXPECT_EQ(stamped.getNumPagedSubtrees(), num_paged);
+  EXPECT_TRUE(copy == expected);
+  EXPECT_TRUE(stamped == expected);
+  EXPECT_EQ(stamped.getNumPagedSubtrees(), 0);
+  stamped.disablePaging();
+  std::cout << "\n";
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2 || strcmp(argv[1], "-h") == 0){
+    printUsage(argv[0]);
+  }
+
+  OcTree* tree = new OcTree(std::string(argv[1]));
+  EXPECT_TRUE(tree->size() > 0);
+
+  nearestNeighborTest(tree);
+  surfaceMeshTest(tree);
+  regionPredicateTest(tree);
+  collisionTest(tree);
+  lineOfSightTest(tree);
+  projectionTest(tree);
+  lodTest(tree);
+  aabbEditTest(tree);
+  aggregateCountTest(std::string(argv[1]));
+  pagingTest(tree);
+  stampedPagingTest(tree);
+
+  delete tree;
+  std::cout << "Tests successful\n";
+  return 0;
+}
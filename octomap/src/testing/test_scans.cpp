@@ -46,21 +46,6 @@ int main(int argc, char** argv) {
   ScanGraph graph;
   graph.addNode(cloud, origin); // graph assumes ownership of cloud!
   
-  {
-    std::cout << "Comparing ScanGraph with reference file at " << filename << std::endl;
-    EXPECT_TRUE(graph.size() == referenceGraph.size());
-    ScanNode* scanNode = *graph.begin();
-    ScanNode* refScanNode = *referenceGraph.begin();
-    
-    EXPECT_EQ(scanNode->id, refScanNode->id);
-    EXPECT_EQ(scanNode->pose, refScanNode->pose);
-    EXPECT_EQ(scanNode->scan->size(), refScanNode->scan->size());
-
-    for (size_t i = 0; i < scanNode->scan->size(); ++i){
-      EXPECT_EQ((*scanNode->scan)[i], (*refScanNode->scan)[i]);
-    }  
-    
-  }
   // test reading and writing to file
   {
     std::cout << "Testing ScanGraph I/O" << std::endl;
@@ -84,8 +69,79 @@ int main(int argc, char** argv) {
       EXPECT_EQ((*scanNode->scan)[i], (*readScanNode->scan)[i]);
     }
   }
-  
-  
+  // test lazy reading from the mapped file
+  {
+    std::cout << "Testing lazy ScanGraph reading" << std::endl;
+
+    ScanGraph lazyGraph;
+    EXPECT_TRUE(lazyGraph.readBinary("spherical_scan_out.graph", true));
+    EXPECT_EQ(lazyGraph.size(), 1);
+
+    ScanNode* scanNode = *graph.begin();
+    ScanNode* lazyScanNode = *lazyGraph.begin();
+    EXPECT_EQ(scanNode->pose, lazyScanNode->pose);
+    EXPECT_FALSE(lazyScanNode->isScanLoaded());
+    EXPECT_EQ(lazyScanNode->getNumPoints(), scanNode->scan->size());
+    EXPECT_EQ(lazyGraph.getNumPoints(), graph.getNumPoints());
+
+    Pointcloud* lazyScan = lazyScanNode->getScan();
+    EXPECT_TRUE(lazyScan);
+    EXPECT_TRUE(lazyScanNode->isScanLoaded());
+    EXPECT_EQ(lazyScan->size(), scanNode->scan->size());
+    for (size_t i = 0; i < scanNode->scan->size(); ++i){
+      EXPECT_EQ((*scanNode->scan)[i], (*lazyScan)[i]);
+    }
+    lazyScanNode->unloadScan();
+    EXPECT_FALSE(lazyScanNode->isScanLoaded());
+    EXPECT_EQ(lazyScanNode->getScan()->size(), scanNode->scan->size());
+
+    // inserting an unloaded node loads its scan
+    lazyScanNode->unloadScan();
+    OcTree lazyTree (0.05);
+    lazyTree.insertPointCloud(*lazyScanNode);
+    EXPECT_TRUE(lazyScanNode->isScanLoaded());
+    OcTree tree (0.05);
+    tree.insertPointCloud(*scanNode);
+    EXPECT_TRUE(tree.size() > 0);
+    EXPECT_TRUE(lazyTree == tree);
+  }
+  // test streaming with and without prefetching
+  for (unsigned int window = 0; window < 3; ++window){
+    std::cout << "Testing ScanGraphReader with window " << window << std::endl;
+
+    ScanGraphReader reader;
+    EXPECT_TRUE(reader.open("spherical_scan_out.graph", window));
+    EXPECT_EQ(reader.size(), graph.size());
+    EXPECT_EQ(reader.getNumPoints(), graph.getNumPoints());
+    for (int pass = 0; pass < 2; ++pass){
+      ScanNode* node = reader.next();
+      EXPECT_TRUE(node);
+      EXPECT_EQ(node->pose, (*graph.begin())->pose);
+      EXPECT_EQ(node->getScan()->size(), cloud->size());
+      EXPECT_EQ((*node->getScan())[0], (*cloud)[0]);
+      EXPECT_FALSE(reader.next());
+      EXPECT_FALSE(node->isScanLoaded());
+      reader.rewind();
+    }
+  }
+
+  // compare with the reference file
+  {
+    std::cout << "Comparing ScanGraph with reference file at " << filename << std::endl;
+    EXPECT_TRUE(graph.size() == referenceGraph.size());
+    ScanNode* scanNode = *graph.begin();
+    ScanNode* refScanNode = *referenceGraph.begin();
+    
+    EXPECT_EQ(scanNode->id, refScanNode->id);
+    EXPECT_EQ(scanNode->pose, refScanNode->pose);
+    EXPECT_EQ(scanNode->scan->size(), refScanNode->scan->size());
+
+    for (size_t i = 0; i < scanNode->scan->size(); ++i){
+      EXPECT_EQ((*scanNode->scan)[i], (*refScanNode->scan)[i]);
+    }  
+    
+  }
+
   // insert into OcTree  
   {
     OcTree tree (0.05);  
@@ -9,6 +9,7 @@
 
 #include <octomap/octomap.h>
 #include <octomap/OcTreeStamped.h>
+#include <octomap/FrontierTracker.h>
 #include <octomap/math/Utils.h>
 #include "testing.h"
  
@@ -155,6 +156,12 @@ int main(int argc, char** argv) {
   // ------------------------------------------------------------
 
   } else if (test_name == "StampedTree") {
+    // the timestamp shares the padding after the occupancy with the summary flags:
+    EXPECT_EQ(sizeof(OcTreeNodeStamped), sizeof(OcTreeNode));
+    OcTreeNodeStamped node;
+    node.setTimestamp(1234567890);
+    EXPECT_FALSE(node.hasUnknown());
+    EXPECT_EQ(node.getTimestamp(), 1234567890);
     OcTreeStamped stamped_tree (0.05);
     // fill tree
     for (int x=-20; x<20; x++) 
@@ -200,6 +207,51 @@ int main(int argc, char** argv) {
     EXPECT_FLOAT_EQ (0.025, p_inv.y());
     EXPECT_FLOAT_EQ (0.025, p_inv.z());
 
+  // ------------------------------------------------------------
+  } else if (test_name == "FrontierTracker") {
+    for (unsigned int neighborhood = 0; neighborhood < 2; ++neighborhood){
+      OcTree tree (0.1);
+      FrontierTracker<OcTree> tracker(&tree, neighborhood == 1);
+      EXPECT_TRUE (tree.isChangeDetectionEnabled());
+      tracker.rebuild();
+      EXPECT_EQ (tracker.size(), 0);
+
+      srand(0);
+      for (unsigned int scan = 0; scan < 5; ++scan){
+        // random rays, the ones beyond maxrange only clear space
+        point3d origin(0.5f * float(scan), 0.0f, 0.5f);
+        Pointcloud cloud;
+        for (unsigned int i = 0; i < 500; ++i){
+          point3d dir(float(rand()) / float(RAND_MAX) - 0.5f, float(rand()) / float(RAND_MAX) - 0.5f,
+                      0.2f * (float(rand()) / float(RAND_MAX) - 0.5f));
+          cloud.push_back(origin + dir.normalized() * (0.5 + 2.0 * double(rand()) / double(RAND_MAX)));
+        }
+        tree.insertPointCloud(cloud, origin, 1.5);
+        tracker.update();
+        EXPECT_EQ (tree.numChangesDetected(), 0);
+
+        FrontierTracker<OcTree> reference(&tree, neighborhood == 1);
+        reference.rebuild();
+        EXPECT_TRUE (tracker.size() > 0);
+        EXPECT_EQ (tracker.size(), reference.size());
+        for (KeySet::const_iterator it = reference.getFrontiers().begin(); it != reference.getFrontiers().end(); ++it){
+          EXPECT_TRUE (tracker.isFrontier(*it));
+          OcTreeNode* node = tree.search(*it);
+          EXPECT_TRUE (node);
+          EXPECT_FALSE (tree.isNodeOccupied(node));
+        }
+      }
+
+      std::vector<std::vector<OcTreeKey> > clusters;
+      tracker.getClusters(clusters);
+      size_t numClustered = 0;
+      for (size_t i = 0; i < clusters.size(); ++i)
+        numClustered += clusters[i].size();
+      EXPECT_EQ (numClustered, tracker.size());
+      std::cout << "Frontier (" << (neighborhood == 1 ? 26 : 6) << "-neighborhood): " << tracker.size()
+                << " voxels in " << clusters.size() << " clusters\n";
+    }
+
   // ------------------------------------------------------------
   } else {
     std::cerr << "Invalid test name specified: " << test_name << std::endl;
@@ -48,14 +48,14 @@ namespace octomap {
 
     // count points first:
     for (octomap::ScanGraph::const_iterator it = graph.begin(); it != graph.end(); it++) {
-      m_numberPoints += (*it)->scan->size();
+      m_numberPoints += (*it)->getNumPoints();
     }
 
     m_pointsArray = new GLfloat[3*m_numberPoints];
 
     unsigned i = 0;
     for (octomap::ScanGraph::const_iterator graph_it = graph.begin(); graph_it != graph.end(); graph_it++) {
-      octomap::Pointcloud* scan = new Pointcloud((*graph_it)->scan);
+      octomap::Pointcloud* scan = new Pointcloud((*graph_it)->getScan());
       scan->transformAbsolute((*graph_it)->pose);
 
       for (Pointcloud::iterator pc_it = scan->begin(); pc_it != scan->end(); ++pc_it){
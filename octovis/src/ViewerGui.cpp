@@ -323,7 +323,7 @@ void ViewerGui::generateOctree() {
     for (it = m_scanGraph->begin(); it != m_nextScanToAdd; it++) {
       tree->insertPointCloud(**it, m_laserMaxRange);
       fprintf(stderr, "generateOctree:: inserting scan node with %d points, origin: %.2f  ,%.2f , %.2f.\n",
-              (unsigned int) (*it)->scan->size(), (*it)->pose.x(), (*it)->pose.y(), (*it)->pose.z()  );
+              (unsigned int) (*it)->getNumPoints(), (*it)->pose.x(), (*it)->pose.y(), (*it)->pose.z()  );
 
       std::cout << " S ("<<currentScan<<"/"<<numScans<<") " << std::flush;
       currentScan++;
@@ -811,10 +811,7 @@ void ViewerGui::on_actionDelete_nodes_in_selection_triggered(){
     OcTree* octree = dynamic_cast<OcTree*>(t_it->second.octree);
 
     if (octree){
-      for(OcTree::leaf_bbx_iterator it = octree->begin_leafs_bbx(min,max),
-          end=octree->end_leafs_bbx(); it!= end; ++it){
-        octree->deleteNode(it.getKey(), it.getDepth());
-      }
+      octree->deleteAABB(min, max);
     } else{
       QMessageBox::warning(this, "Not implemented", "Functionality not yet implemented for this octree type",
                            QMessageBox::Ok);